@@ -0,0 +1,105 @@
+// Per-frame cost of the RX path's parsing work, replayed over a capture:
+//
+//     bench_wifi_frame capture.pcapng [passes]
+//
+// Each workload walks every frame of the capture `passes` times and
+// reports the mean ns/frame. Any pcap or pcapng with 802.11 or radiotap
+// frames works, including captures pulled off the device.
+#include "wifi_frame.h"
+#include "capture_filter.h"
+#include "pcap_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_PASSES  20000
+
+typedef uint32_t (*workload_fn_t)(const wifi_promiscuous_pkt_t* pkt);
+
+typedef struct {
+    const char* name;
+    workload_fn_t run;
+} workload_t;
+
+static capture_filter_t beacon_filter;
+static capture_filter_t eapol_filter;
+
+static uint32_t run_parse(const wifi_promiscuous_pkt_t* pkt) {
+    wifi_frame_t f;
+    return wifi_frame_from_pkt(&f, pkt) ? f.hdr_len : 0;
+}
+
+// What a beacon/probe handler does with each frame
+static uint32_t run_ssid_channel(const wifi_promiscuous_pkt_t* pkt) {
+    wifi_frame_t f;
+    char ssid[33];
+    if (!wifi_frame_from_pkt(&f, pkt) || f.type != WIFI_FRAME_TYPE_MGMT) return 0;
+    return wifi_frame_ssid(&f, ssid) + wifi_frame_ds_channel(&f);
+}
+
+static uint32_t run_bssid_eapol(const wifi_promiscuous_pkt_t* pkt) {
+    wifi_frame_t f;
+    if (!wifi_frame_from_pkt(&f, pkt)) return 0;
+    const uint8_t* bssid = wifi_frame_bssid(&f);
+    return (bssid ? bssid[5] : 0) + wifi_frame_is_eapol(&f);
+}
+
+static uint32_t run_beacon_filter(const wifi_promiscuous_pkt_t* pkt) {
+    return capture_filter_match(&beacon_filter, pkt);
+}
+
+static uint32_t run_eapol_filter(const wifi_promiscuous_pkt_t* pkt) {
+    return capture_filter_match(&eapol_filter, pkt);
+}
+
+static const workload_t workloads[] = {
+    {"wifi_frame_from_pkt", run_parse},
+    {"ssid + ds_channel", run_ssid_channel},
+    {"bssid + is_eapol", run_bssid_eapol},
+    {"filter: beacon addr2 oui", run_beacon_filter},
+    {"filter: eapol", run_eapol_filter},
+};
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    pcap_frames_t frames;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s capture.pcapng [passes]\n", argv[0]);
+        return 1;
+    }
+    long passes = argc > 2 ? strtol(argv[2], NULL, 0) : DEFAULT_PASSES;
+    if (passes <= 0 || !pcap_load(argv[1], &frames) || frames.count == 0) {
+        fprintf(stderr, "nothing to replay\n");
+        return 1;
+    }
+    if (capture_filter_compile(&beacon_filter, "mgmt subtype beacon and addr2 oui b4:1e:52") != ESP_OK ||
+        capture_filter_compile(&eapol_filter, "eapol") != ESP_OK) {
+        return 1;
+    }
+
+    printf("%zu frames x %ld passes\n", frames.count, passes);
+    volatile uint32_t sink = 0;
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        uint32_t acc = 0;
+        int64_t start = now_ns();
+        for (long p = 0; p < passes; p++) {
+            for (size_t i = 0; i < frames.count; i++) {
+                acc += workloads[w].run(frames.pkts[i]);
+            }
+        }
+        int64_t elapsed = now_ns() - start;
+        sink += acc;
+        printf("%-26s %8.1f ns/frame\n", workloads[w].name,
+               (double)elapsed / ((double)passes * frames.count));
+    }
+    (void)sink;
+
+    pcap_free(&frames);
+    return 0;
+}
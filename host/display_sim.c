@@ -0,0 +1,193 @@
+// Replays real screens through display.c against the fake panel, reports
+// bus cost per frame and writes a PPM screenshot of each. Fails if the panel
+// saw a protocol error, if display.c's counters disagree with what reached
+// the bus, or if redrawing a static screen changes the image.
+#include "fake_panel.h"
+#include "display.h"
+#include "touchscreen.h"
+#include "menu.h"
+#include "device_table.h"
+#include "signal_analyzer.h"
+#include "signal_visualizer.h"
+#include "wifi_functions.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_AP_COUNT    20
+
+typedef struct {
+    const char* name;
+    void (*draw)(void);
+    bool deterministic;     // redraws must produce the same image
+} sim_scene_t;
+
+static wifi_ap_record_t sim_aps[SIM_AP_COUNT];
+static uint16_t first_frame[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+static void scene_menu(void) {
+    menu_draw();
+}
+
+// The scanner screen loops until BACK is pressed; the tap lands on its
+// first poll, after the list has been drawn
+static void scene_wifi_list(void) {
+    fake_panel_touch(185, 277, 200);
+    wifi_scan_start();
+}
+
+static void scene_wifi_heatmap(void) {
+    display_fill_screen(COLOR_BLACK);
+    draw_wifi_heatmap(sim_aps, SIM_AP_COUNT);
+}
+
+static void scene_signal_heatmap(void) {
+    signal_analyzer_heatmap();
+}
+
+static const sim_scene_t scenes[] = {
+    {"menu_draw", scene_menu, true},
+    {"wifi_scan_list", scene_wifi_list, true},
+    {"wifi_heatmap", scene_wifi_heatmap, true},
+    {"signal_heatmap", scene_signal_heatmap, false},
+};
+
+#define SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+// Same fake scan as the on-device bench, also merged into the device table
+// for the screens that read it
+static void seed_aps(void) {
+    for (int i = 0; i < SIM_AP_COUNT; i++) {
+        wifi_ap_record_t* ap = &sim_aps[i];
+        memset(ap, 0, sizeof(*ap));
+        snprintf((char*)ap->ssid, sizeof(ap->ssid), "BENCH_AP_%02d", i);
+        ap->bssid[0] = 0x02;
+        ap->bssid[5] = i;
+        ap->primary = 1 + (i * 5) % 13;
+        ap->rssi = -35 - (i * 3);
+        ap->authmode = WIFI_AUTH_WPA2_PSK;
+
+        device_sighting_t sighting = {
+            .kind = DEVICE_KIND_WIFI_AP,
+            .mac = ap->bssid,
+            .rssi = ap->rssi,
+            .channel = ap->primary,
+            .name = (const char*)ap->ssid,
+            .authmode = ap->authmode
+        };
+        device_table_update(&sighting, NULL);
+    }
+}
+
+static bool frame_has_content(void) {
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (fake_panel_pixel(x, y) != COLOR_BLACK) return true;
+        }
+    }
+    return false;
+}
+
+static void save_frame(uint16_t out[DISPLAY_HEIGHT][DISPLAY_WIDTH]) {
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            out[y][x] = fake_panel_pixel(x, y);
+        }
+    }
+}
+
+static int frame_diff(uint16_t ref[DISPLAY_HEIGHT][DISPLAY_WIDTH]) {
+    int diff = 0;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (ref[y][x] != fake_panel_pixel(x, y)) diff++;
+        }
+    }
+    return diff;
+}
+
+// Draws one frame and checks the two sets of counters against each other
+static bool run_frame(const sim_scene_t* scene, display_stats_t* out) {
+    fake_panel_stats_t bus;
+
+    display_wait_idle();
+    display_reset_stats();
+    fake_panel_reset_stats();
+
+    scene->draw();
+    display_flush();
+    display_wait_idle();
+
+    display_get_stats(out);
+    fake_panel_get_stats(&bus);
+    if (bus.errors) {
+        fprintf(stderr, "%s: %u panel errors, last: %s\n", scene->name,
+                (unsigned)bus.errors, fake_panel_last_error());
+        return false;
+    }
+    if (bus.transactions != out->transactions || bus.bytes != out->bytes ||
+        bus.windows != out->windows) {
+        fprintf(stderr, "%s: display counted %u tx %u B %u win, bus saw %u tx %u B %u win\n",
+                scene->name, (unsigned)out->transactions, (unsigned)out->bytes,
+                (unsigned)out->windows, (unsigned)bus.transactions, (unsigned)bus.bytes,
+                (unsigned)bus.windows);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* out_dir = argc > 1 ? argv[1] : ".";
+    bool ok = true;
+
+    if (display_init() != ESP_OK || touchscreen_init() != ESP_OK || device_table_init() != ESP_OK) {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+    menu_init();
+    seed_aps();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    printf("compositor %s\n", display_compositor_active() ? "on" : "off");
+    printf("%-16s %28s | %28s\n", "scene", "first frame", "repeat");
+    for (size_t i = 0; i < SCENE_COUNT; i++) {
+        const sim_scene_t* scene = &scenes[i];
+        display_stats_t first, repeat;
+
+        display_fill_screen(COLOR_BLACK);
+        if (!run_frame(scene, &first)) {
+            ok = false;
+            continue;
+        }
+        save_frame(first_frame);
+        if (!frame_has_content()) {
+            fprintf(stderr, "%s: nothing was drawn\n", scene->name);
+            ok = false;
+        }
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s.ppm", out_dir, scene->name);
+        if (!fake_panel_write_ppm(path)) {
+            fprintf(stderr, "%s: cannot write %s\n", scene->name, path);
+            ok = false;
+        }
+
+        if (!run_frame(scene, &repeat)) {
+            ok = false;
+            continue;
+        }
+        int diff = frame_diff(first_frame);
+        if (scene->deterministic && diff) {
+            fprintf(stderr, "%s: redraw changed %d pixels\n", scene->name, diff);
+            ok = false;
+        }
+
+        printf("%-16s %6u tx %7u B %5u win | %6u tx %7u B %5u win\n", scene->name,
+               (unsigned)first.transactions, (unsigned)first.bytes, (unsigned)first.windows,
+               (unsigned)repeat.transactions, (unsigned)repeat.bytes, (unsigned)repeat.windows);
+    }
+
+    return ok ? 0 : 1;
+}
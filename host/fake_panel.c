@@ -0,0 +1,298 @@
+#include "fake_panel.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ILI9341_CASET       0x2A
+#define ILI9341_PASET       0x2B
+#define ILI9341_RAMWR       0x2C
+#define ILI9341_VSCRDEF     0x33
+#define ILI9341_VSCRSADD    0x37
+
+#define XPT2046_CMD_X       0xD0
+#define XPT2046_CMD_Y       0x90
+
+#define MAX_PINS            40
+#define MAX_QUEUE           16
+
+struct spi_device_t {
+    transaction_cb_t pre_cb;
+    int queue_size;
+};
+
+static struct spi_device_t lcd_device;
+static int pin_level[MAX_PINS];
+static fake_panel_stats_t stats;
+static char last_error[96];
+
+// Transactions the driver holds until they are reaped
+static spi_transaction_t* queue[MAX_QUEUE];
+static int queue_head = 0;
+static int queue_len = 0;
+
+// ILI9341 state
+static uint16_t frame[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+static uint8_t cmd = 0;
+static uint8_t args[8];
+static int arg_len = 0;
+static int col0, col1, page0, page1;
+static int cur_x, cur_y;
+static bool ram_open = false;           // RAMWR seen, window not exhausted
+static int pixel_hi = -1;               // first byte of a pixel split across bursts
+static int scroll_top = 0;
+static int scroll_height = DISPLAY_HEIGHT;
+static int scroll_start = 0;
+
+// XPT2046 state
+static int touch_x, touch_y;
+static int64_t touch_until_us = -1;
+static int touch_edges = 0;
+static uint8_t touch_cmd = 0;
+static uint16_t touch_value = 0;
+static int touch_miso = 0;
+
+static void panel_error(const char* msg) {
+    stats.errors++;
+    snprintf(last_error, sizeof(last_error), "%s", msg);
+}
+
+static uint16_t be16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+static void panel_command(uint8_t c) {
+    cmd = c;
+    arg_len = 0;
+    pixel_hi = -1;
+    ram_open = false;
+    if (c == ILI9341_RAMWR) {
+        stats.windows++;
+        if (col0 > col1 || page0 > page1 || col1 >= DISPLAY_WIDTH || page1 >= DISPLAY_HEIGHT) {
+            panel_error("RAMWR with an invalid window");
+            return;
+        }
+        cur_x = col0;
+        cur_y = page0;
+        ram_open = true;
+    }
+}
+
+static void panel_pixel(uint16_t color) {
+    if (!ram_open) {
+        panel_error("pixel data outside the RAMWR window");
+        return;
+    }
+    frame[cur_y][cur_x] = color;
+    stats.pixels++;
+    if (++cur_x > col1) {
+        cur_x = col0;
+        if (++cur_y > page1) ram_open = false;
+    }
+}
+
+static void panel_data(const uint8_t* data, size_t len) {
+    if (cmd == ILI9341_RAMWR) {
+        for (size_t i = 0; i < len; i++) {
+            if (pixel_hi < 0) {
+                pixel_hi = data[i];
+            } else {
+                panel_pixel((pixel_hi << 8) | data[i]);
+                pixel_hi = -1;
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < len && arg_len < (int)sizeof(args); i++) {
+        args[arg_len++] = data[i];
+    }
+    if (cmd == ILI9341_CASET && arg_len == 4) {
+        col0 = be16(args);
+        col1 = be16(args + 2);
+    } else if (cmd == ILI9341_PASET && arg_len == 4) {
+        page0 = be16(args);
+        page1 = be16(args + 2);
+    } else if (cmd == ILI9341_VSCRDEF && arg_len == 6) {
+        scroll_top = be16(args);
+        scroll_height = be16(args + 2);
+        if (scroll_top + scroll_height + be16(args + 4) != DISPLAY_HEIGHT) {
+            panel_error("VSCRDEF areas do not add up to the panel height");
+        }
+    } else if (cmd == ILI9341_VSCRSADD && arg_len == 2) {
+        scroll_start = be16(args);
+        if (scroll_start < scroll_top || scroll_start >= scroll_top + scroll_height) {
+            panel_error("VSCRSADD outside the scroll area");
+        }
+    }
+}
+
+// The DMA has read the buffer by the time the transaction is reaped
+static void complete(spi_transaction_t* t) {
+    if (lcd_device.pre_cb) lcd_device.pre_cb(t);
+
+    size_t len = t->length / 8;
+    const uint8_t* data = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : t->tx_buffer;
+    if ((t->flags & SPI_TRANS_USE_TXDATA) && len > sizeof(t->tx_data)) {
+        panel_error("TXDATA transaction longer than 4 bytes");
+        return;
+    }
+
+    if (pin_level[LCD_DC_PIN] == 0) {
+        for (size_t i = 0; i < len; i++) panel_command(data[i]);
+    } else {
+        panel_data(data, len);
+    }
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* config, int dma_chan) {
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle) {
+    lcd_device.pre_cb = config->pre_cb;
+    lcd_device.queue_size = config->queue_size < MAX_QUEUE ? config->queue_size : MAX_QUEUE;
+    *handle = &lcd_device;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, uint32_t ticks) {
+    // The real driver would block forever here, nothing frees a slot
+    if (queue_len == handle->queue_size) {
+        panel_error("transaction queued with the queue full");
+        return ESP_ERR_TIMEOUT;
+    }
+    queue[(queue_head + queue_len) % MAX_QUEUE] = trans;
+    queue_len++;
+    stats.transactions++;
+    stats.bytes += trans->length / 8;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans,
+                                      uint32_t ticks) {
+    if (queue_len == 0) {
+        panel_error("result reaped with nothing queued");
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = queue[queue_head];
+    queue_head = (queue_head + 1) % MAX_QUEUE;
+    queue_len--;
+    complete(*trans);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans) {
+    spi_transaction_t* done;
+    esp_err_t ret = spi_device_queue_trans(handle, trans, 0);
+    return ret == ESP_OK ? spi_device_get_trans_result(handle, &done, 0) : ret;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans) {
+    return spi_device_transmit(handle, trans);
+}
+
+static bool touch_held(void) {
+    return esp_timer_get_time() < touch_until_us;
+}
+
+// Inverse of the mapping in touchscreen_get_point()
+static uint16_t touch_raw(int screen, int size, int min, int max) {
+    return min + (screen * (max - min) + size - 1) / size;
+}
+
+// The controller samples DIN on rising SCK: 8 command bits, one busy
+// clock, then 12 result bits, MSB first, valid before each rising edge
+static void touch_clock(void) {
+    touch_edges++;
+    if (touch_edges <= 8) {
+        touch_cmd = (touch_cmd << 1) | pin_level[TOUCH_MOSI_PIN];
+        if (touch_edges == 8) {
+            if (!touch_held()) {
+                touch_value = 0;
+            } else if (touch_cmd == XPT2046_CMD_X) {
+                touch_value = touch_raw(DISPLAY_WIDTH - touch_x, DISPLAY_WIDTH, TS_MINX, TS_MAXX);
+            } else if (touch_cmd == XPT2046_CMD_Y) {
+                touch_value = touch_raw(touch_y, DISPLAY_HEIGHT, TS_MINY, TS_MAXY);
+            } else {
+                touch_value = 0;
+            }
+        }
+        touch_miso = 0;
+        return;
+    }
+    int bit = touch_edges - 9;
+    touch_miso = bit < 12 ? (touch_value >> (11 - bit)) & 1 : 0;
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    if (pin < 0 || pin >= MAX_PINS) return ESP_ERR_INVALID_ARG;
+
+    int was = pin_level[pin];
+    pin_level[pin] = level ? 1 : 0;
+    if (pin == TOUCH_CS_PIN && was && !level) {
+        touch_edges = 0;
+        touch_cmd = 0;
+        touch_miso = 0;
+    } else if (pin == TOUCH_SCK_PIN && !was && level && pin_level[TOUCH_CS_PIN] == 0) {
+        touch_clock();
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    if (pin == TOUCH_IRQ_PIN) return touch_held() ? 0 : 1;
+    if (pin == TOUCH_MISO_PIN) return touch_miso;
+    return (pin >= 0 && pin < MAX_PINS) ? pin_level[pin] : 0;
+}
+
+void fake_panel_touch(int x, int y, uint32_t duration_ms) {
+    touch_x = x;
+    touch_y = y;
+    touch_until_us = esp_timer_get_time() + (int64_t)duration_ms * 1000;
+}
+
+void fake_panel_get_stats(fake_panel_stats_t* out) {
+    *out = stats;
+}
+
+void fake_panel_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const char* fake_panel_last_error(void) {
+    return last_error;
+}
+
+uint16_t fake_panel_pixel(int x, int y) {
+    // The scroll area shows frame memory starting at line scroll_start
+    if (y >= scroll_top && y < scroll_top + scroll_height) {
+        y = scroll_top + (y - scroll_top + scroll_start - scroll_top) % scroll_height;
+    }
+    return frame[y][x];
+}
+
+bool fake_panel_write_ppm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return false;
+
+    fprintf(f, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint16_t c = fake_panel_pixel(x, y);
+            uint8_t rgb[3] = {
+                ((c >> 11) & 0x1F) * 255 / 31,
+                ((c >> 5) & 0x3F) * 255 / 63,
+                (c & 0x1F) * 255 / 31
+            };
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+    }
+    return fclose(f) == 0;
+}
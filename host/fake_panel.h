@@ -0,0 +1,36 @@
+#ifndef FAKE_PANEL_H
+#define FAKE_PANEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board_config.h"
+
+// Stands in for the SPI master driver and the GPIOs behind display.c and
+// touchscreen.c. Queued transactions are decoded as ILI9341 traffic into a
+// DISPLAY_WIDTH x DISPLAY_HEIGHT RGB565 frame memory when they are reaped,
+// the latest moment the DMA could have read them, so a buffer rewritten
+// while still queued shows up as corrupt pixels. The XPT2046 touch
+// controller is emulated on the bit-banged pins.
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t windows;           // RAMWR commands
+    uint32_t pixels;
+    uint32_t errors;            // protocol violations, see fake_panel_last_error()
+} fake_panel_stats_t;
+
+void fake_panel_get_stats(fake_panel_stats_t* stats);
+void fake_panel_reset_stats(void);
+const char* fake_panel_last_error(void);
+
+// Panel pixel at screen coordinates, with hardware scrolling applied
+uint16_t fake_panel_pixel(int x, int y);
+
+// Writes what the panel shows as a binary PPM; false on I/O error
+bool fake_panel_write_ppm(const char* path);
+
+// Holds a touch at screen coordinates for duration_ms of virtual time
+void fake_panel_touch(int x, int y, uint32_t duration_ms);
+
+#endif // FAKE_PANEL_H
@@ -0,0 +1,110 @@
+// Firmware modules the replayed screens link against but never reach on the
+// paths the simulator drives. Each is a no-op with its real signature; the
+// Wi-Fi scanner reports a sweep that has just finished, so screens show
+// whatever the simulator put in the device table.
+#include "airtime.h"
+#include "antenna_indicator.h"
+#include "attack_scheduler.h"
+#include "attack_timer.h"
+#include "badusb_functions.h"
+#include "battery_monitor.h"
+#include "board_config.h"
+#include "ble_attacks_enhanced.h"
+#include "bluetooth_functions.h"
+#include "brightness_control.h"
+#include "cc1101_driver.h"
+#include "channel_hopper.h"
+#include "confirmation_dialog.h"
+#include "device_table.h"
+#include "gps_functions.h"
+#include "ir_functions.h"
+#include "nfc_functions.h"
+#include "oui_spy.h"
+#include "probe_stats.h"
+#include "promisc_mux.h"
+#include "rf_functions.h"
+#include "stats.h"
+#include "subghz_protocols.h"
+#include "target_manager.h"
+#include "wifi_scanner.h"
+#include <string.h>
+
+void airtime_get_report(airtime_report_t* report) { memset(report, 0, sizeof(*report)); }
+esp_err_t airtime_start(void) { return ESP_OK; }
+void airtime_stop(void) {}
+
+esp_err_t antenna_toggle_ui(void) { return ESP_OK; }
+
+bool attack_scheduler_add(attack_type_t type, schedule_mode_t mode,
+                          uint32_t duration, uint32_t interval, uint32_t repeats) { return false; }
+void attack_scheduler_ui(void) {}
+
+void attack_timer_draw_overlay(void) {}
+bool attack_timer_expired(void) { return true; }
+void attack_timer_start(uint32_t duration_sec) {}
+void attack_timer_stop(void) {}
+
+void badusb_execute_payload(void) {}
+
+float battery_get_percentage(void) { return 80.0f; }
+void battery_show_details(void) {}
+
+void ble_apple_juice_attack(void) {}
+void ble_beacon_flood_attack(void) {}
+void ble_google_fastpair_spam(void) {}
+void ble_samsung_watch_spam_enhanced(void) {}
+void ble_sour_apple_attack(void) {}
+void ble_jammer_start(void) {}
+void ble_scan_start(void) {}
+void ble_sniffer_start(void) {}
+void ble_targeted_attack(void) {}
+
+esp_err_t brightness_control_ui(void) { return ESP_OK; }
+
+bool cc1101_is_connected(void) { return false; }
+
+esp_err_t channel_hopper_start(const channel_hopper_config_t* config) { return ESP_OK; }
+void channel_hopper_stop(void) {}
+
+bool confirm_dialog(const char* title, const char* message) { return false; }
+
+void gps_get_location(void) {}
+void ir_tv_power_attack(void) {}
+void nfc_scan_cards(void) {}
+void oui_spy_flock_detector(void) {}
+
+void probe_stats_get(probe_stats_t* stats) { memset(stats, 0, sizeof(*stats)); }
+void probe_stats_note_frame(const wifi_promiscuous_pkt_t* pkt) {}
+esp_err_t probe_stats_start(void) { return ESP_ERR_NOT_SUPPORTED; }
+void probe_stats_stop(void) {}
+size_t probe_stats_top_ssids(probe_ssid_count_t* out, size_t max) { return 0; }
+
+void promisc_hold(void) {}
+void promisc_release(void) {}
+esp_err_t promisc_subscribe(promisc_cb_t cb, const promisc_filter_t* filter, void* ctx) { return ESP_OK; }
+void promisc_unsubscribe(promisc_cb_t cb) {}
+
+void rf_spectrum_analyzer(void) {}
+
+void stats_increment_attacks(void) {}
+void stats_increment_captures(void) {}
+void stats_increment_scans(void) {}
+
+void subghz_capture_raw(uint32_t frequency, uint32_t duration_ms) {}
+
+void target_manager_quick_save_device(uint16_t device_id) {}
+void target_manager_ui(void) {}
+
+esp_err_t wifi_scanner_start(wifi_scan_profile_t profile) { return ESP_OK; }
+void wifi_scanner_stop(void) {}
+
+void wifi_scanner_get_progress(wifi_scanner_progress_t* progress) {
+    memset(progress, 0, sizeof(*progress));
+    progress->channels_done = WIFI_SCAN_LAST_CHANNEL;
+    progress->channel_count = WIFI_SCAN_LAST_CHANNEL;
+    progress->generation = 1;
+    progress->last_update_ms = device_table_now_ms();
+    progress->last_sweep_ms = progress->last_update_ms;
+}
+
+const char* wifi_scanner_profile_name(wifi_scan_profile_t profile) { return "Active"; }
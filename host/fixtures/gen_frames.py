@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Write frames.pcapng, the capture the host tests replay. Records use the
+same pcapng + radiotap layout as main/packet_capture.c, FCS included, so a
+capture pulled off the device can stand in for it. The frame order is part
+of the tests' expectations: keep it in sync with the FRAME_* indices in
+host/test_capture_filter.c.
+"""
+
+import argparse
+import struct
+import zlib
+
+LINKTYPE_IEEE802_11_RADIOTAP = 127
+
+AP = bytes.fromhex("001122334455")
+UBNT = bytes.fromhex("b41e52000001")   # OUI the filter tests look for
+UBNT2 = bytes.fromhex("b41e52000002")
+STA = bytes.fromhex("02aabbccddee")
+BCAST = b"\xff" * 6
+
+LLC_EAPOL = bytes.fromhex("aaaa03000000888e")
+LLC_IPV4 = bytes.fromhex("aaaa030000000800")
+EAPOL_KEY = bytes.fromhex("0203005f02008a00100000000000000001") + bytes(80)
+
+
+def fc(type_, subtype, flags=0):
+    return bytes([(subtype << 4) | (type_ << 2), flags])
+
+
+def mgmt(subtype, sa, da, bssid, body, flags=0):
+    return fc(0, subtype, flags) + b"\0\0" + da + sa + bssid + b"\0\0" + body
+
+
+def ie(id_, data):
+    return bytes([id_, len(data)]) + data
+
+
+def beacon(sa, ssid, channel):
+    fixed = bytes(8) + struct.pack("<HH", 100, 0x0431)
+    return mgmt(8, sa, BCAST, sa, fixed + ie(0, ssid) + ie(1, b"\x82\x84\x8b\x96") + ie(3, bytes([channel])))
+
+
+def data(subtype, flags, addrs, body, qos=False, htc=False):
+    hdr = fc(2, subtype, flags) + b"\0\0" + b"".join(addrs[:3]) + b"\0\0"
+    if len(addrs) == 4:
+        hdr += addrs[3]
+    if qos:
+        hdr += b"\x00\x00"
+    if htc:
+        hdr += b"\0\0\0\0"
+    return hdr + body
+
+
+def cut_in_addr2(frame):
+    # Keeps addr2's first two octets and picks the duration so the FCS
+    # starts with the third: a filter that counted the FCS as frame bytes
+    # would see the whole OUI
+    for duration in range(0x10000):
+        cut = frame[:2] + struct.pack("<H", duration) + frame[4:12]
+        if zlib.crc32(cut) & 0xFF == frame[12]:
+            return cut
+    raise RuntimeError("no duration gives the wanted FCS")
+
+
+# (frame, channel, rssi)
+FRAMES = [
+    (beacon(UBNT, b"lab", 6), 6, -40),
+    (beacon(AP, b"other", 1), 1, -80),
+    (mgmt(4, UBNT2, BCAST, BCAST, ie(0, b"") + ie(1, b"\x02\x04")), 6, -55),
+    (mgmt(12, AP, STA, AP, struct.pack("<H", 7)), 1, -60),
+    # EAPOL key frames: plain FromDS, QoS ToDS, QoS four-address, QoS + HT control
+    (data(0, 0x02, [STA, AP, AP], LLC_EAPOL + EAPOL_KEY), 6, -50),
+    (data(8, 0x01, [AP, STA, AP], LLC_EAPOL + EAPOL_KEY, qos=True), 6, -50),
+    (data(8, 0x03, [AP, UBNT, STA, UBNT2], LLC_EAPOL + EAPOL_KEY, qos=True), 11, -70),
+    (data(8, 0x82, [STA, AP, AP], LLC_EAPOL + EAPOL_KEY, qos=True, htc=True), 6, -45),
+    # Protected: the ciphertext happens to start with the EAPOL LLC header
+    (data(8, 0x42, [STA, AP, AP], bytes(8) + LLC_EAPOL + bytes(24), qos=True), 6, -50),
+    (data(8, 0x02, [STA, AP, AP], LLC_IPV4 + bytes(40), qos=True), 6, -50),
+    # ACK (receiver address only) and RTS (transmitter in addr2)
+    (fc(1, 13) + b"\0\0" + UBNT, 6, -40),
+    (fc(1, 11) + b"\0\0" + AP + UBNT, 6, -40),
+    # Beacon cut off inside addr2
+    (cut_in_addr2(beacon(UBNT, b"lab", 6)), 6, -40),
+]
+
+
+def radiotap(channel, rssi):
+    # radiotap_hdr_t with the Rate bit set, as packet_capture.c writes it
+    present = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5) | (1 << 6) | (1 << 11)
+    freq = 2484 if channel == 14 else 2407 + 5 * channel
+    return struct.pack("<BBHIQBBHHbbBBBB", 0, 0, 28, present, 0, 0x10, 2, freq, 0x00A0,
+                       rssi, -95, 0, 0, 0, 0)
+
+
+def epb(ts_us, packet):
+    pad = bytes(-len(packet) % 4)
+    block_len = 28 + len(packet) + len(pad) + 4
+    return (struct.pack("<IIIIIII", 6, block_len, 0, ts_us >> 32, ts_us & 0xFFFFFFFF,
+                        len(packet), len(packet)) + packet + pad + struct.pack("<I", block_len))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", default="frames.pcapng")
+    args = parser.parse_args()
+
+    out = struct.pack("<IIIHHqI", 0x0A0D0D0A, 28, 0x1A2B3C4D, 1, 0, -1, 28)
+    out += struct.pack("<IIHHII", 1, 20, LINKTYPE_IEEE802_11_RADIOTAP, 0, 65535, 20)
+    for i, (frame, channel, rssi) in enumerate(FRAMES):
+        frame += struct.pack("<I", zlib.crc32(frame))
+        out += epb(1000000 + i * 1000, radiotap(channel, rssi) + frame)
+
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print(f"Wrote {len(FRAMES)} frames to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,25 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+// Minimal check harness for the host unit tests: CHECK counts and reports
+// failures without stopping, host_test_report prints the tally and gives
+// main its exit code.
+static int host_test_failures = 0;
+static int host_test_checks = 0;
+
+#define CHECK(cond) do { \
+    host_test_checks++; \
+    if (!(cond)) { \
+        host_test_failures++; \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+static inline int host_test_report(void) {
+    printf("%d checks, %d failed\n", host_test_checks, host_test_failures);
+    return host_test_failures ? 1 : 0;
+}
+
+#endif // HOST_TEST_H
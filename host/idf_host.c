@@ -0,0 +1,227 @@
+// Host implementations of the ESP-IDF and FreeRTOS calls the firmware
+// sources make. Everything runs on one thread: tasks are recorded but never
+// started, locks always succeed, and time only moves when code calls
+// vTaskDelay, so a run is deterministic and blocking UI loops finish at once.
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+#include "esp_adc/adc_oneshot.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int64_t now_us = 0;
+static uint32_t random_state = 0x12345678;
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ESP_ERR_UNKNOWN";
+    }
+}
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    now_us += (int64_t)ticks * 1000;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return now_us / 1000;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle) {
+    if (handle) *handle = (TaskHandle_t)fn;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t)&now_us;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    vTaskDelay(ticks);
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return pdPASS;
+}
+
+static StaticSemaphore_t* semaphore_new(int count) {
+    StaticSemaphore_t* sem = calloc(1, sizeof(*sem));
+    if (sem) sem->count = count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return semaphore_new(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return semaphore_new(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buf) {
+    buf->count = 1;
+    return buf;
+}
+
+// Nothing else can release a semaphore, so an empty one times out at once
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    StaticSemaphore_t* s = sem;
+    if (s->count == 0) return pdFALSE;
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    ((StaticSemaphore_t*)sem)->count++;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    free(sem);
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? NULL : malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? NULL : calloc(n, size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : 160 * 1024;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return 160 * 1024;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    return 120 * 1024;
+}
+
+void esp_restart(void) {
+    abort();
+}
+
+// xorshift32
+uint32_t esp_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+void esp_fill_random(void* buf, size_t len) {
+    uint8_t* p = buf;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = esp_random();
+    }
+}
+
+// Chains like the ROM routine: start from 0, pass the last result to continue
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    return ESP_OK;
+}
+
+esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+
+esp_err_t esp_event_loop_create_default(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id,
+                                     esp_event_handler_t handler, void* arg) {
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id,
+                                       esp_event_handler_t handler) {
+    return ESP_OK;
+}
+
+// The radio is absent: configuration calls succeed and nothing is received
+esp_err_t esp_netif_init(void) { return ESP_OK; }
+void* esp_netif_create_default_wifi_sta(void) { return NULL; }
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) { return ESP_OK; }
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { return ESP_OK; }
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t* config) { return ESP_OK; }
+esp_err_t esp_wifi_start(void) { return ESP_OK; }
+esp_err_t esp_wifi_stop(void) { return ESP_OK; }
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) { return ESP_OK; }
+esp_err_t esp_wifi_80211_tx(wifi_interface_t iface, const void* buffer, int len, bool en_sys_seq) { return ESP_OK; }
+esp_err_t esp_wifi_set_promiscuous(bool enable) { return ESP_OK; }
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb) { return ESP_OK; }
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t* filter) { return ESP_OK; }
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t* config, bool block) { return ESP_OK; }
+esp_err_t esp_wifi_scan_stop(void) { return ESP_OK; }
+esp_err_t esp_wifi_clear_ap_list(void) { return ESP_OK; }
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* records) {
+    *number = 0;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t* config, adc_oneshot_unit_handle_t* handle) {
+    *handle = NULL;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t* config) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t channel, int* raw) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
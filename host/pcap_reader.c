@@ -0,0 +1,263 @@
+#include "pcap_reader.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PCAP_MAGIC_US       0xA1B2C3D4
+#define PCAP_MAGIC_NS       0xA1B23C4D
+#define PCAPNG_SHB          0x0A0D0D0A
+#define PCAPNG_IDB          0x00000001
+#define PCAPNG_EPB          0x00000006
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4D
+
+#define LINKTYPE_IEEE802_11             105
+#define LINKTYPE_IEEE802_11_RADIOTAP    127
+
+#define RT_FLAG_FCS         0x10
+#define MAX_INTERFACES      8
+#define MAX_SIG_LEN         4095    // width of rx_ctrl.sig_len
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    bool swap;              // file byte order differs from ours
+    size_t capacity;
+    pcap_frames_t* out;
+} reader_t;
+
+static uint16_t rd16(const reader_t* r, const uint8_t* p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swap ? __builtin_bswap16(v) : v;
+}
+
+static uint32_t rd32(const reader_t* r, const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swap ? __builtin_bswap32(v) : v;
+}
+
+// Radiotap is little-endian whatever the file byte order
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t freq_to_channel(uint16_t freq) {
+    if (freq == 2484) return 14;
+    if (freq >= 2412 && freq <= 2472) return (freq - 2407) / 5;
+    return 0;
+}
+
+// Fills rssi and channel from the radiotap fields preceding and including
+// dBm antenna signal; returns the header length, 0 if it is malformed
+static size_t parse_radiotap(const uint8_t* data, size_t len, wifi_pkt_rx_ctrl_t* rx, bool* fcs) {
+    // Alignment and size of fields 0-5: TSFT, Flags, Rate, Channel, FHSS, dBm signal
+    static const uint8_t field_align[6] = {8, 1, 1, 2, 2, 1};
+    static const uint8_t field_size[6] = {8, 1, 1, 4, 2, 1};
+
+    if (len < 8 || data[0] != 0) return 0;
+    size_t rt_len = le16(data + 2);
+    if (rt_len < 8 || rt_len > len) return 0;
+
+    uint32_t present = le32(data + 4);
+    size_t off = 8;
+    for (uint32_t word = present; word & (1u << 31); off += 4) {
+        if (off + 4 > rt_len) return 0;
+        word = le32(data + off);
+    }
+
+    *fcs = false;
+    for (int bit = 0; bit < 6; bit++) {
+        if (!(present & (1u << bit))) continue;
+        off = (off + field_align[bit] - 1) & ~(size_t)(field_align[bit] - 1);
+        if (off + field_size[bit] > rt_len) return 0;
+        if (bit == 1) {
+            *fcs = data[off] & RT_FLAG_FCS;
+        } else if (bit == 3) {
+            rx->channel = freq_to_channel(le16(data + off));
+        } else if (bit == 5) {
+            rx->rssi = (int8_t)data[off];
+        }
+        off += field_size[bit];
+    }
+    return rt_len;
+}
+
+static bool add_frame(reader_t* r, uint32_t linktype, const uint8_t* data, size_t caplen) {
+    wifi_pkt_rx_ctrl_t rx;
+    bool fcs = false;
+
+    memset(&rx, 0, sizeof(rx));
+    if (linktype == LINKTYPE_IEEE802_11_RADIOTAP) {
+        size_t rt_len = parse_radiotap(data, caplen, &rx, &fcs);
+        if (rt_len == 0) {
+            fprintf(stderr, "pcap: frame %zu has a malformed radiotap header\n", r->out->count);
+            return false;
+        }
+        data += rt_len;
+        caplen -= rt_len;
+    } else if (linktype != LINKTYPE_IEEE802_11) {
+        fprintf(stderr, "pcap: link type %u is not 802.11\n", (unsigned)linktype);
+        return false;
+    }
+
+    size_t sig_len = caplen + (fcs ? 0 : 4);
+    if (sig_len > MAX_SIG_LEN) {
+        fprintf(stderr, "pcap: frame %zu is %zu bytes, too long for sig_len\n", r->out->count, sig_len);
+        return false;
+    }
+    rx.sig_len = sig_len;
+
+    if (r->out->count == r->capacity) {
+        r->capacity = r->capacity ? r->capacity * 2 : 64;
+        r->out->pkts = realloc(r->out->pkts, r->capacity * sizeof(*r->out->pkts));
+        r->out->types = realloc(r->out->types, r->capacity * sizeof(*r->out->types));
+    }
+
+    wifi_promiscuous_pkt_t* pkt = calloc(1, sizeof(*pkt) + sig_len);
+    pkt->rx_ctrl = rx;
+    memcpy(pkt->payload, data, caplen);
+
+    wifi_promiscuous_pkt_type_t type = WIFI_PKT_MISC;
+    if (caplen > 0) {
+        switch ((data[0] >> 2) & 0x03) {
+        case 0: type = WIFI_PKT_MGMT; break;
+        case 1: type = WIFI_PKT_CTRL; break;
+        case 2: type = WIFI_PKT_DATA; break;
+        }
+    }
+    r->out->pkts[r->out->count] = pkt;
+    r->out->types[r->out->count] = type;
+    r->out->count++;
+    return true;
+}
+
+static bool read_pcap(reader_t* r) {
+    if (r->len < 24) {
+        fprintf(stderr, "pcap: truncated file header\n");
+        return false;
+    }
+    uint32_t linktype = rd32(r, r->data + 20);
+
+    for (size_t off = 24; off < r->len;) {
+        if (r->len - off < 16) {
+            fprintf(stderr, "pcap: truncated record header at %zu\n", off);
+            return false;
+        }
+        uint32_t caplen = rd32(r, r->data + off + 8);
+        off += 16;
+        if (caplen > r->len - off) {
+            fprintf(stderr, "pcap: record at %zu runs past the end of the file\n", off - 16);
+            return false;
+        }
+        if (!add_frame(r, linktype, r->data + off, caplen)) return false;
+        off += caplen;
+    }
+    return true;
+}
+
+static bool read_pcapng(reader_t* r) {
+    uint32_t linktypes[MAX_INTERFACES];
+    uint32_t interfaces = 0;
+
+    for (size_t off = 0; off < r->len;) {
+        if (r->len - off < 12) {
+            fprintf(stderr, "pcapng: truncated block at %zu\n", off);
+            return false;
+        }
+        const uint8_t* block = r->data + off;
+        uint32_t type = rd32(r, block);
+
+        // Each section declares its own byte order
+        if (type == PCAPNG_SHB) {
+            r->swap = false;
+            if (rd32(r, block + 8) != PCAPNG_BYTE_ORDER) r->swap = true;
+            if (rd32(r, block + 8) != PCAPNG_BYTE_ORDER) {
+                fprintf(stderr, "pcapng: bad byte-order magic at %zu\n", off);
+                return false;
+            }
+            interfaces = 0;
+        }
+
+        uint32_t block_len = rd32(r, block + 4);
+        if (block_len < 12 || (block_len & 3) || block_len > r->len - off) {
+            fprintf(stderr, "pcapng: bad block length %u at %zu\n", (unsigned)block_len, off);
+            return false;
+        }
+
+        if (type == PCAPNG_IDB && block_len >= 20) {
+            if (interfaces == MAX_INTERFACES) {
+                fprintf(stderr, "pcapng: more than %d interfaces\n", MAX_INTERFACES);
+                return false;
+            }
+            linktypes[interfaces++] = rd16(r, block + 8);
+        } else if (type == PCAPNG_EPB) {
+            if (block_len < 32) {
+                fprintf(stderr, "pcapng: short packet block at %zu\n", off);
+                return false;
+            }
+            uint32_t iface = rd32(r, block + 8);
+            uint32_t caplen = rd32(r, block + 20);
+            if (iface >= interfaces || caplen > block_len - 32) {
+                fprintf(stderr, "pcapng: bad packet block at %zu\n", off);
+                return false;
+            }
+            if (!add_frame(r, linktypes[iface], block + 28, caplen)) return false;
+        }
+        off += block_len;
+    }
+    return true;
+}
+
+bool pcap_load(const char* path, pcap_frames_t* frames) {
+    memset(frames, 0, sizeof(*frames));
+
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "pcap: cannot open %s\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc(size > 0 ? size : 1);
+    bool ok = size >= 4 && fread(data, 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "pcap: cannot read %s\n", path);
+        free(data);
+        return false;
+    }
+
+    reader_t r = {.data = data, .len = size, .out = frames};
+    uint32_t magic = rd32(&r, data);
+    if (magic == PCAPNG_SHB) {
+        ok = read_pcapng(&r);
+    } else if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        ok = read_pcap(&r);
+    } else if (magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS)) {
+        r.swap = true;
+        ok = read_pcap(&r);
+    } else {
+        fprintf(stderr, "pcap: %s is not a pcap or pcapng file\n", path);
+        ok = false;
+    }
+
+    free(data);
+    if (!ok) pcap_free(frames);
+    return ok;
+}
+
+void pcap_free(pcap_frames_t* frames) {
+    for (size_t i = 0; i < frames->count; i++) {
+        free(frames->pkts[i]);
+    }
+    free(frames->pkts);
+    free(frames->types);
+    memset(frames, 0, sizeof(*frames));
+}
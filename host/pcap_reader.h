@@ -0,0 +1,24 @@
+#ifndef PCAP_READER_H
+#define PCAP_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_wifi_types.h"
+
+// Loads an 802.11 capture into the buffers a promiscuous callback receives.
+// Reads classic pcap and pcapng (as written by packet_capture.c), link types
+// 105 (bare 802.11) and 127 (radiotap). Radiotap supplies rx_ctrl.rssi and
+// rx_ctrl.channel; frames captured without an FCS get four zero bytes
+// appended so rx_ctrl.sig_len counts one, as the ESP32 driver's does.
+
+typedef struct {
+    wifi_promiscuous_pkt_t** pkts;
+    wifi_promiscuous_pkt_type_t* types;
+    size_t count;
+} pcap_frames_t;
+
+// False with an explanation on stderr if the file is unreadable or malformed
+bool pcap_load(const char* path, pcap_frames_t* frames);
+void pcap_free(pcap_frames_t* frames);
+
+#endif // PCAP_READER_H
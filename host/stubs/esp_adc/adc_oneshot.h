@@ -0,0 +1,29 @@
+#ifndef ESP_ADC_ADC_ONESHOT_H
+#define ESP_ADC_ADC_ONESHOT_H
+
+#include "esp_err.h"
+
+typedef void* adc_oneshot_unit_handle_t;
+typedef int adc_channel_t;
+
+#define ADC_UNIT_1              0
+#define ADC_CHANNEL_0           0
+#define ADC_BITWIDTH_DEFAULT    0
+#define ADC_ATTEN_DB_12         3
+
+typedef struct {
+    int unit_id;
+    int ulp_mode;
+} adc_oneshot_unit_init_cfg_t;
+
+typedef struct {
+    int bitwidth;
+    int atten;
+} adc_oneshot_chan_cfg_t;
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t* config, adc_oneshot_unit_handle_t* handle);
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t* config);
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t channel, int* raw);
+
+#endif // ESP_ADC_ADC_ONESHOT_H
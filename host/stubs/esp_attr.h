@@ -0,0 +1,9 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DMA_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif // ESP_ATTR_H
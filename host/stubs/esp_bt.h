@@ -0,0 +1,9 @@
+#ifndef ESP_BT_H
+#define ESP_BT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef uint8_t esp_bd_addr_t[6];
+
+#endif // ESP_BT_H
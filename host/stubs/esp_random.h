@@ -0,0 +1,11 @@
+#ifndef ESP_RANDOM_H
+#define ESP_RANDOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-seed generator so screenshots are reproducible
+uint32_t esp_random(void);
+void esp_fill_random(void* buf, size_t len);
+
+#endif // ESP_RANDOM_H
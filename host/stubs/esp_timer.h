@@ -0,0 +1,9 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+// Virtual time: advanced only by vTaskDelay, so runs are deterministic
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,228 @@
+// Unit tests for airtime.c: on-air time of DSSS/CCK, OFDM and HT frames,
+// and the per-sweep buckets, including rollover after AIRTIME_BUCKETS
+// sweeps. The channel hopper and the promiscuous mux are faked here so the
+// test drives the RX and sweep callbacks directly.
+#include "airtime.h"
+#include "board_config.h"
+#include "channel_hopper.h"
+#include "promisc_mux.h"
+#include "host_test.h"
+#include <string.h>
+
+#define SIG_MODE_LEGACY 0
+#define SIG_MODE_HT     1
+#define NOISE_FLOOR     -95
+
+static promisc_cb_t rx_cb;
+static channel_hopper_cb_t sweep_cb;
+static bool hopper_running;
+
+// Cumulative hopper stats for channels 1, 6 and 11
+static channel_hopper_stats_t hopper = {
+    .channel_count = 3,
+    .channels = { {.channel = 1}, {.channel = 6}, {.channel = 11} }
+};
+
+esp_err_t promisc_subscribe(promisc_cb_t cb, const promisc_filter_t* filter, void* ctx) {
+    rx_cb = cb;
+    return ESP_OK;
+}
+
+void promisc_unsubscribe(promisc_cb_t cb) {
+    rx_cb = NULL;
+}
+
+esp_err_t channel_hopper_subscribe(channel_hopper_cb_t cb, void* ctx) {
+    sweep_cb = cb;
+    return ESP_OK;
+}
+
+void channel_hopper_unsubscribe(channel_hopper_cb_t cb) {
+    sweep_cb = NULL;
+}
+
+// Like the real hopper, a fresh start begins its dwell totals at zero
+esp_err_t channel_hopper_start(const channel_hopper_config_t* config) {
+    for (int i = 0; i < hopper.channel_count; i++) {
+        hopper.channels[i].total_dwell_ms = 0;
+    }
+    hopper_running = true;
+    return ESP_OK;
+}
+
+void channel_hopper_stop(void) {
+    hopper_running = false;
+}
+
+bool channel_hopper_is_running(void) {
+    return hopper_running;
+}
+
+void channel_hopper_get_stats(channel_hopper_stats_t* stats) {
+    *stats = hopper;
+}
+
+static void sweep(uint32_t dwell_ms) {
+    for (int i = 0; i < hopper.channel_count; i++) {
+        hopper.channels[i].total_dwell_ms += dwell_ms;
+    }
+    hopper.sweeps++;
+    if (sweep_cb) sweep_cb(&hopper, NULL);
+}
+
+// Only the frame control of the payload is read; sig_len carries the length
+static void rx(const wifi_pkt_rx_ctrl_t* ctrl, bool retry) {
+    static union {
+        wifi_promiscuous_pkt_t pkt;
+        uint8_t bytes[sizeof(wifi_promiscuous_pkt_t) + 24];
+    } buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.pkt.rx_ctrl = *ctrl;
+    buf.pkt.rx_ctrl.noise_floor = NOISE_FLOOR;
+    buf.pkt.payload[1] = retry ? 0x08 : 0;
+    rx_cb(&buf.pkt, WIFI_PKT_DATA, NULL);
+}
+
+static void rx_legacy(uint8_t channel, uint8_t rate, uint16_t len, bool retry) {
+    wifi_pkt_rx_ctrl_t ctrl = {0};
+    ctrl.channel = channel;
+    ctrl.sig_mode = SIG_MODE_LEGACY;
+    ctrl.rate = rate;
+    ctrl.sig_len = len;
+    rx(&ctrl, retry);
+}
+
+static const airtime_channel_t* channel_report(const airtime_report_t* r, uint8_t channel) {
+    for (int i = 0; i < r->channel_count; i++) {
+        if (r->channels[i].channel == channel) return &r->channels[i];
+    }
+    return NULL;
+}
+
+// Busy per-mille is airtime in us per ms listened, so one frame over a
+// 1 ms sweep reads back its airtime in us (all cases stay under 1000)
+static uint32_t airtime_of(const wifi_pkt_rx_ctrl_t* ctrl) {
+    airtime_report_t r;
+    airtime_start();
+    rx(ctrl, false);
+    sweep(1);
+    airtime_get_report(&r);
+    airtime_stop();
+    const airtime_channel_t* c = channel_report(&r, ctrl->channel);
+    return c ? c->busy_permille : UINT32_MAX;
+}
+
+static uint32_t legacy_us(uint8_t rate, uint16_t len) {
+    wifi_pkt_rx_ctrl_t ctrl = {0};
+    ctrl.channel = 1;
+    ctrl.sig_mode = SIG_MODE_LEGACY;
+    ctrl.rate = rate;
+    ctrl.sig_len = len;
+    return airtime_of(&ctrl);
+}
+
+static uint32_t ht_us(uint8_t mcs, bool cwb, bool sgi, uint16_t len) {
+    wifi_pkt_rx_ctrl_t ctrl = {0};
+    ctrl.channel = 1;
+    ctrl.sig_mode = SIG_MODE_HT;
+    ctrl.mcs = mcs;
+    ctrl.cwb = cwb;
+    ctrl.sgi = sgi;
+    ctrl.sig_len = len;
+    return airtime_of(&ctrl);
+}
+
+// Expected values are worked from 802.11 timing: DSSS/CCK is the PLCP
+// preamble and header (192 us long, 96 us short) plus the PSDU at the rate;
+// OFDM is 20 us of preamble and SIGNAL plus 4 us symbols carrying SERVICE,
+// PSDU and tail bits; HT mixed format adds HT-SIG/STF/LTF for 36 us in all
+// and uses 3.6 us symbols with the short guard interval
+static void test_rates(void) {
+    CHECK(legacy_us(0x00, 100) == 992);     // 1 Mbps long: 192 + 800
+    CHECK(legacy_us(0x01, 100) == 592);     // 2 Mbps long: 192 + 400
+    CHECK(legacy_us(0x05, 100) == 496);     // 2 Mbps short: 96 + 400
+    CHECK(legacy_us(0x07, 1000) == 824);    // 11 Mbps short: 96 + ceil(8000 / 11)
+    CHECK(legacy_us(0x0B, 100) == 160);     // 6 Mbps: 20 + 4 * ceil(822 / 24)
+    CHECK(legacy_us(0x0F, 200) == 204);     // 9 Mbps: 20 + 4 * ceil(1622 / 36)
+    CHECK(legacy_us(0x0C, 1500) == 244);    // 54 Mbps: 20 + 4 * ceil(12022 / 216)
+    CHECK(legacy_us(0x04, 100) == 0);       // no such rate code
+
+    CHECK(ht_us(0, false, false, 100) == 164);      // MCS0 HT20: 36 + 4 * ceil(822 / 26)
+    CHECK(ht_us(7, false, false, 1500) == 224);     // MCS7 HT20: 36 + 4 * 47
+    CHECK(ht_us(7, false, true, 1500) == 206);      // MCS7 HT20 SGI: 36 + ceil(47 * 3.6)
+    CHECK(ht_us(0, true, false, 100) == 100);       // MCS0 HT40: 36 + 4 * ceil(822 / 54)
+    CHECK(ht_us(7, true, false, 1500) == 128);      // MCS7 HT40: 36 + 4 * ceil(12022 / 540)
+}
+
+static void test_buckets(void) {
+    airtime_report_t r;
+    const airtime_channel_t* c;
+
+    CHECK(airtime_start() == ESP_OK && hopper_running);
+
+    // First sweep: 10 frames on channel 6, 3 of them retries, and 1 ms of
+    // traffic on channel 1, over 100 ms per channel
+    for (int i = 0; i < 10; i++) rx_legacy(6, 0x0B, 100, i < 3);
+    for (int i = 0; i < 5; i++) rx_legacy(1, 0x0B, 100, false);
+    sweep(100);
+    airtime_get_report(&r);
+    CHECK(r.sweeps == 1 && r.channel_count == 3);
+    c = channel_report(&r, 6);
+    CHECK(c && c->listen_ms == 100 && c->frames_per_s == 100 && c->retry_permille == 300);
+    CHECK(c && c->busy_permille == 16 && c->noise_floor == NOISE_FLOOR);
+    c = channel_report(&r, 1);
+    CHECK(c && c->busy_permille == 8 && c->frames_per_s == 50 && c->retry_permille == 0);
+    c = channel_report(&r, 11);
+    CHECK(c && c->listen_ms == 100 && c->frames_per_s == 0 && c->noise_floor == 0);
+
+    // Frames heard after a sweep closes count toward the next one
+    rx_legacy(11, 0x0B, 100, false);
+    airtime_get_report(&r);
+    CHECK(channel_report(&r, 11)->frames_per_s == 0);
+
+    // The window holds AIRTIME_BUCKETS sweeps...
+    for (int i = 1; i < AIRTIME_BUCKETS; i++) sweep(100);
+    airtime_get_report(&r);
+    CHECK(r.sweeps == AIRTIME_BUCKETS);
+    c = channel_report(&r, 6);
+    CHECK(c && c->listen_ms == AIRTIME_BUCKETS * 100);
+    CHECK(c && c->frames_per_s == 10 * 1000 / (AIRTIME_BUCKETS * 100) && c->retry_permille == 300);
+    c = channel_report(&r, 11);
+    CHECK(c && c->noise_floor == NOISE_FLOOR);
+
+    // ...and one more pushes the first sweep out
+    sweep(100);
+    airtime_get_report(&r);
+    CHECK(r.sweeps == AIRTIME_BUCKETS + 1);
+    c = channel_report(&r, 6);
+    CHECK(c && c->listen_ms == AIRTIME_BUCKETS * 100);
+    CHECK(c && c->frames_per_s == 0 && c->retry_permille == 0 && c->busy_permille == 0);
+    CHECK(c && c->noise_floor == 0);
+    c = channel_report(&r, 11);
+    CHECK(c && c->noise_floor == NOISE_FLOOR);
+
+    airtime_stop();
+    CHECK(!hopper_running && rx_cb == NULL && sweep_cb == NULL);
+}
+
+// Joining a hopper that is already running only counts dwell from then on
+static void test_shared_hopper(void) {
+    airtime_report_t r;
+
+    channel_hopper_start(NULL);
+    sweep(5000);
+    CHECK(airtime_start() == ESP_OK);
+    sweep(100);
+    airtime_get_report(&r);
+    CHECK(r.sweeps == 1 && channel_report(&r, 1)->listen_ms == 100);
+    airtime_stop();
+    CHECK(hopper_running);
+    channel_hopper_stop();
+}
+
+int main(void) {
+    test_rates();
+    test_buckets();
+    test_shared_hopper();
+    return host_test_report();
+}
@@ -0,0 +1,158 @@
+// Compiles filter expressions and runs them over the frames in
+// fixtures/frames.pcapng through capture_filter_match(), the wrapper the
+// promiscuous callbacks use, then checks which frames each one selects.
+#include "capture_filter.h"
+#include "pcap_reader.h"
+#include <stdio.h>
+
+// Order of fixtures/gen_frames.py
+enum {
+    FRAME_BEACON_UBNT,      // b4:1e:52:00:00:01, channel 6, -40 dBm
+    FRAME_BEACON_OTHER,     // 00:11:22:33:44:55, channel 1, -80 dBm
+    FRAME_PROBE_REQ,        // from b4:1e:52:00:00:02, -55 dBm
+    FRAME_DEAUTH,           // channel 1, -60 dBm
+    FRAME_EAPOL,            // plain data, FromDS
+    FRAME_EAPOL_QOS,        // QoS data, ToDS
+    FRAME_EAPOL_WDS,        // QoS data, four addresses, addr2 b4:1e:52:00:00:01, channel 11, -70 dBm
+    FRAME_EAPOL_HTC,        // QoS data with HT control, -45 dBm
+    FRAME_PROTECTED,        // protected QoS data whose ciphertext looks like EAPOL
+    FRAME_QOS_IPV4,         // QoS data carrying IPv4
+    FRAME_ACK,              // to b4:1e:52:00:00:01, no addr2
+    FRAME_RTS,              // from b4:1e:52:00:00:01
+    FRAME_BEACON_CUT,       // b4:1e:52 beacon truncated to 12 bytes, inside addr2
+    FRAME_COUNT
+};
+
+#define F(name)     (1u << FRAME_##name)
+#define ALL_MGMT    (F(BEACON_UBNT) | F(BEACON_OTHER) | F(PROBE_REQ) | F(DEAUTH) | F(BEACON_CUT))
+#define ALL_CTRL    (F(ACK) | F(RTS))
+#define ALL_EAPOL   (F(EAPOL) | F(EAPOL_QOS) | F(EAPOL_WDS) | F(EAPOL_HTC))
+#define ALL_DATA    (ALL_EAPOL | F(PROTECTED) | F(QOS_IPV4))
+#define ALL_QOS     (F(EAPOL_QOS) | F(EAPOL_WDS) | F(EAPOL_HTC) | F(PROTECTED) | F(QOS_IPV4))
+#define BEACONS     (F(BEACON_UBNT) | F(BEACON_OTHER) | F(BEACON_CUT))
+
+typedef struct {
+    const char* expr;
+    uint32_t frames;        // FRAME_* bits expected to match
+} filter_case_t;
+
+static const filter_case_t cases[] = {
+    {"mgmt", ALL_MGMT},
+    {"ctrl", ALL_CTRL},
+    {"data", ALL_DATA},
+    {"subtype beacon", BEACONS},
+    {"mgmt subtype beacon", BEACONS},
+    {"MGMT SubType Beacon", BEACONS},
+    {"subtype deauth", F(DEAUTH)},
+    {"subtype qos-data", ALL_QOS},
+    // A numeric subtype ignores the type bits: beacons and QoS data are both 8
+    {"subtype 8", BEACONS | ALL_QOS},
+
+    // Bounds: the cut beacon ends inside addr2 and ACK has none
+    {"addr2 oui b4:1e:52", F(BEACON_UBNT) | F(PROBE_REQ) | F(EAPOL_WDS) | F(RTS)},
+    {"addr2 b4-1e-52-00-00-01", F(BEACON_UBNT) | F(EAPOL_WDS) | F(RTS)},
+    {"addr1 ff:ff:ff:ff:ff:ff", F(BEACON_UBNT) | F(BEACON_OTHER) | F(PROBE_REQ) | F(BEACON_CUT)},
+    {"addr1 oui b4:1e:52", F(ACK)},
+
+    // EAPOL behind QoS control, a fourth address and HT control, never
+    // when protected
+    {"eapol", ALL_EAPOL},
+    {"data and not eapol", F(PROTECTED) | F(QOS_IPV4)},
+
+    {"rssi > -50", F(BEACON_UBNT) | F(EAPOL_HTC) | F(ACK) | F(RTS) | F(BEACON_CUT)},
+    {"rssi < -60", F(BEACON_OTHER) | F(EAPOL_WDS)},
+    {"channel 1", F(BEACON_OTHER) | F(DEAUTH)},
+    {"channel 11 eapol", F(EAPOL_WDS)},
+
+    // Precedence: not > and (explicit or adjacent) > or
+    {"subtype beacon or subtype probe-req addr2 oui b4:1e:52", BEACONS | F(PROBE_REQ)},
+    {"(subtype beacon or subtype probe-req) addr2 oui b4:1e:52", F(BEACON_UBNT) | F(PROBE_REQ)},
+    {"mgmt or ctrl and addr2 oui b4:1e:52", ALL_MGMT | F(RTS)},
+    {"eapol or mgmt channel 1", ALL_EAPOL | F(BEACON_OTHER) | F(DEAUTH)},
+    {"not mgmt or ctrl", ALL_DATA | ALL_CTRL},
+    {"not (mgmt or ctrl)", ALL_DATA},
+    {"not not eapol", ALL_EAPOL},
+    {"not mgmt and not data", ALL_CTRL},
+    {"((mgmt))", ALL_MGMT},
+};
+
+static const char* const bad_exprs[] = {
+    "subtype bogus",
+    "subtype 16",
+    "addr2 oui b4:1e",
+    "addr2 zz:1e:52",
+    "addr4 b4:1e:52",
+    "(mgmt",
+    "mgmt )",
+    "rssi = 3",
+    "rssi > loud",
+    "channel 15",
+    "mgmt or",
+    "not",
+    "and",
+    // 17 terms and 16 ANDs, one more than CAPTURE_FILTER_MAX_INSNS
+    "mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt mgmt",
+};
+
+static int failures = 0;
+static int checks = 0;
+
+static void check(bool ok, const char* what, const char* expr) {
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "FAIL: %s: \"%s\"\n", what, expr ? expr : "(null)");
+    }
+}
+
+static uint32_t run(const capture_filter_t* filter, const pcap_frames_t* frames) {
+    uint32_t matched = 0;
+    for (size_t i = 0; i < frames->count; i++) {
+        if (capture_filter_match(filter, frames->pkts[i])) matched |= 1u << i;
+    }
+    return matched;
+}
+
+int main(int argc, char** argv) {
+    pcap_frames_t frames;
+    capture_filter_t filter;
+
+    if (argc < 2 || !pcap_load(argv[1], &frames)) {
+        fprintf(stderr, "usage: %s frames.pcapng\n", argv[0]);
+        return 1;
+    }
+    if (frames.count != FRAME_COUNT) {
+        fprintf(stderr, "%s has %zu frames, expected %d\n", argv[1], frames.count, FRAME_COUNT);
+        return 1;
+    }
+
+    const uint32_t all = (1u << FRAME_COUNT) - 1;
+    check(capture_filter_compile(&filter, NULL) == ESP_OK && run(&filter, &frames) == all,
+          "empty filter matches everything", NULL);
+    check(capture_filter_compile(&filter, "  ") == ESP_OK && run(&filter, &frames) == all,
+          "empty filter matches everything", "  ");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const filter_case_t* c = &cases[i];
+        if (capture_filter_compile(&filter, c->expr) != ESP_OK) {
+            check(false, "does not compile", c->expr);
+            continue;
+        }
+        uint32_t matched = run(&filter, &frames);
+        check(matched == c->frames, "wrong frames", c->expr);
+        if (matched != c->frames) {
+            fprintf(stderr, "      matched 0x%04x, expected 0x%04x\n",
+                    (unsigned)matched, (unsigned)c->frames);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(bad_exprs) / sizeof(bad_exprs[0]); i++) {
+        filter.count = 1;
+        check(capture_filter_compile(&filter, bad_exprs[i]) == ESP_ERR_INVALID_ARG &&
+              filter.count == 0, "accepted or left a partial program", bad_exprs[i]);
+    }
+
+    pcap_free(&frames);
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+// Unit tests for device_table.c: merging sightings, the open-addressing
+// index (including backward-shift deletes across the wrap of the slot
+// array), least-recently-seen eviction when full, queries and expiry.
+// Host time only moves on vTaskDelay, so every sighting is stamped exactly.
+#include "device_table.h"
+#include "host_test.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static uint16_t capacity;
+static uint32_t slot_mask;
+
+static void make_mac(uint8_t mac[6], uint32_t n) {
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = n >> 24;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+// Same hash as device_table.c, to build keys that collide on purpose
+static uint32_t home_slot(uint8_t kind, const uint8_t* mac) {
+    uint32_t h = (2166136261u ^ kind) * 16777619u;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    return h & slot_mask;
+}
+
+static int see(device_kind_t kind, const uint8_t* mac, int8_t rssi, bool* is_new) {
+    device_sighting_t s = { .kind = kind, .mac = mac, .rssi = rssi };
+    return device_table_update(&s, is_new);
+}
+
+static void test_merge(void) {
+    uint8_t mac[6];
+    bool is_new;
+    make_mac(mac, 1);
+
+    int id = see(DEVICE_KIND_WIFI_AP, mac, -60, &is_new);
+    CHECK(id >= 0 && is_new);
+    vTaskDelay(5);
+    device_sighting_t s = {
+        .kind = DEVICE_KIND_WIFI_AP, .mac = mac, .rssi = -40,
+        .channel = 6, .name = "office", .authmode = 3, .flags = DEVICE_FLAG_WATCHED
+    };
+    CHECK(device_table_update(&s, &is_new) == id && !is_new);
+    vTaskDelay(5);
+    CHECK(see(DEVICE_KIND_WIFI_AP, mac, -80, &is_new) == id && !is_new);
+
+    device_info_t info;
+    CHECK(device_table_get(id, &info));
+    CHECK(memcmp(info.mac, mac, 6) == 0 && info.kind == DEVICE_KIND_WIFI_AP);
+    CHECK(info.rssi_last == -80 && info.rssi_min == -80 && info.rssi_max == -40);
+    CHECK(info.rssi < -40 && info.rssi > -80);
+    CHECK(info.channel == 6 && info.authmode == 3 && strcmp(info.name, "office") == 0);
+    CHECK(info.flags == DEVICE_FLAG_WATCHED);
+    CHECK(info.sightings == 3 && info.last_seen_ms - info.first_seen_ms == 10);
+
+    int8_t hist[DEVICE_RSSI_HISTORY];
+    CHECK(device_table_rssi_history(id, hist, 8) == 3);
+    CHECK(hist[0] == -60 && hist[1] == -40 && hist[2] == -80);
+    CHECK(device_table_rssi_history(id, hist, 2) == 2 && hist[0] == -40 && hist[1] == -80);
+
+    // Same MAC under another kind is a different device
+    CHECK(see(DEVICE_KIND_BLE, mac, -70, &is_new) != id && is_new);
+    CHECK(device_table_count(DEVICE_KIND_WIFI_AP) == 1 && device_table_count(DEVICE_KIND_ANY) == 2);
+
+    device_table_clear(DEVICE_KIND_ANY);
+    CHECK(device_table_find(DEVICE_KIND_WIFI_AP, mac) < 0 && !device_table_get(id, &info));
+    CHECK(device_table_count(DEVICE_KIND_ANY) == 0);
+}
+
+// Finds the n-th MAC (from *next on) whose home slot for kind is slot
+static void colliding_mac(uint8_t mac[6], uint8_t kind, uint32_t slot, uint32_t* next) {
+    do {
+        make_mac(mac, (*next)++);
+    } while (home_slot(kind, mac) != slot);
+}
+
+// A run of entries homed on the last two slots wraps to the start of the
+// array; deleting from the middle must shift the tail back across the wrap
+static void test_backward_shift(void) {
+    uint32_t last = slot_mask;
+    uint32_t next = 1000;
+    uint8_t ble[5][6], sta[6];
+
+    colliding_mac(ble[0], DEVICE_KIND_BLE, last - 1, &next);
+    colliding_mac(sta, DEVICE_KIND_WIFI_STA, last - 1, &next);
+    colliding_mac(ble[1], DEVICE_KIND_BLE, last - 1, &next);
+    colliding_mac(ble[2], DEVICE_KIND_BLE, last, &next);
+    colliding_mac(ble[3], DEVICE_KIND_BLE, 0, &next);
+    colliding_mac(ble[4], DEVICE_KIND_BLE, last - 1, &next);
+
+    int ids[5];
+    ids[0] = see(DEVICE_KIND_BLE, ble[0], -50, NULL);
+    see(DEVICE_KIND_WIFI_STA, sta, -50, NULL);
+    for (int i = 1; i < 5; i++) ids[i] = see(DEVICE_KIND_BLE, ble[i], -50, NULL);
+
+    for (int i = 0; i < 5; i++) CHECK(device_table_find(DEVICE_KIND_BLE, ble[i]) == ids[i]);
+    CHECK(device_table_find(DEVICE_KIND_WIFI_STA, sta) >= 0);
+
+    device_table_clear(DEVICE_KIND_WIFI_STA);
+    CHECK(device_table_find(DEVICE_KIND_WIFI_STA, sta) < 0);
+    for (int i = 0; i < 5; i++) CHECK(device_table_find(DEVICE_KIND_BLE, ble[i]) == ids[i]);
+
+    // And again from the far side of the wrap
+    device_table_expire(DEVICE_KIND_BLE, UINT32_MAX);
+    CHECK(device_table_count(DEVICE_KIND_BLE) == 5);
+    vTaskDelay(10);
+    see(DEVICE_KIND_BLE, ble[0], -50, NULL);
+    see(DEVICE_KIND_BLE, ble[3], -50, NULL);
+    see(DEVICE_KIND_BLE, ble[4], -50, NULL);
+    CHECK(device_table_expire(DEVICE_KIND_BLE, 5) == 2);
+    CHECK(device_table_find(DEVICE_KIND_BLE, ble[1]) < 0 && device_table_find(DEVICE_KIND_BLE, ble[2]) < 0);
+    CHECK(device_table_find(DEVICE_KIND_BLE, ble[0]) == ids[0]);
+    CHECK(device_table_find(DEVICE_KIND_BLE, ble[3]) == ids[3]);
+    CHECK(device_table_find(DEVICE_KIND_BLE, ble[4]) == ids[4]);
+
+    device_table_clear(DEVICE_KIND_ANY);
+}
+
+// Fills the table, then every new device evicts the one heard from least
+// recently, whatever its kind or row
+static void test_eviction(void) {
+    uint8_t mac[6];
+    for (uint32_t i = 0; i < capacity; i++) {
+        make_mac(mac, i);
+        see(i % 3 ? DEVICE_KIND_BLE : DEVICE_KIND_WIFI_AP, mac, -50, NULL);
+        vTaskDelay(1);
+    }
+    CHECK(device_table_count(DEVICE_KIND_ANY) == capacity);
+
+    // Refreshing the two oldest moves them to the back of the line
+    make_mac(mac, 0);
+    see(DEVICE_KIND_WIFI_AP, mac, -50, NULL);
+    make_mac(mac, 1);
+    see(DEVICE_KIND_BLE, mac, -50, NULL);
+    vTaskDelay(1);
+
+    bool is_new;
+    for (uint32_t i = 0; i < 10; i++) {
+        make_mac(mac, 100000 + i);
+        CHECK(see(DEVICE_KIND_BLE, mac, -50, &is_new) >= 0 && is_new);
+        vTaskDelay(1);
+    }
+    CHECK(device_table_count(DEVICE_KIND_ANY) == capacity);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        make_mac(mac, i);
+        bool evicted = i >= 2 && i < 12;
+        CHECK((device_table_find(i % 3 ? DEVICE_KIND_BLE : DEVICE_KIND_WIFI_AP, mac) < 0) == evicted);
+    }
+    for (uint32_t i = 0; i < 10; i++) {
+        make_mac(mac, 100000 + i);
+        CHECK(device_table_find(DEVICE_KIND_BLE, mac) >= 0);
+    }
+
+    device_table_clear(DEVICE_KIND_ANY);
+}
+
+static void test_query(void) {
+    static const int8_t rssi[4] = {-70, -30, -90, -50};
+    uint8_t mac[6];
+    int ids[4];
+    uint32_t start = device_table_now_ms();
+
+    for (int i = 0; i < 4; i++) {
+        make_mac(mac, 500 + i);
+        ids[i] = see(DEVICE_KIND_WIFI_AP, mac, rssi[i], NULL);
+        vTaskDelay(10);
+    }
+    make_mac(mac, 600);
+    device_sighting_t watched = {
+        .kind = DEVICE_KIND_BLE, .mac = mac, .rssi = -10, .flags = DEVICE_FLAG_WATCHED
+    };
+    int ble = device_table_update(&watched, NULL);
+
+    uint16_t out[8];
+    CHECK(device_table_query(DEVICE_KIND_WIFI_AP, 0, 0, DEVICE_ORDER_RSSI, out, 8) == 4);
+    CHECK(out[0] == ids[1] && out[1] == ids[3] && out[2] == ids[0] && out[3] == ids[2]);
+    CHECK(device_table_query(DEVICE_KIND_WIFI_AP, 0, 0, DEVICE_ORDER_LAST_SEEN, out, 8) == 4);
+    CHECK(out[0] == ids[3] && out[3] == ids[0]);
+    CHECK(device_table_query(DEVICE_KIND_ANY, 0, 0, DEVICE_ORDER_FIRST_SEEN, out, 8) == 5);
+    CHECK(out[0] == ids[0] && out[4] == ble);
+    CHECK(device_table_query(DEVICE_KIND_ANY, DEVICE_FLAG_WATCHED, 0, DEVICE_ORDER_RSSI, out, 8) == 1);
+    CHECK(out[0] == ble);
+    CHECK(device_table_query(DEVICE_KIND_WIFI_AP, 0, start + 20, DEVICE_ORDER_RSSI, out, 8) == 2);
+    CHECK(device_table_query(DEVICE_KIND_ANY, 0, 0, DEVICE_ORDER_RSSI, out, 2) == 2);
+    CHECK(out[0] == ble && out[1] == ids[1]);
+
+    device_table_clear_flags(DEVICE_KIND_ANY, DEVICE_FLAG_WATCHED);
+    CHECK(device_table_query(DEVICE_KIND_ANY, DEVICE_FLAG_WATCHED, 0, DEVICE_ORDER_RSSI, out, 8) == 0);
+
+    device_table_clear(DEVICE_KIND_ANY);
+}
+
+// Rows freed by deletes are reused, and the index still finds everything
+// after a long run of mixed inserts and expiries
+static void test_churn(void) {
+    uint8_t mac[6];
+    uint32_t live_from = 0;
+    for (uint32_t round = 0; round < 20; round++) {
+        for (uint32_t i = 0; i < capacity / 4; i++) {
+            make_mac(mac, round * 1000 + i);
+            see(DEVICE_KIND_BLE, mac, -50, NULL);
+        }
+        vTaskDelay(100);
+        if (round >= 2) {
+            CHECK(device_table_expire(DEVICE_KIND_BLE, 250) == capacity / 4);
+            live_from = round - 1;
+        }
+    }
+    CHECK(device_table_count(DEVICE_KIND_BLE) == 2 * (capacity / 4));
+    for (uint32_t round = 0; round < 20; round++) {
+        for (uint32_t i = 0; i < capacity / 4; i++) {
+            make_mac(mac, round * 1000 + i);
+            bool live = round >= live_from;
+            CHECK((device_table_find(DEVICE_KIND_BLE, mac) >= 0) == live);
+        }
+    }
+    device_table_clear(DEVICE_KIND_ANY);
+}
+
+int main(void) {
+    if (device_table_init() != ESP_OK) {
+        fprintf(stderr, "device_table_init failed\n");
+        return 1;
+    }
+    capacity = device_table_capacity();
+    slot_mask = 1;
+    while (slot_mask < 2u * capacity) slot_mask <<= 1;
+    slot_mask--;
+    vTaskDelay(1000);
+
+    test_merge();
+    test_backward_shift();
+    test_eviction();
+    test_query();
+    test_churn();
+    return host_test_report();
+}
@@ -0,0 +1,359 @@
+// Unit tests for eapol_tracker.c: classifying EAPOL-Key frames as M1..M4,
+// pairing them into crackable and complete handshakes by replay counter,
+// and the pair pool's index and least-recently-active eviction. Frames are
+// built here as plain (non-QoS) data frames and parsed with wifi_frame.h.
+#include "eapol_tracker.h"
+#include "host_test.h"
+#include <string.h>
+
+#define KEY_INFO_PAIRWISE   0x0008
+#define KEY_INFO_INSTALL    0x0040
+#define KEY_INFO_ACK        0x0080
+#define KEY_INFO_MIC        0x0100
+#define KEY_INFO_SECURE     0x0200
+#define KEY_DESC_V2         0x0002
+
+#define M1_INFO (KEY_DESC_V2 | KEY_INFO_PAIRWISE | KEY_INFO_ACK)
+#define M2_INFO (KEY_DESC_V2 | KEY_INFO_PAIRWISE | KEY_INFO_MIC)
+#define M3_INFO (KEY_DESC_V2 | KEY_INFO_PAIRWISE | KEY_INFO_ACK | KEY_INFO_MIC | KEY_INFO_SECURE | KEY_INFO_INSTALL)
+#define M4_INFO (KEY_DESC_V2 | KEY_INFO_PAIRWISE | KEY_INFO_MIC | KEY_INFO_SECURE)
+
+// 24-byte header, LLC/SNAP, 802.1X header and a 95-byte key descriptor,
+// plus key data
+#define HDR_LEN     24
+#define EAPOL_OFF   (HDR_LEN + 8)
+#define FRAME_LEN   (EAPOL_OFF + 99 + 22)
+
+static const uint8_t ap_mac[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t sta_mac[6] = {0x02, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE};
+
+static uint32_t now_ms;
+
+static void put_be(uint8_t* p, uint64_t v, int n) {
+    for (int i = n - 1; i >= 0; i--, v >>= 8) p[i] = v;
+}
+
+// Builds an EAPOL-Key frame; M1 and M3 go AP to station (From DS), M2 and
+// M4 station to AP (To DS)
+static size_t build_key(uint8_t* buf, const uint8_t* bssid, const uint8_t* station,
+                        uint16_t info, uint64_t replay, uint16_t data_len) {
+    memset(buf, 0, FRAME_LEN);
+    buf[0] = 0x08;
+    if (info & KEY_INFO_ACK) {
+        buf[1] = 0x02;
+        memcpy(&buf[4], station, 6);
+        memcpy(&buf[10], bssid, 6);
+    } else {
+        buf[1] = 0x01;
+        memcpy(&buf[4], bssid, 6);
+        memcpy(&buf[10], station, 6);
+    }
+    memcpy(&buf[16], bssid, 6);
+
+    static const uint8_t llc[8] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8E};
+    memcpy(&buf[HDR_LEN], llc, sizeof(llc));
+
+    uint8_t* eapol = &buf[EAPOL_OFF];
+    eapol[0] = 2;                       // 802.1X-2004
+    eapol[1] = 3;                       // EAPOL-Key
+    put_be(&eapol[2], 95 + data_len, 2);
+    eapol[4] = 2;                       // RSN key descriptor
+    put_be(&eapol[5], info, 2);
+    put_be(&eapol[9], replay, 8);
+    put_be(&eapol[97], data_len, 2);
+    return EAPOL_OFF + 99 + data_len;
+}
+
+static bool feed_key(const uint8_t* bssid, const uint8_t* station,
+                     uint16_t info, uint64_t replay, uint16_t data_len) {
+    uint8_t buf[FRAME_LEN];
+    size_t len = build_key(buf, bssid, station, info, replay, data_len);
+    wifi_frame_t f;
+    if (!wifi_frame_parse(&f, buf, len)) return false;
+    return eapol_tracker_feed(&f, now_ms++);
+}
+
+// WPA2 handshake messages; M2 carries the station's RSN IE as key data
+static void m1(const uint8_t* b, const uint8_t* s, uint64_t r) { feed_key(b, s, M1_INFO, r, 0); }
+static void m2(const uint8_t* b, const uint8_t* s, uint64_t r) { feed_key(b, s, M2_INFO, r, 22); }
+static void m3(const uint8_t* b, const uint8_t* s, uint64_t r) { feed_key(b, s, M3_INFO, r, 22); }
+static void m4(const uint8_t* b, const uint8_t* s, uint64_t r) { feed_key(b, s, M4_INFO, r, 0); }
+
+typedef struct {
+    int count;
+    eapol_pair_t pairs[4];
+} collect_t;
+
+static void collect_cb(const eapol_pair_t* pair, void* ctx) {
+    collect_t* c = ctx;
+    if (c->count < 4) c->pairs[c->count] = *pair;
+    c->count++;
+}
+
+static eapol_pair_t only_pair(void) {
+    collect_t c = {0};
+    eapol_tracker_foreach(collect_cb, &c);
+    CHECK(c.count == 1);
+    return c.pairs[0];
+}
+
+static void stats(eapol_tracker_stats_t* s) {
+    eapol_tracker_get_stats(s);
+}
+
+static void test_in_order(void) {
+    eapol_tracker_stats_t s;
+    eapol_tracker_reset();
+
+    m1(ap_mac, sta_mac, 7);
+    eapol_pair_t p = only_pair();
+    CHECK(p.msgs == EAPOL_MSG_M1 && !p.crackable && !p.complete && p.replay == 7);
+    CHECK(memcmp(p.bssid, ap_mac, 6) == 0 && memcmp(p.station, sta_mac, 6) == 0);
+
+    m2(ap_mac, sta_mac, 7);
+    p = only_pair();
+    CHECK(p.msgs == (EAPOL_MSG_M1 | EAPOL_MSG_M2) && p.crackable && !p.complete);
+
+    m3(ap_mac, sta_mac, 8);
+    m4(ap_mac, sta_mac, 8);
+    p = only_pair();
+    CHECK(p.msgs == (EAPOL_MSG_M1 | EAPOL_MSG_M2 | EAPOL_MSG_M3 | EAPOL_MSG_M4));
+    CHECK(p.crackable && p.complete && p.replay == 7 && p.last_seen_ms == now_ms - 1);
+
+    stats(&s);
+    CHECK(s.frames == 4 && s.pairs == 1 && s.crackable == 1 && s.complete == 1 && s.evictions == 0);
+
+    // A rekey later counts toward the same pair, not the totals again
+    m1(ap_mac, sta_mac, 9);
+    p = only_pair();
+    CHECK(p.msgs == EAPOL_MSG_M1 && p.replay == 9 && p.crackable && p.complete);
+    m2(ap_mac, sta_mac, 9);
+    m3(ap_mac, sta_mac, 10);
+    m4(ap_mac, sta_mac, 10);
+    stats(&s);
+    CHECK(s.frames == 8 && s.pairs == 1 && s.crackable == 1 && s.complete == 1);
+}
+
+static void test_partial(void) {
+    eapol_tracker_stats_t s;
+    eapol_pair_t p;
+
+    // M2/M3 alone is enough to crack, but not a complete handshake
+    eapol_tracker_reset();
+    m2(ap_mac, sta_mac, 3);
+    m3(ap_mac, sta_mac, 4);
+    m4(ap_mac, sta_mac, 4);
+    p = only_pair();
+    CHECK(p.crackable && !p.complete && p.msgs == (EAPOL_MSG_M2 | EAPOL_MSG_M3 | EAPOL_MSG_M4));
+
+    // An M1 always starts a new exchange, even after its own M2
+    eapol_tracker_reset();
+    m2(ap_mac, sta_mac, 3);
+    m1(ap_mac, sta_mac, 3);
+    p = only_pair();
+    CHECK(p.msgs == EAPOL_MSG_M1 && !p.crackable);
+
+    // Retransmitted M1s move the exchange to the newest replay counter
+    eapol_tracker_reset();
+    m1(ap_mac, sta_mac, 1);
+    m1(ap_mac, sta_mac, 2);
+    m2(ap_mac, sta_mac, 1);
+    p = only_pair();
+    CHECK(p.msgs == EAPOL_MSG_M2 && p.replay == 1 && !p.crackable);
+    m1(ap_mac, sta_mac, 5);
+    m2(ap_mac, sta_mac, 5);
+    m3(ap_mac, sta_mac, 6);
+    m4(ap_mac, sta_mac, 6);
+    p = only_pair();
+    CHECK(p.crackable && p.complete && p.replay == 5);
+
+    // M3/M4 from a different exchange than M1/M2 do not complete it
+    eapol_tracker_reset();
+    m1(ap_mac, sta_mac, 1);
+    m2(ap_mac, sta_mac, 1);
+    m3(ap_mac, sta_mac, 5);
+    m4(ap_mac, sta_mac, 5);
+    p = only_pair();
+    CHECK(p.crackable && !p.complete && p.replay == 4);
+    stats(&s);
+    CHECK(s.crackable == 1 && s.complete == 0);
+}
+
+static void test_classify(void) {
+    eapol_tracker_stats_t s;
+    eapol_pair_t p;
+    uint8_t buf[FRAME_LEN];
+    wifi_frame_t f;
+
+    // WPA: M4 is not secure but carries no key data
+    eapol_tracker_reset();
+    feed_key(ap_mac, sta_mac, M1_INFO, 1, 0);
+    feed_key(ap_mac, sta_mac, KEY_INFO_PAIRWISE | KEY_INFO_MIC, 1, 22);
+    feed_key(ap_mac, sta_mac, KEY_INFO_PAIRWISE | KEY_INFO_ACK | KEY_INFO_MIC | KEY_INFO_INSTALL, 2, 22);
+    feed_key(ap_mac, sta_mac, KEY_INFO_PAIRWISE | KEY_INFO_MIC, 2, 0);
+    p = only_pair();
+    CHECK(p.complete);
+
+    // Group key handshakes and keys with neither ACK nor MIC are EAPOL-Key
+    // frames but not handshake messages
+    eapol_tracker_reset();
+    CHECK(feed_key(ap_mac, sta_mac, KEY_INFO_ACK | KEY_INFO_MIC | KEY_INFO_SECURE, 1, 22));
+    CHECK(feed_key(ap_mac, sta_mac, KEY_INFO_PAIRWISE, 1, 0));
+    stats(&s);
+    CHECK(s.frames == 0 && s.pairs == 0);
+
+    // Not EAPOL-Key: other 802.1X types, truncated, protected and non-data
+    size_t len = build_key(buf, ap_mac, sta_mac, M1_INFO, 1, 0);
+    buf[EAPOL_OFF + 1] = 0;
+    CHECK(wifi_frame_parse(&f, buf, len) && !eapol_tracker_feed(&f, 0));
+    len = build_key(buf, ap_mac, sta_mac, M1_INFO, 1, 0);
+    CHECK(wifi_frame_parse(&f, buf, len - 1) && !eapol_tracker_feed(&f, 0));
+    buf[1] |= WIFI_FC_PROTECTED;
+    CHECK(wifi_frame_parse(&f, buf, len) && !eapol_tracker_feed(&f, 0));
+    len = build_key(buf, ap_mac, sta_mac, M1_INFO, 1, 0);
+    buf[0] = 0x80;
+    CHECK(wifi_frame_parse(&f, buf, len) && !eapol_tracker_feed(&f, 0));
+    stats(&s);
+    CHECK(s.frames == 0 && s.pairs == 0);
+}
+
+// Pairs are keyed on (BSSID, station) whichever direction a frame goes,
+// and handshakes on different pairs interleave freely
+static void test_interleaved(void) {
+    static const uint8_t ap2[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x66};
+    static const uint8_t sta2[6] = {0x02, 0xAA, 0xBB, 0xCC, 0xDD, 0xEF};
+    eapol_tracker_reset();
+
+    m1(ap_mac, sta_mac, 1);
+    m1(ap_mac, sta2, 1);
+    m1(ap2, sta_mac, 1);
+    m2(ap_mac, sta2, 1);
+    m2(ap_mac, sta_mac, 1);
+    m3(ap_mac, sta_mac, 2);
+    m2(ap2, sta_mac, 2);
+    m4(ap_mac, sta_mac, 2);
+
+    collect_t c = {0};
+    eapol_tracker_foreach(collect_cb, &c);
+    CHECK(c.count == 3);
+    // Oldest activity first
+    CHECK(memcmp(c.pairs[0].station, sta2, 6) == 0 && c.pairs[0].crackable && !c.pairs[0].complete);
+    CHECK(memcmp(c.pairs[1].bssid, ap2, 6) == 0 && !c.pairs[1].crackable);
+    CHECK(memcmp(c.pairs[2].bssid, ap_mac, 6) == 0 && memcmp(c.pairs[2].station, sta_mac, 6) == 0);
+    CHECK(c.pairs[2].complete);
+
+    eapol_tracker_stats_t s;
+    stats(&s);
+    CHECK(s.pairs == 3 && s.crackable == 2 && s.complete == 1);
+}
+
+static void make_station(uint8_t mac[6], uint32_t n) {
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = n >> 24;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+// Same hash and index size as eapol_tracker.c, to build keys that collide
+static uint32_t home_slot(const uint8_t* bssid, const uint8_t* station) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ bssid[i]) * 16777619u;
+    for (int i = 0; i < 6; i++) h = (h ^ station[i]) * 16777619u;
+    return h & 511;
+}
+
+static void colliding_station(uint8_t mac[6], uint32_t slot, uint32_t* next) {
+    do {
+        make_station(mac, (*next)++);
+    } while (home_slot(ap_mac, mac) != slot);
+}
+
+// True when the pair is still tracked: feeding it must not take a new slot
+static bool tracked(const uint8_t* station) {
+    eapol_tracker_stats_t before, after;
+    stats(&before);
+    m1(ap_mac, station, 1);
+    stats(&after);
+    return after.evictions == before.evictions && after.pairs == before.pairs;
+}
+
+// With the pool full, each new pair recycles the least recently active
+// one; the index deletes it with a backward shift, here across the wrap
+static void test_eviction(void) {
+    eapol_tracker_stats_t s;
+    uint8_t chain[4][6], mac[6];
+    uint32_t next = 1000;
+    eapol_tracker_reset();
+
+    // Slots 511, 0, 1, 2; deleting the first must leave chain[1] at its
+    // home slot 0 and shift the other two back across the wrap
+    colliding_station(chain[0], 511, &next);
+    colliding_station(chain[1], 0, &next);
+    colliding_station(chain[2], 511, &next);
+    colliding_station(chain[3], 0, &next);
+    for (int i = 0; i < 4; i++) m1(ap_mac, chain[i], 1);
+    for (uint32_t i = 4; i < EAPOL_TRACKER_MAX_PAIRS; i++) {
+        make_station(mac, 100000 + i);
+        m1(ap_mac, mac, 1);
+    }
+    stats(&s);
+    CHECK(s.pairs == EAPOL_TRACKER_MAX_PAIRS && s.evictions == 0);
+
+    make_station(mac, 200000);
+    m1(ap_mac, mac, 1);
+    stats(&s);
+    CHECK(s.pairs == EAPOL_TRACKER_MAX_PAIRS && s.evictions == 1);
+    for (int i = 1; i < 4; i++) CHECK(tracked(chain[i]));
+    CHECK(!tracked(chain[0]));
+
+    // The miss above recycled the next oldest; activity keeps a pair, so
+    // refresh the oldest left and evict past it
+    make_station(mac, 100005);
+    m2(ap_mac, mac, 1);
+    for (uint32_t i = 0; i < 3; i++) {
+        make_station(mac, 300000 + i);
+        m1(ap_mac, mac, 1);
+    }
+    make_station(mac, 100005);
+    CHECK(tracked(mac));
+    for (uint32_t i = 6; i < 9; i++) {
+        make_station(mac, 100000 + i);
+        CHECK(!tracked(mac));
+    }
+}
+
+// Long churn through the pool: the newest EAPOL_TRACKER_MAX_PAIRS pairs
+// are always exactly the ones tracked
+static void test_churn(void) {
+    uint8_t mac[6];
+    const uint32_t total = 8 * EAPOL_TRACKER_MAX_PAIRS;
+    eapol_tracker_reset();
+
+    for (uint32_t i = 0; i < total; i++) {
+        make_station(mac, i);
+        m1(ap_mac, mac, 1);
+    }
+    eapol_tracker_stats_t s;
+    stats(&s);
+    CHECK(s.pairs == EAPOL_TRACKER_MAX_PAIRS && s.evictions == total - EAPOL_TRACKER_MAX_PAIRS);
+
+    // Refeeding the live pairs, oldest first, never evicts one of them
+    int found = 0;
+    for (uint32_t i = total - EAPOL_TRACKER_MAX_PAIRS; i < total; i++) {
+        make_station(mac, i);
+        found += tracked(mac);
+    }
+    CHECK(found == EAPOL_TRACKER_MAX_PAIRS);
+}
+
+int main(void) {
+    test_in_order();
+    test_partial();
+    test_classify();
+    test_interleaved();
+    test_eviction();
+    test_churn();
+    return host_test_report();
+}
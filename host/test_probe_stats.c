@@ -0,0 +1,240 @@
+// Unit tests for probe_stats.c: space-saving top-K counts for SSIDs and
+// source MACs, probe rates, and the HyperLogLog distinct-device estimate.
+// Host tasks never run, so the source is included here and the test calls
+// probe_drain where the worker task would.
+#include "../main/probe_stats.c"
+#include "host_test.h"
+
+static void make_mac(uint8_t mac[6], uint32_t n) {
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = n >> 24;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+// Probe request with an SSID element (ssid_len > 32 is passed through to
+// test the parser's limit), a rates element and the FCS
+static void probe(const uint8_t* mac, const char* ssid, int ssid_len, int8_t rssi) {
+    static union {
+        wifi_promiscuous_pkt_t pkt;
+        uint8_t bytes[sizeof(wifi_promiscuous_pkt_t) + 128];
+    } buf;
+    memset(&buf, 0, sizeof(buf));
+    uint8_t* p = buf.pkt.payload;
+    p[0] = 0x40;
+    memset(&p[4], 0xFF, 6);
+    memcpy(&p[10], mac, 6);
+    memset(&p[16], 0xFF, 6);
+
+    size_t len = 24;
+    p[len++] = WIFI_IE_SSID;
+    p[len++] = ssid_len;
+    memset(&p[len], 'x', ssid_len);
+    if (ssid) memcpy(&p[len], ssid, strlen(ssid));
+    len += ssid_len;
+    static const uint8_t rates[] = {1, 4, 0x82, 0x84, 0x8B, 0x96};
+    memcpy(&p[len], rates, sizeof(rates));
+    len += sizeof(rates) + 4;
+
+    buf.pkt.rx_ctrl.sig_len = len;
+    buf.pkt.rx_ctrl.rssi = rssi;
+    probe_stats_note_frame(&buf.pkt);
+}
+
+static void probe_ssid(uint32_t mac_n, const char* ssid) {
+    uint8_t mac[6];
+    make_mac(mac, mac_n);
+    probe(mac, ssid, ssid ? strlen(ssid) : 0, -60);
+}
+
+static const probe_ssid_count_t* find_ssid(const probe_ssid_count_t* top, size_t n, const char* ssid) {
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(top[i].ssid, ssid) == 0) return &top[i];
+    }
+    return NULL;
+}
+
+static void test_ssids(void) {
+    probe_ssid_count_t top[PROBE_STATS_TOP_SSIDS];
+    probe_stats_t s;
+
+    CHECK(probe_stats_start() == ESP_OK);
+    for (int i = 0; i < 50; i++) probe_ssid(i, "home");
+    for (int i = 0; i < 30; i++) probe_ssid(i, "office");
+    for (int i = 0; i < 10; i++) probe_ssid(i, "cafe");
+    for (int i = 0; i < 5; i++) probe_ssid(i, NULL);
+    probe_drain();
+
+    probe_stats_get(&s);
+    CHECK(s.probes == 95 && s.wildcard == 5 && s.dropped == 0);
+    CHECK(probe_stats_top_ssids(top, PROBE_STATS_TOP_SSIDS) == 3);
+    CHECK(strcmp(top[0].ssid, "home") == 0 && top[0].count == 50 && top[0].error == 0);
+    CHECK(strcmp(top[1].ssid, "office") == 0 && top[1].count == 30);
+    CHECK(strcmp(top[2].ssid, "cafe") == 0 && top[2].count == 10);
+    CHECK(probe_stats_top_ssids(top, 2) == 2 && strcmp(top[1].ssid, "office") == 0);
+
+    // A prefix of a counted SSID is a different SSID
+    probe_ssid(0, "hom");
+    probe_drain();
+    size_t n = probe_stats_top_ssids(top, PROBE_STATS_TOP_SSIDS);
+    CHECK(n == 4 && find_ssid(top, n, "hom")->count == 1 && find_ssid(top, n, "home")->count == 50);
+
+    // Over-long SSID elements are counted as wildcard probes
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    probe(mac, NULL, 33, -60);
+    probe_drain();
+    probe_stats_get(&s);
+    CHECK(s.probes == 97 && s.wildcard == 6);
+    probe_stats_stop();
+}
+
+// Once the table is full every new SSID takes over the smallest counter;
+// heavy hitters keep exact counts and no estimate undercounts
+static void test_ssid_overflow(void) {
+    static const char* heavy[3] = {"alpha", "bravo", "charlie"};
+    probe_ssid_count_t top[PROBE_STATS_TOP_SSIDS];
+    char name[16];
+
+    CHECK(probe_stats_start() == ESP_OK);
+    for (int round = 0; round < 20; round++) {
+        for (int h = 0; h < 3; h++) {
+            for (int k = 0; k <= h; k++) probe_ssid(round, heavy[h]);
+        }
+        // Three fresh SSIDs a round, 60 in all, twice what the table holds
+        for (int i = 0; i < 3; i++) {
+            snprintf(name, sizeof(name), "net%d", round * 3 + i);
+            probe_ssid(round, name);
+        }
+        probe_drain();
+    }
+
+    size_t n = probe_stats_top_ssids(top, PROBE_STATS_TOP_SSIDS);
+    CHECK(n == PROBE_STATS_TOP_SSIDS);
+    CHECK(strcmp(top[0].ssid, "charlie") == 0 && top[0].count == 60 && top[0].error == 0);
+    CHECK(strcmp(top[1].ssid, "bravo") == 0 && top[1].count == 40 && top[1].error == 0);
+    CHECK(strcmp(top[2].ssid, "alpha") == 0 && top[2].count == 20 && top[2].error == 0);
+
+    // Every other SSID was probed once: count - error <= 1 <= count
+    uint32_t total = 0;
+    for (size_t i = 3; i < n; i++) {
+        CHECK(strncmp(top[i].ssid, "net", 3) == 0);
+        CHECK(top[i].count >= 1 && top[i].count - top[i].error <= 1);
+        total += top[i].count;
+    }
+    // Space-saving keeps the sum of counters equal to the stream length
+    CHECK(total + 120 == 20 * 9);
+    probe_stats_stop();
+}
+
+static void test_devices(void) {
+    probe_device_count_t top[PROBE_STATS_TOP_DEVICES];
+    uint8_t a[6], b[6];
+    make_mac(a, 0xA);
+    make_mac(b, 0xB);
+
+    CHECK(probe_stats_start() == ESP_OK);
+    // a probes every 6 s for a minute, b three times in quick succession
+    for (int i = 0; i <= 10; i++) {
+        probe(a, "home", 4, -40 - i);
+        if (i < 3) probe(b, NULL, 0, -70);
+        probe_drain();
+        vTaskDelay(6000);
+    }
+
+    CHECK(probe_stats_top_devices(top, PROBE_STATS_TOP_DEVICES) == 2);
+    CHECK(memcmp(top[0].mac, a, 6) == 0 && top[0].count == 11 && top[0].error == 0);
+    CHECK(top[0].rssi == -50 && top[0].per_minute == 11);
+    CHECK(memcmp(top[1].mac, b, 6) == 0 && top[1].count == 3 && top[1].rssi == -70);
+    CHECK(top[1].per_minute == 3 * 60000 / 12000);
+
+    // Fresh MACs beyond the table take over the smallest counters, never a
+    // heavy hitter, and start their rate from the count they earned
+    for (uint32_t i = 0; i < PROBE_STATS_TOP_DEVICES + 20; i++) probe_ssid(1000 + i, NULL);
+    probe_drain();
+    size_t n = probe_stats_top_devices(top, PROBE_STATS_TOP_DEVICES);
+    CHECK(n == PROBE_STATS_TOP_DEVICES && memcmp(top[0].mac, a, 6) == 0 && top[0].count == 11);
+    CHECK(memcmp(top[1].mac, b, 6) == 0);
+    for (size_t i = 2; i < n; i++) {
+        CHECK(top[i].count - top[i].error == 1 && top[i].per_minute == 1);
+    }
+    probe_stats_stop();
+}
+
+static uint32_t distinct_after(uint32_t devices, int repeats) {
+    probe_stats_t s;
+    probe_stats_start();
+    for (int r = 0; r < repeats; r++) {
+        for (uint32_t i = 0; i < devices; i++) {
+            probe_ssid(i * 7919, NULL);
+            if (i % 256 == 255) probe_drain();
+        }
+        probe_drain();
+    }
+    probe_stats_get(&s);
+    probe_stats_stop();
+    return s.distinct;
+}
+
+// Standard error with 1024 registers is about 3%; allow about 3 sigma
+static void test_distinct(void) {
+    uint32_t d;
+    CHECK(distinct_after(0, 1) == 0);
+    d = distinct_after(100, 3);
+    CHECK(d >= 95 && d <= 105);
+    d = distinct_after(1000, 2);
+    CHECK(d >= 900 && d <= 1100);
+    d = distinct_after(20000, 1);
+    CHECK(d >= 18000 && d <= 22000);
+}
+
+// Frames arriving faster than the worker drains are dropped and counted;
+// nothing is recorded before start, after stop, or for other frame types
+static void test_drops(void) {
+    probe_stats_t s;
+    uint8_t mac[6];
+    make_mac(mac, 1);
+
+    probe(mac, "early", 5, -60);
+    CHECK(probe_stats_start() == ESP_OK);
+    CHECK(probe_stats_start() == ESP_ERR_INVALID_STATE);
+
+    int sent = PROBE_STATS_RING_SIZE / 8 + 16;
+    for (int i = 0; i < sent; i++) probe(mac, NULL, 0, -60);
+    probe_stats_get(&s);
+    CHECK(s.dropped > 0 && s.probes == 0);
+    uint32_t dropped = s.dropped;
+    probe_drain();
+    probe_stats_get(&s);
+    CHECK(s.probes + dropped == (uint32_t)sent);
+
+    // A beacon carries an SSID element too
+    static union {
+        wifi_promiscuous_pkt_t pkt;
+        uint8_t bytes[sizeof(wifi_promiscuous_pkt_t) + 64];
+    } beacon;
+    memset(&beacon, 0, sizeof(beacon));
+    beacon.pkt.payload[0] = 0x80;
+    beacon.pkt.payload[36] = WIFI_IE_SSID;
+    beacon.pkt.rx_ctrl.sig_len = 38 + 4;
+    probe_stats_note_frame(&beacon.pkt);
+    probe_drain();
+    probe_stats_get(&s);
+    CHECK(s.probes + dropped == (uint32_t)sent);
+
+    probe_stats_stop();
+    probe(mac, "late", 4, -60);
+    probe_stats_get(&s);
+    CHECK(s.probes + dropped == (uint32_t)sent && s.dropped == dropped);
+}
+
+int main(void) {
+    test_ssids();
+    test_ssid_overflow();
+    test_devices();
+    test_distinct();
+    test_drops();
+    return host_test_report();
+}
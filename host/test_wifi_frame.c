@@ -0,0 +1,393 @@
+// Unit tests for the inline parser in wifi_frame.h. Frames are built byte by
+// byte; every parse gets a heap copy of exactly len bytes so the sanitizer
+// build catches a read past the received length. The last check feeds
+// every prefix of every frame in the fixture capture through the parser.
+#include "wifi_frame.h"
+#include "pcap_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+static int checks = 0;
+
+#define CHECK(cond) do { \
+    checks++; \
+    if (!(cond)) { \
+        failures++; \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+static const uint8_t AP[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+static const uint8_t STA[6] = {0x02, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE};
+static const uint8_t WDS[6] = {0x02, 0x10, 0x20, 0x30, 0x40, 0x50};
+static const uint8_t BCAST[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t LLC_EAPOL[8] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8E};
+
+typedef struct {
+    uint8_t data[256];
+    size_t len;
+} frame_buf_t;
+
+static void put(frame_buf_t* b, const void* data, size_t len) {
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void put_byte(frame_buf_t* b, uint8_t v) {
+    b->data[b->len++] = v;
+}
+
+static void put_ie(frame_buf_t* b, uint8_t id, const void* data, uint8_t len) {
+    put_byte(b, id);
+    put_byte(b, len);
+    put(b, data, len);
+}
+
+static void put_header(frame_buf_t* b, uint8_t type, uint8_t subtype, uint8_t flags,
+                       const uint8_t* a1, const uint8_t* a2, const uint8_t* a3) {
+    b->len = 0;
+    put_byte(b, (subtype << 4) | (type << 2));
+    put_byte(b, flags);
+    put_byte(b, 0);
+    put_byte(b, 0);
+    put(b, a1, 6);
+    put(b, a2, 6);
+    put(b, a3, 6);
+    put_byte(b, 0);
+    put_byte(b, 0);
+}
+
+static void make_beacon(frame_buf_t* b, const char* ssid) {
+    static const uint8_t fixed[12] = {[8] = 100, [10] = 0x31, [11] = 0x04};
+    static const uint8_t channel = 6;
+    put_header(b, WIFI_FRAME_TYPE_MGMT, WIFI_MGMT_BEACON, 0, BCAST, AP, AP);
+    put(b, fixed, sizeof(fixed));
+    put_ie(b, WIFI_IE_SSID, ssid, strlen(ssid));
+    put_ie(b, WIFI_IE_DS_PARAMS, &channel, 1);
+}
+
+// QoS data carrying an EAPOL LLC header, optionally WDS and/or HT control
+static void make_qos_eapol(frame_buf_t* b, uint8_t flags) {
+    put_header(b, WIFI_FRAME_TYPE_DATA, 0x8, flags, STA, AP, AP);
+    if ((flags & (WIFI_FC_TO_DS | WIFI_FC_FROM_DS)) == (WIFI_FC_TO_DS | WIFI_FC_FROM_DS)) {
+        put(b, WDS, 6);
+    }
+    put_byte(b, 0x06);
+    put_byte(b, 0);
+    if (flags & WIFI_FC_ORDER) {
+        static const uint8_t htc[4] = {0};
+        put(b, htc, 4);
+    }
+    put(b, LLC_EAPOL, sizeof(LLC_EAPOL));
+    static const uint8_t key[4] = {0x02, 0x03, 0x00, 0x5F};
+    put(b, key, sizeof(key));
+}
+
+// Parses an exact-size heap copy of the first len bytes. The copy lives
+// until the next parse so the pointers in f stay valid.
+static uint8_t* parsed_copy = NULL;
+
+static bool parse(wifi_frame_t* f, const frame_buf_t* b, size_t len) {
+    free(parsed_copy);
+    parsed_copy = malloc(len ? len : 1);
+    memcpy(parsed_copy, b->data, len);
+    return wifi_frame_parse(f, parsed_copy, len);
+}
+
+static void test_short_frames(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+
+    make_beacon(&b, "lab");
+    for (size_t len = 0; len < 10; len++) {
+        CHECK(!parse(&f, &b, len));
+        CHECK(f.data == NULL);
+    }
+    // Management and data headers are 24 bytes
+    for (size_t len = 10; len < 24; len++) {
+        CHECK(!parse(&f, &b, len));
+        CHECK(f.addr2 == NULL && f.body == NULL);
+    }
+    CHECK(parse(&f, &b, 24));
+    CHECK(f.hdr_len == 24 && f.body_len == 0);
+}
+
+static void test_qos_header_lengths(void) {
+    static const struct {
+        uint8_t flags;
+        size_t hdr_len;
+    } variants[] = {
+        {WIFI_FC_FROM_DS, 26},                                      // QoS control
+        {WIFI_FC_FROM_DS | WIFI_FC_ORDER, 30},                      // + HT control
+        {WIFI_FC_TO_DS | WIFI_FC_FROM_DS, 32},                      // + addr4
+        {WIFI_FC_TO_DS | WIFI_FC_FROM_DS | WIFI_FC_ORDER, 36},
+    };
+
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        frame_buf_t b;
+        wifi_frame_t f;
+        size_t hdr = variants[i].hdr_len;
+
+        make_qos_eapol(&b, variants[i].flags);
+        for (size_t len = 24; len < hdr; len++) {
+            CHECK(!parse(&f, &b, len));
+        }
+
+        CHECK(parse(&f, &b, hdr));
+        CHECK(f.hdr_len == hdr && f.body_len == 0);
+        CHECK(!wifi_frame_is_eapol(&f));
+
+        CHECK(parse(&f, &b, b.len));
+        CHECK(f.qos == f.data + hdr - 2 - (f.htc ? 4 : 0));
+        CHECK((f.htc != NULL) == ((variants[i].flags & WIFI_FC_ORDER) != 0));
+        CHECK((f.addr4 != NULL) == (hdr == 32 || hdr == 36));
+        CHECK(f.body == f.data + hdr && f.body_len == b.len - hdr);
+        CHECK(wifi_frame_is_eapol(&f));
+        CHECK(wifi_frame_bssid(&f) == (f.addr4 ? NULL : f.addr2));
+
+        // One byte short of the LLC header
+        CHECK(parse(&f, &b, hdr + sizeof(LLC_EAPOL) - 1));
+        CHECK(!wifi_frame_is_eapol(&f));
+    }
+
+    // Order on a non-QoS data frame does not add HT control
+    frame_buf_t b;
+    wifi_frame_t f;
+    put_header(&b, WIFI_FRAME_TYPE_DATA, 0x0, WIFI_FC_ORDER, STA, AP, AP);
+    put(&b, LLC_EAPOL, sizeof(LLC_EAPOL));
+    CHECK(parse(&f, &b, b.len));
+    CHECK(f.htc == NULL && f.qos == NULL && f.hdr_len == 24);
+    CHECK(wifi_frame_is_eapol(&f));
+
+    // Order on a management frame does
+    make_beacon(&b, "lab");
+    b.data[1] = WIFI_FC_ORDER;
+    CHECK(!parse(&f, &b, 27));
+    CHECK(parse(&f, &b, b.len));
+    CHECK(f.htc == f.data + 24 && f.hdr_len == 28);
+}
+
+static void test_control_frames(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+
+    // ACK and CTS: receiver address only
+    for (uint8_t subtype = 0xC; subtype <= 0xD; subtype++) {
+        b.len = 0;
+        put_byte(&b, (subtype << 4) | (WIFI_FRAME_TYPE_CTRL << 2));
+        put_byte(&b, 0);
+        put_byte(&b, 0);
+        put_byte(&b, 0);
+        put(&b, STA, 6);
+        CHECK(parse(&f, &b, b.len));
+        CHECK(f.type == WIFI_FRAME_TYPE_CTRL && f.hdr_len == 10);
+        CHECK(f.addr1 == f.data + 4 && f.addr2 == NULL && f.addr3 == NULL);
+        CHECK(wifi_frame_bssid(&f) == NULL);
+        CHECK(!wifi_frame_ies(&f, &(wifi_ie_iter_t){0}));
+    }
+
+    // RTS: transmitter address in addr2, which a short frame must not expose
+    b.len = 0;
+    put_byte(&b, (0xB << 4) | (WIFI_FRAME_TYPE_CTRL << 2));
+    put_byte(&b, 0);
+    put_byte(&b, 0);
+    put_byte(&b, 0);
+    put(&b, AP, 6);
+    put(&b, STA, 6);
+    for (size_t len = 10; len < 16; len++) {
+        CHECK(!parse(&f, &b, len));
+        CHECK(f.addr2 == NULL);
+    }
+    CHECK(parse(&f, &b, b.len));
+    CHECK(f.addr2 == f.data + 10 && memcmp(f.addr2, STA, 6) == 0);
+    CHECK(f.addr3 == NULL && f.hdr_len == 16);
+    CHECK(wifi_frame_bssid(&f) == NULL);
+}
+
+static void test_ie_walk(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+    wifi_ie_iter_t it;
+    wifi_ie_t ie;
+    char ssid[33];
+
+    make_beacon(&b, "lab");
+    CHECK(parse(&f, &b, b.len));
+    CHECK(wifi_frame_ssid(&f, ssid) == 3 && strcmp(ssid, "lab") == 0);
+    CHECK(wifi_frame_ds_channel(&f) == 6);
+    CHECK(!wifi_frame_find_ie(&f, WIFI_IE_RSN, &ie));
+
+    // Fixed fields incomplete: no IEs rather than a walk from inside them
+    CHECK(parse(&f, &b, 24 + 11));
+    CHECK(!wifi_frame_ies(&f, &it));
+    CHECK(!wifi_ie_next(&it, &ie));
+    CHECK(wifi_frame_ssid(&f, ssid) == -1 && ssid[0] == '\0');
+
+    // An element whose length runs past the frame ends the walk: the DS
+    // Parameter Set cut after its ID and after its length byte
+    for (size_t len = b.len - 2; len < b.len; len++) {
+        CHECK(parse(&f, &b, len));
+        CHECK(wifi_frame_ies(&f, &it));
+        CHECK(wifi_ie_next(&it, &ie) && ie.id == WIFI_IE_SSID && ie.len == 3);
+        CHECK(!wifi_ie_next(&it, &ie));
+        CHECK(!wifi_ie_next(&it, &ie));
+        CHECK(wifi_frame_ds_channel(&f) == 0);
+    }
+
+    // Length byte claiming 255 bytes of a 3 byte remainder
+    b.data[24 + 12 + 1] = 255;
+    CHECK(parse(&f, &b, b.len));
+    CHECK(wifi_frame_ies(&f, &it));
+    CHECK(!wifi_ie_next(&it, &ie));
+    CHECK(wifi_frame_ssid(&f, ssid) == -1);
+
+    // SSID elements longer than 32 bytes are invalid
+    make_beacon(&b, "0123456789abcdef0123456789abcdefX");
+    CHECK(parse(&f, &b, b.len));
+    CHECK(wifi_frame_ssid(&f, ssid) == -1 && ssid[0] == '\0');
+    CHECK(wifi_frame_ds_channel(&f) == 6);
+
+    // Vendor element matching
+    static const uint8_t wpa[6] = {0x00, 0x50, 0xF2, 0x01, 0x01, 0x00};
+    static const uint8_t ms_oui[3] = {0x00, 0x50, 0xF2};
+    make_beacon(&b, "lab");
+    put_ie(&b, WIFI_IE_VENDOR, wpa, sizeof(wpa));
+    put_ie(&b, WIFI_IE_VENDOR, wpa, 3);
+    CHECK(parse(&f, &b, b.len));
+    CHECK(wifi_frame_ies(&f, &it));
+    int vendor = 0, wpa_ies = 0;
+    while (wifi_ie_next(&it, &ie)) {
+        if (ie.id != WIFI_IE_VENDOR) continue;
+        vendor++;
+        if (wifi_ie_is_vendor(&ie, ms_oui, 0x01)) wpa_ies++;
+    }
+    CHECK(vendor == 2 && wpa_ies == 1);
+}
+
+static void test_fixed_lengths(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+    wifi_ie_iter_t it;
+    wifi_ie_t ie;
+    static const uint8_t no_ies[] = {
+        WIFI_MGMT_DISASSOC, WIFI_MGMT_DEAUTH, WIFI_MGMT_ACTION, 0x6, 0x7, 0x9, 0xE, 0xF
+    };
+
+    // Subtypes without IEs never start a walk, whatever follows the header
+    for (size_t i = 0; i < sizeof(no_ies) / sizeof(no_ies[0]); i++) {
+        CHECK(wifi_mgmt_fixed_len(no_ies[i]) == SIZE_MAX);
+        put_header(&b, WIFI_FRAME_TYPE_MGMT, no_ies[i], 0, STA, AP, AP);
+        put_ie(&b, WIFI_IE_SSID, "lab", 3);
+        CHECK(parse(&f, &b, b.len));
+        CHECK(!wifi_frame_ies(&f, &it));
+        CHECK(it.pos == NULL && !wifi_ie_next(&it, &ie));
+        CHECK(!wifi_frame_find_ie(&f, WIFI_IE_SSID, &ie));
+    }
+
+    // Nor do data frames
+    make_qos_eapol(&b, WIFI_FC_FROM_DS);
+    CHECK(parse(&f, &b, b.len));
+    CHECK(!wifi_frame_ies(&f, &it));
+
+    // Probe requests have no fixed fields, the IEs start at the body
+    put_header(&b, WIFI_FRAME_TYPE_MGMT, WIFI_MGMT_PROBE_REQ, 0, BCAST, STA, BCAST);
+    put_ie(&b, WIFI_IE_SSID, "", 0);
+    CHECK(parse(&f, &b, b.len));
+    CHECK(wifi_frame_ies(&f, &it) && it.pos == f.body);
+    CHECK(wifi_ie_next(&it, &ie) && ie.id == WIFI_IE_SSID && ie.len == 0);
+}
+
+static void test_protected(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+    wifi_ie_iter_t it;
+    char ssid[33];
+
+    // Shared-key auth frame 3 is encrypted: its body is not IEs
+    put_header(&b, WIFI_FRAME_TYPE_MGMT, WIFI_MGMT_AUTH, WIFI_FC_PROTECTED, AP, STA, AP);
+    static const uint8_t iv_and_ciphertext[16] = {1, 2, 3, 0, WIFI_IE_SSID, 4, 'a', 'b', 'c', 'd'};
+    put(&b, iv_and_ciphertext, sizeof(iv_and_ciphertext));
+    CHECK(parse(&f, &b, b.len));
+    CHECK(!wifi_frame_ies(&f, &it));
+    CHECK(wifi_frame_ssid(&f, ssid) == -1);
+
+    // Protected data is never EAPOL even if the ciphertext looks like it
+    make_qos_eapol(&b, WIFI_FC_FROM_DS | WIFI_FC_PROTECTED);
+    CHECK(parse(&f, &b, b.len));
+    CHECK(memcmp(f.body, LLC_EAPOL, sizeof(LLC_EAPOL)) == 0);
+    CHECK(!wifi_frame_is_eapol(&f));
+}
+
+static void test_from_pkt(void) {
+    frame_buf_t b;
+    wifi_frame_t f;
+
+    make_beacon(&b, "lab");
+    wifi_promiscuous_pkt_t* pkt = calloc(1, sizeof(*pkt) + b.len + 4);
+    memcpy(pkt->payload, b.data, b.len);
+
+    // sig_len counts the FCS, which is not part of the body
+    pkt->rx_ctrl.sig_len = b.len + 4;
+    CHECK(wifi_frame_from_pkt(&f, pkt));
+    CHECK(f.len == b.len && f.body_len == b.len - 24);
+    CHECK(wifi_frame_ds_channel(&f) == 6);
+
+    for (unsigned len = 0; len < 4 + 10; len++) {
+        pkt->rx_ctrl.sig_len = len;
+        CHECK(!wifi_frame_from_pkt(&f, pkt));
+    }
+    free(pkt);
+
+    uint8_t* big = calloc(1, 0x10000);
+    CHECK(wifi_frame_parse(&f, big, 0xFFFF));
+    CHECK(!wifi_frame_parse(&f, big, 0x10000));
+    free(big);
+}
+
+// Every prefix of every captured frame, through every accessor
+static void test_fixture_prefixes(const pcap_frames_t* frames) {
+    for (size_t i = 0; i < frames->count; i++) {
+        const wifi_promiscuous_pkt_t* pkt = frames->pkts[i];
+        size_t full = pkt->rx_ctrl.sig_len - 4;
+
+        for (size_t len = 0; len <= full; len++) {
+            uint8_t* copy = malloc(len ? len : 1);
+            memcpy(copy, pkt->payload, len);
+
+            wifi_frame_t f;
+            wifi_ie_t ie;
+            char ssid[33];
+            if (wifi_frame_parse(&f, copy, len)) {
+                CHECK(f.hdr_len + f.body_len == len);
+                wifi_frame_ssid(&f, ssid);
+                wifi_frame_ds_channel(&f);
+                wifi_frame_is_eapol(&f);
+                wifi_frame_bssid(&f);
+                wifi_frame_find_ie(&f, WIFI_IE_VENDOR, &ie);
+            }
+            free(copy);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    test_short_frames();
+    test_qos_header_lengths();
+    test_control_frames();
+    test_ie_walk();
+    test_fixed_lengths();
+    test_protected();
+    test_from_pkt();
+
+    if (argc > 1) {
+        pcap_frames_t frames;
+        if (!pcap_load(argv[1], &frames)) return 1;
+        test_fixture_prefixes(&frames);
+        pcap_free(&frames);
+    }
+
+    free(parsed_copy);
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+#include "airtime.h"
+#include "board_config.h"
+#include "channel_hopper.h"
+#include "promisc_mux.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char* TAG = "AIRTIME";
+
+#define SIG_MODE_LEGACY     0
+#define FC1_RETRY           0x08
+
+// Running totals per channel number, written only by the RX callback
+typedef struct {
+    uint32_t frames;
+    uint32_t retries;
+    uint32_t airtime_us;
+    uint32_t noise_sum;         // sum of -noise_floor
+} counters_t;
+
+// One sweep's share of a channel
+typedef struct {
+    uint32_t airtime_us;
+    uint16_t listen_ms;
+    uint16_t frames;
+    uint16_t retries;
+    uint8_t noise;              // mean -noise_floor, 0 = no frames
+} bucket_t;
+
+// wifi_phy_rate_t legacy codes in 500 kbit/s units; 0 = unknown
+static const uint8_t legacy_rate[32] = {
+    [0x00] = 2,  [0x01] = 4,  [0x02] = 11, [0x03] = 22,     // DSSS/CCK, long preamble
+    [0x05] = 4,  [0x06] = 11, [0x07] = 22,                  // short preamble
+    [0x08] = 96, [0x09] = 48, [0x0A] = 24, [0x0B] = 12,     // OFDM
+    [0x0C] = 108, [0x0D] = 72, [0x0E] = 36, [0x0F] = 18
+};
+
+// HT data bits per symbol, one spatial stream, MCS 0-7
+static const uint16_t ht_bits_20[8] = {26, 52, 78, 104, 156, 208, 234, 260};
+static const uint16_t ht_bits_40[8] = {54, 108, 162, 216, 324, 432, 486, 540};
+
+static counters_t live[AIRTIME_MAX_CHANNELS + 1];
+static counters_t last[AIRTIME_MAX_CHANNELS + 1];
+static uint32_t last_dwell[AIRTIME_MAX_CHANNELS + 1];
+
+static bucket_t buckets[AIRTIME_BUCKETS][AIRTIME_MAX_CHANNELS + 1];
+static uint8_t bucket_head;
+static uint8_t bucket_fill;
+static uint32_t sweeps;
+static uint8_t channels[AIRTIME_MAX_CHANNELS];
+static uint8_t channel_count;
+
+static bool running = false;
+static bool owns_hopper = false;
+static portMUX_TYPE bucket_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t IRAM_ATTR div_ceil(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+// On-air time of one PPDU in microseconds, 0 when the rate is not known
+static uint32_t IRAM_ATTR frame_airtime_us(const wifi_pkt_rx_ctrl_t* rx) {
+    uint32_t bits = 16 + 8 * rx->sig_len + 6;   // SERVICE + PSDU + tail
+
+    if (rx->sig_mode == SIG_MODE_LEGACY) {
+        uint32_t half_mbps = legacy_rate[rx->rate & 0x1F];
+        if (half_mbps == 0) return 0;
+        if (rx->rate <= 0x07) {
+            uint32_t preamble = rx->rate <= 0x03 ? 192 : 96;
+            return preamble + div_ceil(16 * rx->sig_len, half_mbps);
+        }
+        // 2 * Mbps data bits per 4 us symbol
+        return 20 + 4 * div_ceil(bits, 2 * half_mbps);
+    }
+
+    // HT mixed format: legacy + HT preamble, then 4 us (3.6 us SGI) symbols
+    const uint16_t* table = rx->cwb ? ht_bits_40 : ht_bits_20;
+    uint32_t symbols = div_ceil(bits, table[rx->mcs & 0x07]);
+    return 36 + (rx->sgi ? div_ceil(symbols * 36, 10) : symbols * 4);
+}
+
+static void IRAM_ATTR airtime_rx(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    uint8_t ch = pkt->rx_ctrl.channel;
+    if (ch == 0 || ch > AIRTIME_MAX_CHANNELS) return;
+
+    counters_t* c = &live[ch];
+    c->frames++;
+    c->airtime_us += frame_airtime_us(&pkt->rx_ctrl);
+    if (pkt->rx_ctrl.noise_floor < 0) {
+        c->noise_sum += (uint32_t)(-pkt->rx_ctrl.noise_floor);
+    }
+    if (type != WIFI_PKT_MISC && pkt->rx_ctrl.sig_len >= 2 && (pkt->payload[1] & FC1_RETRY)) {
+        c->retries++;
+    }
+}
+
+static uint16_t clamp16(uint32_t v) {
+    return v > UINT16_MAX ? UINT16_MAX : v;
+}
+
+// Closes a bucket from the counters gathered since the previous sweep
+static void on_sweep(const channel_hopper_stats_t* stats, void* ctx) {
+    bucket_t next[AIRTIME_MAX_CHANNELS + 1];
+    memset(next, 0, sizeof(next));
+
+    uint8_t count = 0;
+    uint8_t order[AIRTIME_MAX_CHANNELS];
+    for (int i = 0; i < stats->channel_count; i++) {
+        uint8_t ch = stats->channels[i].channel;
+        if (ch == 0 || ch > AIRTIME_MAX_CHANNELS) continue;
+
+        counters_t now = live[ch];
+        uint32_t frames = now.frames - last[ch].frames;
+        next[ch].airtime_us = now.airtime_us - last[ch].airtime_us;
+        next[ch].listen_ms = clamp16(stats->channels[i].total_dwell_ms - last_dwell[ch]);
+        next[ch].frames = clamp16(frames);
+        next[ch].retries = clamp16(now.retries - last[ch].retries);
+        if (frames) {
+            next[ch].noise = (now.noise_sum - last[ch].noise_sum) / frames;
+        }
+        last[ch] = now;
+        last_dwell[ch] = stats->channels[i].total_dwell_ms;
+        order[count++] = ch;
+    }
+
+    portENTER_CRITICAL(&bucket_lock);
+    memcpy(buckets[bucket_head], next, sizeof(next));
+    bucket_head = (bucket_head + 1) % AIRTIME_BUCKETS;
+    if (bucket_fill < AIRTIME_BUCKETS) bucket_fill++;
+    memcpy(channels, order, count);
+    channel_count = count;
+    sweeps++;
+    portEXIT_CRITICAL(&bucket_lock);
+}
+
+esp_err_t airtime_start(void) {
+    if (running) return ESP_OK;
+
+    memset(live, 0, sizeof(live));
+    memset(last, 0, sizeof(last));
+    memset(buckets, 0, sizeof(buckets));
+    bucket_head = 0;
+    bucket_fill = 0;
+    sweeps = 0;
+    channel_count = 0;
+
+    // Joining a hopper mid-run: only count dwell from here on
+    channel_hopper_stats_t stats;
+    channel_hopper_get_stats(&stats);
+    memset(last_dwell, 0, sizeof(last_dwell));
+    for (int i = 0; i < stats.channel_count; i++) {
+        if (stats.channels[i].channel <= AIRTIME_MAX_CHANNELS) {
+            last_dwell[stats.channels[i].channel] = stats.channels[i].total_dwell_ms;
+        }
+    }
+
+    esp_err_t ret = channel_hopper_subscribe(on_sweep, NULL);
+    if (ret != ESP_OK) return ret;
+
+    promisc_filter_t filter = {
+        .types = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_CTRL |
+                 WIFI_PROMIS_FILTER_MASK_DATA | WIFI_PROMIS_FILTER_MASK_MISC
+    };
+    ret = promisc_subscribe(airtime_rx, &filter, NULL);
+    if (ret != ESP_OK) {
+        channel_hopper_unsubscribe(on_sweep);
+        return ret;
+    }
+
+    owns_hopper = false;
+    if (!channel_hopper_is_running()) {
+        channel_hopper_config_t config = {
+            .dwell_ms = AIRTIME_DWELL_MS,
+            .adaptive = false
+        };
+        ret = channel_hopper_start(&config);
+        if (ret != ESP_OK) {
+            promisc_unsubscribe(airtime_rx);
+            channel_hopper_unsubscribe(on_sweep);
+            return ret;
+        }
+        memset(last_dwell, 0, sizeof(last_dwell));
+        owns_hopper = true;
+    }
+
+    running = true;
+    ESP_LOGI(TAG, "Analyzer started (%s hopper)", owns_hopper ? "own" : "shared");
+    return ESP_OK;
+}
+
+void airtime_stop(void) {
+    if (!running) return;
+
+    if (owns_hopper) {
+        channel_hopper_stop();
+        owns_hopper = false;
+    }
+    channel_hopper_unsubscribe(on_sweep);
+    promisc_unsubscribe(airtime_rx);
+    running = false;
+    ESP_LOGI(TAG, "Analyzer stopped after %lu sweeps", (unsigned long)sweeps);
+}
+
+bool airtime_is_running(void) {
+    return running;
+}
+
+void airtime_get_report(airtime_report_t* report) {
+    memset(report, 0, sizeof(*report));
+
+    portENTER_CRITICAL(&bucket_lock);
+    report->sweeps = sweeps;
+    report->channel_count = channel_count;
+    for (int i = 0; i < channel_count; i++) {
+        uint8_t ch = channels[i];
+        uint64_t airtime_us = 0;
+        uint32_t listen_ms = 0, frames = 0, retries = 0, noise = 0, noisy = 0;
+
+        for (int b = 0; b < bucket_fill; b++) {
+            const bucket_t* k = &buckets[b][ch];
+            airtime_us += k->airtime_us;
+            listen_ms += k->listen_ms;
+            frames += k->frames;
+            retries += k->retries;
+            if (k->noise) {
+                noise += k->noise;
+                noisy++;
+            }
+        }
+
+        airtime_channel_t* out = &report->channels[i];
+        out->channel = ch;
+        out->listen_ms = listen_ms;
+        if (listen_ms) {
+            // us per ms is already per-mille of the listen time
+            uint64_t busy = airtime_us / listen_ms;
+            out->busy_permille = busy > 1000 ? 1000 : busy;
+            out->frames_per_s = clamp16((uint64_t)frames * 1000 / listen_ms);
+        }
+        if (frames) {
+            out->retry_permille = (uint64_t)retries * 1000 / frames;
+        }
+        if (noisy) {
+            out->noise_floor = -(int)(noise / noisy);
+        }
+    }
+    portEXIT_CRITICAL(&bucket_lock);
+}
@@ -0,0 +1,39 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Passive 2.4 GHz channel utilization. While running, every frame the radio
+// hears is charged to its channel as on-air time, worked out from its
+// length and PHY rate (legacy rate code, or HT MCS/bandwidth/guard
+// interval). The channel hopper parks on each channel in turn. After each
+// sweep the per-channel totals are closed into a bucket, and reports cover
+// the last AIRTIME_BUCKETS sweeps. All figures are integers in per-mille
+// or per-second units.
+#define AIRTIME_MAX_CHANNELS 14
+
+typedef struct {
+    uint8_t channel;
+    uint16_t busy_permille;     // share of listen time the medium was busy
+    uint16_t frames_per_s;
+    uint16_t retry_permille;    // frames with the retry bit set
+    int8_t noise_floor;         // dBm, 0 when nothing was heard
+    uint32_t listen_ms;         // time parked on the channel within the window
+} airtime_channel_t;
+
+typedef struct {
+    uint32_t sweeps;
+    uint8_t channel_count;
+    airtime_channel_t channels[AIRTIME_MAX_CHANNELS];
+} airtime_report_t;
+
+// Takes promiscuous frames from the mux and hops with a fixed dwell; if the
+// hopper is already running, its sweeps are used as they are
+esp_err_t airtime_start(void);
+void airtime_stop(void);
+bool airtime_is_running(void);
+void airtime_get_report(airtime_report_t* report);
+
+#endif // AIRTIME_H
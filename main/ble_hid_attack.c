@@ -1,6 +1,5 @@
 #include "ble_hid_attack.h"
-#include "esp_bt.h"
-#include "esp_bt_main.h"
+#include "ble_radio.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gatts_api.h"
 #include "esp_log.h"
@@ -76,11 +75,7 @@ void ble_hid_keyboard_attack(void) {
     display_draw_text(10, 40, "Setting up HID device...", COLOR_BLUE, COLOR_BLACK);
     
     // Initialize BLE
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-    esp_bt_controller_init(&bt_cfg);
-    esp_bt_controller_enable(ESP_BT_MODE_BLE);
-    esp_bluedroid_init();
-    esp_bluedroid_enable();
+    ble_radio_init();
     
     // Register GATT server callback
     esp_ble_gatts_register_callback(ble_hid_gatts_cb);
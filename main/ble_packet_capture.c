@@ -1,14 +1,20 @@
 #include "ble_packet_capture.h"
-#include "esp_bt.h"
-#include "esp_bt_main.h"
-#include "esp_gap_ble_api.h"
+#include "ble_radio.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "display.h"
 #include "touchscreen.h"
 #include "packet_logger.h"
+#include "spsc_ring.h"
+#include "capture_writer.h"
+#include "pcapng.h"
+#include "board_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 static const char* TAG = "BLE_CAPTURE";
 
@@ -16,87 +22,330 @@ void ble_log_info(const char* msg) {
     ESP_LOGI(TAG, "%s", msg);
 }
 
-typedef struct {
-    uint8_t addr[6];
-    uint8_t data[31];
-    uint8_t data_len;
-    int8_t rssi;
-    uint32_t timestamp;
-} ble_packet_t;
-
-static ble_packet_t captured_packets[100];
-static int packet_count = 0;
-static FILE* capture_file = NULL;
-
-static void ble_capture_callback(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
-    if (event == ESP_GAP_BLE_SCAN_RESULT_EVT) {
-        esp_ble_gap_cb_param_t *scan_result = param;
-        if (scan_result->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
-            
-            if (packet_count < 100) {
-                // Store packet
-                memcpy(captured_packets[packet_count].addr, scan_result->scan_rst.bda, 6);
-                captured_packets[packet_count].rssi = scan_result->scan_rst.rssi;
-                captured_packets[packet_count].data_len = scan_result->scan_rst.adv_data_len;
-                captured_packets[packet_count].timestamp = esp_timer_get_time() / 1000;
-                
-                if (scan_result->scan_rst.adv_data_len > 0) {
-                    memcpy(captured_packets[packet_count].data, 
-                           scan_result->scan_rst.ble_adv, 
-                           scan_result->scan_rst.adv_data_len > 31 ? 31 : scan_result->scan_rst.adv_data_len);
-                }
-                
-                // Write to file if open
-                if (capture_file) {
-                    fprintf(capture_file, "%lu,%02X:%02X:%02X:%02X:%02X:%02X,%d,%d,",
-                            captured_packets[packet_count].timestamp,
-                            scan_result->scan_rst.bda[0], scan_result->scan_rst.bda[1],
-                            scan_result->scan_rst.bda[2], scan_result->scan_rst.bda[3],
-                            scan_result->scan_rst.bda[4], scan_result->scan_rst.bda[5],
-                            scan_result->scan_rst.rssi, scan_result->scan_rst.adv_data_len);
-                    
-                    // Write hex data
-                    for (int i = 0; i < scan_result->scan_rst.adv_data_len && i < 31; i++) {
-                        fprintf(capture_file, "%02X", scan_result->scan_rst.ble_adv[i]);
-                    }
-                    fprintf(capture_file, "\n");
-                    fflush(capture_file);
-                }
-                
-                packet_count++;
+// The scan callback runs in the Bluedroid task, so it only encodes the
+// record into the ring; the writer task batches the ring into the file
+#define BLE_CAPTURE_MAX_RECORD  (1 + 10 + 6 + 3 + 2 + 62)
+#define BLE_WRITER_CORE         1
+#define BLE_WRITER_POLL_MS      50
+
+// LE pseudo-header and advertising channel PDU fields
+#define LE_ADV_ACCESS_ADDRESS   0x8E89BED6
+#define LE_PHDR_LEN             10
+#define LE_PHDR_DEWHITENED      0x0001
+#define LE_PHDR_SIGNAL_VALID    0x0002
+#define LE_PHDR_REF_AA_VALID    0x0010
+#define LE_PHDR_CRC_CHECKED     0x0400
+#define LE_PHDR_CRC_VALID       0x0800
+#define LE_PDU_ADV_IND          0x0
+#define LE_PDU_ADV_DIRECT_IND   0x1
+#define LE_PDU_ADV_NONCONN_IND  0x2
+#define LE_PDU_SCAN_RSP         0x4
+#define LE_PDU_ADV_SCAN_IND     0x6
+#define LE_PDU_TXADD_RANDOM     0x40
+#define LE_ADV_CRC_INIT         0x555555
+#define LE_MAX_ADV_DATA         31
+#define LE_PACKET_MAX           (LE_PHDR_LEN + 4 + 2 + 12 + LE_MAX_ADV_DATA + 3)
+
+// esp_ble_evt_type_t to advertising PDU type
+static const uint8_t le_pdu_types[] = {
+    LE_PDU_ADV_IND, LE_PDU_ADV_DIRECT_IND, LE_PDU_ADV_SCAN_IND,
+    LE_PDU_ADV_NONCONN_IND, LE_PDU_SCAN_RSP
+};
+
+static spsc_ring_t capture_ring;
+static capture_writer_t capture_file;
+static capture_writer_t pcap_file;
+static int64_t pcap_ts_us;                  // writer-private
+static volatile bool capture_active = false;
+static volatile uint32_t packet_count = 0;
+static int64_t last_record_us;              // producer-private
+static TaskHandle_t writer_task = NULL;
+static SemaphoreHandle_t writer_done = NULL;
+static volatile bool writer_stop = false;
+
+static void ble_capture_callback(esp_ble_gap_cb_param_t *scan_result, void* ctx) {
+    if (!capture_active) {
+        return;
+    }
+    
+    uint8_t* rec = spsc_ring_reserve(&capture_ring, BLE_CAPTURE_MAX_RECORD);
+    if (rec == NULL) {
+        return;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    uint64_t delta = now - last_record_us;
+    last_record_us = now;
+    
+    size_t pos = 1;
+    do {
+        rec[pos++] = (delta & 0x7F) | (delta > 0x7F ? 0x80 : 0);
+        delta >>= 7;
+    } while (delta);
+    
+    uint8_t adv_len = scan_result->scan_rst.adv_data_len;
+    uint8_t rsp_len = scan_result->scan_rst.scan_rsp_len;
+    if (adv_len + rsp_len > sizeof(scan_result->scan_rst.ble_adv)) {
+        adv_len = rsp_len = 0;
+    }
+    
+    memcpy(&rec[pos], scan_result->scan_rst.bda, 6);
+    pos += 6;
+    rec[pos++] = (scan_result->scan_rst.ble_addr_type & 0x0F) | (scan_result->scan_rst.ble_evt_type << 4);
+    rec[pos++] = (uint8_t)(int8_t)scan_result->scan_rst.rssi;
+    rec[pos++] = adv_len;
+    rec[pos++] = rsp_len;
+    memcpy(&rec[pos], scan_result->scan_rst.ble_adv, adv_len + rsp_len);
+    pos += adv_len + rsp_len;
+    
+    rec[0] = pos - 1;
+    spsc_ring_commit(&capture_ring, pos);
+    packet_count++;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// CRC-24 of an LL PDU (poly x^24+x^10+x^9+x^6+x^4+x^3+x+1). The register is
+// kept bit-reversed so it comes out in air order: out[0] is the first byte
+// sent after the PDU
+static void le_crc24(const uint8_t* pdu, size_t len, uint32_t init, uint8_t out[3]) {
+    uint32_t state = 0;
+    for (int i = 0; i < 24; i++) {
+        if (init & (1u << i)) state |= 1u << (23 - i);
+    }
+    
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = pdu[i];
+        for (int bit = 0; bit < 8; bit++) {
+            bool feedback = (state ^ byte) & 1;
+            byte >>= 1;
+            state >>= 1;
+            if (feedback) {
+                state |= 1u << 23;
+                state ^= 0x5A6000;
+            }
+        }
+    }
+    out[0] = state;
+    out[1] = state >> 8;
+    out[2] = state >> 16;
+}
+
+// Builds pseudo-header + access address + PDU + CRC into out
+static size_t le_adv_packet(uint8_t* out, uint8_t pdu_type, bool random_addr, const uint8_t* addr,
+                            int8_t rssi, const uint8_t* data, uint8_t len) {
+    // The controller only reports PDUs that passed its CRC check, and the
+    // CRC written here is recomputed from the PDU
+    uint16_t flags = LE_PHDR_DEWHITENED | LE_PHDR_SIGNAL_VALID | LE_PHDR_REF_AA_VALID |
+                     LE_PHDR_CRC_CHECKED | LE_PHDR_CRC_VALID;
+    if (len > LE_MAX_ADV_DATA) len = LE_MAX_ADV_DATA;
+    
+    out[0] = 0;             // RF channel, not reported by the controller
+    out[1] = rssi;
+    out[2] = 0;             // noise power
+    out[3] = 0;             // access address offenses
+    put_le32(&out[4], LE_ADV_ACCESS_ADDRESS);
+    out[8] = flags;
+    out[9] = flags >> 8;
+    
+    uint8_t* ll = out + LE_PHDR_LEN;
+    size_t payload = 6 + (pdu_type == LE_PDU_ADV_DIRECT_IND ? 6 : len);
+    put_le32(ll, LE_ADV_ACCESS_ADDRESS);
+    ll[4] = pdu_type | (random_addr ? LE_PDU_TXADD_RANDOM : 0);
+    ll[5] = payload;
+    
+    // AdvA goes over the air least significant byte first
+    for (int i = 0; i < 6; i++) {
+        ll[6 + i] = addr[5 - i];
+    }
+    if (pdu_type == LE_PDU_ADV_DIRECT_IND) {
+        memset(&ll[12], 0, 6);      // TargetA is not reported either
+    } else {
+        memcpy(&ll[12], data, len);
+    }
+    le_crc24(&ll[4], 2 + payload, LE_ADV_CRC_INIT, &ll[6 + payload]);
+    return LE_PHDR_LEN + 6 + payload + 3;
+}
+
+static void pcap_append(uint8_t pdu_type, bool random_addr, const uint8_t* addr, int8_t rssi,
+                        const uint8_t* data, uint8_t len) {
+    uint8_t block[sizeof(pcapng_epb_t) + LE_PACKET_MAX + 3 + sizeof(uint32_t)];
+    
+    // The packet is built in place; the EPB header in front does not overlap it
+    uint32_t caplen = le_adv_packet(block + sizeof(pcapng_epb_t), pdu_type, random_addr,
+                                    addr, rssi, data, len);
+    pcapng_epb_begin(block, pcap_ts_us, caplen, caplen);
+    pcapng_epb_finish(block, caplen);
+    capture_writer_append(&pcap_file, block, pcapng_epb_len(caplen));
+}
+
+// Decodes a run of log records and writes their PDUs to the pcapng file.
+// A result carrying scan response data becomes two packets.
+static void pcap_write_records(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t rec_len = data[0] + 1;
+        size_t pos = 1;
+        uint64_t delta = 0;
+        int shift = 0;
+        while (data[pos] & 0x80) {
+            delta |= (uint64_t)(data[pos++] & 0x7F) << shift;
+            shift += 7;
+        }
+        delta |= (uint64_t)data[pos++] << shift;
+        pcap_ts_us += delta;
+        
+        const uint8_t* addr = &data[pos];
+        uint8_t info = data[pos + 6];
+        int8_t rssi = (int8_t)data[pos + 7];
+        uint8_t adv_len = data[pos + 8];
+        uint8_t rsp_len = data[pos + 9];
+        const uint8_t* adv = &data[pos + 10];
+        
+        uint8_t evt = info >> 4;
+        bool random_addr = (info & 0x0F) != 0;
+        uint8_t pdu_type = evt < sizeof(le_pdu_types) ? le_pdu_types[evt] : LE_PDU_ADV_IND;
+        if (pdu_type == LE_PDU_SCAN_RSP) {
+            // A bare scan response event carries its data in either field
+            pcap_append(pdu_type, random_addr, addr, rssi,
+                        adv_len ? adv : adv + adv_len, adv_len ? adv_len : rsp_len);
+        } else {
+            pcap_append(pdu_type, random_addr, addr, rssi, adv, adv_len);
+            if (rsp_len > 0) {
+                pcap_append(LE_PDU_SCAN_RSP, random_addr, addr, rssi, adv + adv_len, rsp_len);
             }
         }
+        
+        data += rec_len;
+        len -= rec_len;
+    }
+}
+
+static void capture_drain(void) {
+    const uint8_t* data;
+    size_t len;
+    
+    while ((len = spsc_ring_peek(&capture_ring, &data)) > 0) {
+        if (capture_writer_append(&capture_file, data, len) != ESP_OK) {
+            ESP_LOGE(TAG, "Write failed, dropping %u bytes", (unsigned)len);
+        }
+        if (pcap_file.fd >= 0) {
+            pcap_write_records(data, len);
+        }
+        spsc_ring_release(&capture_ring, len);
     }
 }
 
+static void capture_writer_task(void* arg) {
+    while (!writer_stop) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BLE_WRITER_POLL_MS));
+        capture_drain();
+        capture_writer_poll(&capture_file);
+        capture_writer_poll(&pcap_file);
+    }
+    
+    // Producer is detached by now; write whatever is left
+    capture_drain();
+    xSemaphoreGive(writer_done);
+    vTaskDelete(NULL);
+}
+
+// Opens <base>.blec and, best effort, <base>.pcapng
+static esp_err_t capture_open(const char* base) {
+    char path[72];
+    mkdir("/sdcard/logs", 0700);
+    
+    capture_writer_config_t file_config = {
+        .block_size = BLE_CAPTURE_BLOCK_SIZE,
+        .sync_bytes = BLE_CAPTURE_SYNC_BYTES,
+        .sync_ms = CAPTURE_SYNC_MS
+    };
+    snprintf(path, sizeof(path), "%s.blec", base);
+    if (capture_writer_open(&capture_file, path, &file_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open file: %s", path);
+        return ESP_FAIL;
+    }
+    
+    if (spsc_ring_init(&capture_ring, BLE_CAPTURE_RING_SIZE) != ESP_OK) {
+        capture_writer_close(&capture_file);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    snprintf(path, sizeof(path), "%s.pcapng", base);
+    if (capture_writer_open(&pcap_file, path, &file_config) == ESP_OK) {
+        uint8_t preamble[PCAPNG_PREAMBLE_LEN];
+        pcapng_write_preamble(preamble, LINKTYPE_BLUETOOTH_LE_LL_WITH_PHDR, 256);
+        capture_writer_append(&pcap_file, preamble, sizeof(preamble));
+    } else {
+        ESP_LOGW(TAG, "No pcapng output: %s", path);
+    }
+    
+    last_record_us = esp_timer_get_time();
+    uint8_t header[BLE_CAPTURE_HEADER_SIZE] = { 'B', 'L', 'E', 'C', BLE_CAPTURE_VERSION };
+    for (int i = 0; i < 8; i++) {
+        header[8 + i] = (uint64_t)last_record_us >> (8 * i);
+    }
+    capture_writer_append(&capture_file, header, sizeof(header));
+    pcap_ts_us = last_record_us;
+    
+    if (writer_done == NULL) {
+        writer_done = xSemaphoreCreateBinary();
+    }
+    writer_stop = false;
+    if (writer_done == NULL ||
+        xTaskCreatePinnedToCore(capture_writer_task, "ble_writer", 4096, NULL, 5,
+                                &writer_task, BLE_WRITER_CORE) != pdPASS) {
+        spsc_ring_deinit(&capture_ring);
+        capture_writer_close(&capture_file);
+        capture_writer_close(&pcap_file);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    packet_count = 0;
+    capture_active = true;
+    return ESP_OK;
+}
+
+static void capture_close(void) {
+    // Detach the producer first: once unsubscribe returns the callback is
+    // no longer running, so the ring can be drained and freed
+    capture_active = false;
+    ble_radio_unsubscribe(ble_capture_callback);
+    writer_stop = true;
+    xTaskNotifyGive(writer_task);
+    xSemaphoreTake(writer_done, portMAX_DELAY);
+    writer_task = NULL;
+    
+    capture_writer_close(&capture_file);
+    capture_writer_close(&pcap_file);
+    ESP_LOGI(TAG, "Capture stopped: %lu records, %lu dropped, %llu bytes",
+             (unsigned long)packet_count, (unsigned long)capture_ring.dropped,
+             (unsigned long long)capture_file.stats.bytes_written);
+    spsc_ring_deinit(&capture_ring);
+}
+
 void ble_packet_capture_start(void) {
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "BLE Packet Capture", COLOR_WHITE, COLOR_BLACK);
     display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
     display_draw_text(10, 40, "Capturing BLE packets...", COLOR_BLUE, COLOR_BLACK);
     
-    // Reset counters
-    packet_count = 0;
-    
     // Open capture file
     char filename[64];
-    snprintf(filename, sizeof(filename), "/sdcard/logs/ble_capture_%u.csv", 
+    snprintf(filename, sizeof(filename), "/sdcard/logs/ble_capture_%u", 
              (unsigned int)(esp_timer_get_time() / 1000000));
     
-    capture_file = fopen(filename, "w");
-    if (capture_file) {
-        fprintf(capture_file, "timestamp,mac_address,rssi,data_length,raw_data\n");
-        fflush(capture_file);
+    if (capture_open(filename) != ESP_OK) {
+        display_draw_text(10, 60, "Failed to open capture!", COLOR_RED, COLOR_BLACK);
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        return;
     }
     
-    // Initialize BLE
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-    esp_bt_controller_init(&bt_cfg);
-    esp_bt_controller_enable(ESP_BT_MODE_BLE);
-    esp_bluedroid_init();
-    esp_bluedroid_enable();
-    
-    esp_ble_gap_register_callback(ble_capture_callback);
+    esp_err_t ret = ble_radio_subscribe(ble_capture_callback, NULL, NULL);
     
     esp_ble_scan_params_t scan_params = {
         .scan_type = BLE_SCAN_TYPE_PASSIVE,
@@ -107,8 +356,16 @@ void ble_packet_capture_start(void) {
         .scan_duplicate = BLE_SCAN_DUPLICATE_ENABLE
     };
     
-    esp_ble_gap_set_scan_params(&scan_params);
-    esp_ble_gap_start_scanning(0); // Continuous scan
+    if (ret == ESP_OK) {
+        ret = ble_radio_scan_start(&scan_params, 0); // Continuous scan
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BLE scan failed: %s", esp_err_to_name(ret));
+        capture_close();
+        display_draw_text(10, 60, "BLE scan failed!", COLOR_RED, COLOR_BLACK);
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        return;
+    }
     
     // Cancel button
     display_fill_rect(160, 280, 70, 30, COLOR_RED);
@@ -134,23 +391,21 @@ void ble_packet_capture_start(void) {
         display_draw_text(10, 60, time_info, COLOR_BLUE, COLOR_BLACK);
         
         char packet_info[32];
-        snprintf(packet_info, sizeof(packet_info), "Packets: %d/100", packet_count);
+        snprintf(packet_info, sizeof(packet_info), "Packets: %lu", (unsigned long)packet_count);
         display_fill_rect(10, 80, 200, 15, COLOR_BLACK);
         display_draw_text(10, 80, packet_info, COLOR_GREEN, COLOR_BLACK);
         
-        if (packet_count >= 100) {
-            display_draw_text(10, 100, "Buffer full!", COLOR_RED, COLOR_BLACK);
+        if (capture_ring.dropped > 0) {
+            snprintf(packet_info, sizeof(packet_info), "Dropped: %lu", (unsigned long)capture_ring.dropped);
+            display_fill_rect(10, 100, 200, 15, COLOR_BLACK);
+            display_draw_text(10, 100, packet_info, COLOR_RED, COLOR_BLACK);
         }
         
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
-    esp_ble_gap_stop_scanning();
-    
-    if (capture_file) {
-        fclose(capture_file);
-        capture_file = NULL;
-    }
+    ble_radio_scan_stop();
+    capture_close();
     
     // Results screen
     display_fill_screen(COLOR_BLACK);
@@ -158,7 +413,7 @@ void ble_packet_capture_start(void) {
     display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
     
     char final_stats[48];
-    snprintf(final_stats, sizeof(final_stats), "Captured %d packets in %ds", packet_count, seconds);
+    snprintf(final_stats, sizeof(final_stats), "Captured %lu packets in %ds", (unsigned long)packet_count, seconds);
     display_draw_text(10, 40, final_stats, COLOR_GREEN, COLOR_BLACK);
     
     display_draw_text(10, 60, "Saved to SD card", COLOR_BLUE, COLOR_BLACK);
@@ -1,6 +1,36 @@
 #ifndef BLE_PACKET_CAPTURE_H
 #define BLE_PACKET_CAPTURE_H
 
+// BLE advertisement log written to /sdcard/logs/ble_capture_<n>.blec. The
+// scan callback encodes each result straight into a ring; a writer task
+// moves the ring into the file in whole blocks. tools/blecap2csv.py
+// converts a log to CSV.
+//
+// The writer task also rebuilds the link-layer advertising PDUs from each
+// record and writes them to ble_capture_<n>.pcapng for Wireshark
+// (LINKTYPE_BLUETOOTH_LE_LL_WITH_PHDR). The controller reports neither
+// the RF channel nor the CRC, so the channel reads 0 and the CRC is left
+// unchecked.
+//
+// File layout (integers little-endian):
+//   0   magic "BLEC"
+//   4   uint8 version (1), 3 bytes reserved
+//   8   uint64 esp_timer time of the capture start, microseconds
+//   16  records
+//
+// Record:
+//   uint8   length of the rest of the record
+//   varint  microseconds since the previous record (LEB128, first record
+//           counts from the header time)
+//   6       advertiser address, as reported by the controller
+//   uint8   address type (low nibble) | event type << 4
+//   int8    RSSI
+//   uint8   advertising data length, uint8 scan response length
+//   ..      advertising data, then scan response data
+#define BLE_CAPTURE_MAGIC           "BLEC"
+#define BLE_CAPTURE_VERSION         1
+#define BLE_CAPTURE_HEADER_SIZE     16
+
 void ble_packet_capture_start(void);
 
-#endif
\ No newline at end of file
+#endif // BLE_PACKET_CAPTURE_H
@@ -0,0 +1,209 @@
+#include "ble_radio.h"
+#include "esp_bt.h"
+#include "esp_bt_main.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char* TAG = "BLE_RADIO";
+
+typedef struct {
+    ble_scan_cb_t cb;
+    void* ctx;
+    ble_scan_filter_t filter;
+} subscriber_t;
+
+typedef enum {
+    SCAN_IDLE,
+    SCAN_STARTING,      // parameters sent, waiting for the stack to accept them
+    SCAN_RUNNING
+} scan_state_t;
+
+static bool radio_initialized = false;
+static subscriber_t subscribers[BLE_RADIO_MAX_SUBSCRIBERS];
+static scan_state_t scan_state = SCAN_IDLE;
+static uint32_t scan_duration_s = 0;
+static int scan_users = 0;
+static portMUX_TYPE radio_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Results arrive on the one Bluedroid task, so dispatches are numbered in
+// order; unsubscribe waits until every dispatch that could have copied the
+// leaving subscriber has finished
+static volatile uint32_t dispatch_started = 0;
+static volatile uint32_t dispatch_finished = 0;
+static TaskHandle_t dispatch_task = NULL;
+
+static bool filter_accepts(const ble_scan_filter_t* f, const esp_ble_gap_cb_param_t* param) {
+    if (f->prefix_len && memcmp(param->scan_rst.bda, f->prefix, f->prefix_len) != 0) {
+        return false;
+    }
+    return f->min_rssi == 0 || param->scan_rst.rssi >= f->min_rssi;
+}
+
+static void dispatch_result(esp_ble_gap_cb_param_t* param) {
+    // Snapshot so subscribers run without the lock and may unsubscribe
+    subscriber_t active[BLE_RADIO_MAX_SUBSCRIBERS];
+    portENTER_CRITICAL(&radio_lock);
+    memcpy(active, subscribers, sizeof(active));
+    uint32_t seq = ++dispatch_started;
+    dispatch_task = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&radio_lock);
+
+    for (int i = 0; i < BLE_RADIO_MAX_SUBSCRIBERS; i++) {
+        if (active[i].cb && filter_accepts(&active[i].filter, param)) {
+            active[i].cb(param, active[i].ctx);
+        }
+    }
+    dispatch_finished = seq;
+}
+
+static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+    switch (event) {
+        case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT: {
+            portENTER_CRITICAL(&radio_lock);
+            bool start = scan_state == SCAN_STARTING;
+            uint32_t duration = scan_duration_s;
+            portEXIT_CRITICAL(&radio_lock);
+
+            if (!start) break;
+            if (param->scan_param_cmpl.status != ESP_BT_STATUS_SUCCESS ||
+                esp_ble_gap_start_scanning(duration) != ESP_OK) {
+                ESP_LOGE(TAG, "Scan start failed");
+                scan_state = SCAN_IDLE;
+            }
+            break;
+        }
+        case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:
+            portENTER_CRITICAL(&radio_lock);
+            if (scan_state == SCAN_STARTING) {
+                scan_state = param->scan_start_cmpl.status == ESP_BT_STATUS_SUCCESS ? SCAN_RUNNING : SCAN_IDLE;
+            }
+            portEXIT_CRITICAL(&radio_lock);
+            break;
+        case ESP_GAP_BLE_SCAN_RESULT_EVT:
+            if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+                dispatch_result(param);
+            } else if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
+                // Scan duration elapsed; users still hold it until they stop
+                scan_state = SCAN_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t ble_radio_init(void) {
+    if (radio_initialized) return ESP_OK;
+
+    esp_err_t ret = ESP_OK;
+    if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_IDLE) {
+        esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+        ret = esp_bt_controller_init(&bt_cfg);
+    }
+    if (ret == ESP_OK && esp_bt_controller_get_status() != ESP_BT_CONTROLLER_STATUS_ENABLED) {
+        ret = esp_bt_controller_enable(ESP_BT_MODE_BLE);
+    }
+    if (ret == ESP_OK && esp_bluedroid_get_status() == ESP_BLUEDROID_STATUS_UNINITIALIZED) {
+        ret = esp_bluedroid_init();
+    }
+    if (ret == ESP_OK && esp_bluedroid_get_status() != ESP_BLUEDROID_STATUS_ENABLED) {
+        ret = esp_bluedroid_enable();
+    }
+    if (ret == ESP_OK) {
+        ret = esp_ble_gap_register_callback(gap_event_handler);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BLE init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    radio_initialized = true;
+    ESP_LOGI(TAG, "BLE radio initialized");
+    return ESP_OK;
+}
+
+esp_err_t ble_radio_subscribe(ble_scan_cb_t cb, const ble_scan_filter_t* filter, void* ctx) {
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    portENTER_CRITICAL(&radio_lock);
+    for (int i = 0; i < BLE_RADIO_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].cb == NULL) {
+            if (filter) {
+                subscribers[i].filter = *filter;
+            } else {
+                memset(&subscribers[i].filter, 0, sizeof(subscribers[i].filter));
+            }
+            subscribers[i].ctx = ctx;
+            subscribers[i].cb = cb;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&radio_lock);
+    return ret;
+}
+
+void ble_radio_unsubscribe(ble_scan_cb_t cb) {
+    portENTER_CRITICAL(&radio_lock);
+    for (int i = 0; i < BLE_RADIO_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].cb == cb) {
+            subscribers[i].cb = NULL;
+        }
+    }
+    uint32_t last_seq = dispatch_started;
+    portEXIT_CRITICAL(&radio_lock);
+
+    // A subscriber leaving from inside its own callback is the dispatch itself
+    if (xTaskGetCurrentTaskHandle() == dispatch_task) return;
+    while ((int32_t)(dispatch_finished - last_seq) < 0) {
+        vTaskDelay(1);
+    }
+}
+
+esp_err_t ble_radio_scan_start(const esp_ble_scan_params_t* params, uint32_t duration_s) {
+    esp_err_t ret = ble_radio_init();
+    if (ret != ESP_OK) return ret;
+
+    portENTER_CRITICAL(&radio_lock);
+    scan_users++;
+    bool start = scan_state == SCAN_IDLE;
+    if (start) {
+        scan_state = SCAN_STARTING;
+        scan_duration_s = duration_s;
+    }
+    portEXIT_CRITICAL(&radio_lock);
+
+    if (!start) {
+        ESP_LOGD(TAG, "Joined running scan (%d users)", scan_users);
+        return ESP_OK;
+    }
+
+    // Scanning begins once the stack confirms the parameters
+    ret = esp_ble_gap_set_scan_params((esp_ble_scan_params_t*)params);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Scan params rejected: %s", esp_err_to_name(ret));
+        portENTER_CRITICAL(&radio_lock);
+        scan_users--;
+        scan_state = SCAN_IDLE;
+        portEXIT_CRITICAL(&radio_lock);
+    }
+    return ret;
+}
+
+void ble_radio_scan_stop(void) {
+    portENTER_CRITICAL(&radio_lock);
+    if (scan_users > 0) scan_users--;
+    bool stop = scan_users == 0 && scan_state != SCAN_IDLE;
+    if (stop) scan_state = SCAN_IDLE;
+    portEXIT_CRITICAL(&radio_lock);
+
+    if (stop) {
+        esp_ble_gap_stop_scanning();
+    }
+}
+
+bool ble_radio_is_scanning(void) {
+    return scan_state != SCAN_IDLE;
+}
@@ -0,0 +1,40 @@
+#ifndef BLE_RADIO_H
+#define BLE_RADIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_gap_ble_api.h"
+
+// Owner of the BLE controller, Bluedroid and the GAP callback. The stack is
+// brought up once and stays up; features subscribe to the scan stream
+// instead of registering their own GAP callback, so several analyses can
+// share one scan and switching between them needs no stack restart.
+#define BLE_RADIO_MAX_SUBSCRIBERS 6
+
+typedef struct {
+    uint8_t prefix[6];          // address prefix results must start with
+    uint8_t prefix_len;         // bytes of prefix to compare; 0 accepts any
+    int8_t min_rssi;            // weaker results are dropped; 0 accepts any
+} ble_scan_filter_t;
+
+// Called from the Bluedroid task for each inquiry result that passes the
+// subscriber's filter; param->scan_rst holds the result
+typedef void (*ble_scan_cb_t)(esp_ble_gap_cb_param_t* param, void* ctx);
+
+// Idempotent; also adopts a stack that is already enabled
+esp_err_t ble_radio_init(void);
+
+// filter NULL accepts every result
+esp_err_t ble_radio_subscribe(ble_scan_cb_t cb, const ble_scan_filter_t* filter, void* ctx);
+// Once unsubscribe returns, cb is not running and will not be called again
+void ble_radio_unsubscribe(ble_scan_cb_t cb);
+
+// Scans are shared: a start while the radio is already scanning joins that
+// scan and keeps its parameters and duration. Each start must be paired
+// with a stop; the radio stops once the last user has left.
+esp_err_t ble_radio_scan_start(const esp_ble_scan_params_t* params, uint32_t duration_s);
+void ble_radio_scan_stop(void);
+bool ble_radio_is_scanning(void);
+
+#endif // BLE_RADIO_H
@@ -1,5 +1,8 @@
 #include "bluetooth_functions.h"
 #include "signal_visualizer.h"
+#include "device_table.h"
+#include "oui_db.h"
+#include "ble_radio.h"
 #include "esp_bt.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gattc_api.h"
@@ -12,87 +15,98 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
+#include <stdlib.h>
 
 static const char* TAG = "BT";
 static bool bt_initialized = false;
-static esp_bd_addr_t scan_results[20];
+static uint16_t* scan_ids = NULL;  // device table ids seen since scan_since_ms
 static int scan_count = 0;
+static uint32_t scan_since_ms = 0;
 
-static char device_names[20][32];
-static int8_t device_rssi[20];
+// Starts a new scan session; devices seen before it are not listed
+static void scan_list_reset(void) {
+    scan_since_ms = device_table_now_ms();
+    scan_count = 0;
+}
 
-static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
-    switch (event) {
-        case ESP_GAP_BLE_SCAN_RESULT_EVT:
-            if (scan_count < 20) {
-                    memcpy(scan_results[scan_count], param->scan_rst.bda, 6);
-                    device_rssi[scan_count] = param->scan_rst.rssi;
-                    
-                    uint8_t *adv_name = NULL;
-                    uint8_t adv_name_len = 0;
-                    adv_name = esp_ble_resolve_adv_data(param->scan_rst.ble_adv, 
-                                                        ESP_BLE_AD_TYPE_NAME_CMPL, 
-                                                        &adv_name_len);
-                    
-                    if (!adv_name || adv_name_len == 0) {
-                        adv_name = esp_ble_resolve_adv_data(param->scan_rst.ble_adv, 
-                                                            ESP_BLE_AD_TYPE_NAME_SHORT, 
-                                                            &adv_name_len);
-                    }
-                    
-                    if (adv_name && adv_name_len > 0) {
-                        int len = adv_name_len < 31 ? adv_name_len : 31;
-                        memcpy(device_names[scan_count], adv_name, len);
-                        device_names[scan_count][len] = '\0';
-                    } else {
-                        snprintf(device_names[scan_count], 32, "BLE_%02X%02X%02X",
-                                param->scan_rst.bda[3], param->scan_rst.bda[4],
-                                param->scan_rst.bda[5]);
-                    }
-                    
-                    scan_count++;
-            }
-            break;
-        default:
-            break;
+static void scan_list_refresh(device_order_t order) {
+    uint16_t capacity = device_table_capacity();
+    if (scan_ids == NULL && capacity > 0) {
+        scan_ids = malloc(capacity * sizeof(uint16_t));
     }
+    scan_count = scan_ids ? device_table_query(DEVICE_KIND_BLE, 0, scan_since_ms, order,
+                                               scan_ids, capacity) : 0;
+}
+
+// Feeds every BLE scan result into the device table, whichever feature
+// started the scan
+static void scan_result_handler(esp_ble_gap_cb_param_t *param, void* ctx) {
+    char name[32];
+    device_sighting_t sighting = {
+        .kind = DEVICE_KIND_BLE,
+        .mac = param->scan_rst.bda,
+        .rssi = param->scan_rst.rssi
+    };
+    
+    uint8_t *adv_name = NULL;
+    uint8_t adv_name_len = 0;
+    adv_name = esp_ble_resolve_adv_data(param->scan_rst.ble_adv, 
+                                        ESP_BLE_AD_TYPE_NAME_CMPL, 
+                                        &adv_name_len);
+    
+    if (!adv_name || adv_name_len == 0) {
+        adv_name = esp_ble_resolve_adv_data(param->scan_rst.ble_adv, 
+                                            ESP_BLE_AD_TYPE_NAME_SHORT, 
+                                            &adv_name_len);
+    }
+    
+    if (adv_name && adv_name_len > 0) {
+        int len = adv_name_len < 31 ? adv_name_len : 31;
+        memcpy(name, adv_name, len);
+        name[len] = '\0';
+        sighting.name = name;
+    } else if (device_table_find(DEVICE_KIND_BLE, param->scan_rst.bda) < 0) {
+        // Placeholder until the device advertises a name
+        const char* vendor = oui_db_lookup(param->scan_rst.bda);
+        if (vendor) {
+            snprintf(name, sizeof(name), "%.20s_%02X%02X", vendor,
+                    param->scan_rst.bda[4], param->scan_rst.bda[5]);
+        } else {
+            snprintf(name, sizeof(name), "BLE_%02X%02X%02X",
+                    param->scan_rst.bda[3], param->scan_rst.bda[4],
+                    param->scan_rst.bda[5]);
+        }
+        sighting.name = name;
+    }
+    
+    device_table_update(&sighting, NULL);
 }
 
 esp_err_t bluetooth_init(void) {
     if (bt_initialized) return ESP_OK;
     
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_bt_controller_init(&bt_cfg));
-    ESP_ERROR_CHECK(esp_bt_controller_enable(ESP_BT_MODE_BLE));
-    ESP_ERROR_CHECK(esp_bluedroid_init());
-    ESP_ERROR_CHECK(esp_bluedroid_enable());
-    ESP_ERROR_CHECK(esp_ble_gap_register_callback(gap_event_handler));
+    esp_err_t ret = ble_radio_init();
+    if (ret != ESP_OK) return ret;
+    ret = ble_radio_subscribe(scan_result_handler, NULL, NULL);
+    if (ret != ESP_OK) return ret;
     
     bt_initialized = true;
     ESP_LOGI(TAG, "Bluetooth initialized");
     return ESP_OK;
 }
 
-// OUI database for surveillance device detection
-static const struct {
-    const char* oui;
-    const char* vendor;
-} oui_db[] = {
-    {"18:7f:88", "Ring"}, {"24:2b:d6", "Ring"}, {"34:3e:a4", "Ring"},
-    {"00:25:df", "Axon"}, {"b4:1e:52", "Flock"}, {"0c:9a:e6", "DJI"},
-    {"00:13:37", "Hak5"}, {"00:c0:ca", "Alfa"}
+// OUIs for surveillance device detection, sorted for oui_table_lookup()
+static const oui_name_t surveillance_ouis[] = {
+    {0x001337, "Hak5"}, {0x0025DF, "Axon"}, {0x00C0CA, "Alfa"}, {0x0C9AE6, "DJI"},
+    {0x187F88, "Ring"}, {0x242BD6, "Ring"}, {0x343EA4, "Ring"}, {0xB41E52, "Flock"}
 };
 
 static bool is_surveillance_device(const uint8_t* mac, char* vendor) {
-    char mac_str[9];
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
-    for (int i = 0; mac_str[i]; i++) if (mac_str[i] >= 'A' && mac_str[i] <= 'F') mac_str[i] += 32;
-    
-    for (int i = 0; i < 8; i++) {
-        if (strncmp(mac_str, oui_db[i].oui, 8) == 0) {
-            strcpy(vendor, oui_db[i].vendor);
-            return true;
-        }
+    const char* name = oui_table_lookup(surveillance_ouis,
+                                        sizeof(surveillance_ouis) / sizeof(surveillance_ouis[0]), mac);
+    if (name) {
+        strcpy(vendor, name);
+        return true;
     }
     return false;
 }
@@ -101,16 +115,7 @@ void ble_scan_start(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
-    
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     bool scanning = true;
     int scroll_page = 0;
@@ -123,7 +128,7 @@ void ble_scan_start(void) {
         display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
         display_draw_text(10, 30, "Scanning...", COLOR_GREEN, COLOR_BLACK);
         
-        scan_count = 0;
+        scan_list_reset();
         
         esp_ble_scan_params_t scan_params = {
             .scan_type = BLE_SCAN_TYPE_ACTIVE,
@@ -134,11 +139,10 @@ void ble_scan_start(void) {
             .scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE
         };
         
-        esp_ble_gap_set_scan_params(&scan_params);
-        vTaskDelay(pdMS_TO_TICKS(500));
-        esp_ble_gap_start_scanning(10);
+        ble_radio_scan_start(&scan_params, 10);
         vTaskDelay(pdMS_TO_TICKS(10000));
-        esp_ble_gap_stop_scanning();
+        ble_radio_scan_stop();
+        scan_list_refresh(DEVICE_ORDER_RSSI);
         
         scroll_page = 0;
         
@@ -158,27 +162,29 @@ void ble_scan_start(void) {
                 
                 int display_idx = 0;
                 for (int i = start_idx; i < end_idx; i++) {
+                    device_info_t dev;
+                    if (!device_table_get(scan_ids[i], &dev)) continue;
                     char vendor[32];
-                    bool is_surv = is_surveillance_device(scan_results[i], vendor);
+                    bool is_surv = is_surveillance_device(dev.mac, vendor);
                     
                     if (filter_surveillance && !is_surv) continue;
                     
                     int y = 50 + display_idx * 25;
                     char device_info[48];
                     if (is_surv) {
-                        snprintf(device_info, sizeof(device_info), "[%s] %.10s", vendor, device_names[i]);
+                        snprintf(device_info, sizeof(device_info), "[%s] %.10s", vendor, dev.name);
                         display_draw_text(10, y, device_info, COLOR_RED, COLOR_BLACK);
                     } else {
-                        snprintf(device_info, sizeof(device_info), "%d: %.15s", i + 1, device_names[i]);
+                        snprintf(device_info, sizeof(device_info), "%d: %.15s", i + 1, dev.name);
                         display_draw_text(10, y, device_info, COLOR_GREEN, COLOR_BLACK);
                     }
                     
                     // Draw RSSI bar
-                    draw_signal_meter(device_rssi[i], 10, y + 12, 180, 8);
+                    draw_signal_meter(dev.rssi, 10, y + 12, 180, 8);
                     
                     // Show RSSI value
                     char rssi_str[8];
-                    snprintf(rssi_str, sizeof(rssi_str), "%d", device_rssi[i]);
+                    snprintf(rssi_str, sizeof(rssi_str), "%d", dev.rssi);
                     display_draw_text(195, y + 10, rssi_str, COLOR_GRAY, COLOR_BLACK);
                     
                     display_idx++;
@@ -249,15 +255,7 @@ void ble_apple_spam(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Apple Spam Attack", COLOR_RED, COLOR_BLACK);
@@ -300,15 +298,7 @@ void ble_samsung_spam(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Samsung Spam", COLOR_RED, COLOR_BLACK);
@@ -350,15 +340,7 @@ void ble_beacon_flood(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Beacon Flood", COLOR_RED, COLOR_BLACK);
@@ -408,15 +390,7 @@ void ble_jammer_start(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "BLE Jammer", COLOR_RED, COLOR_BLACK);
@@ -473,9 +447,14 @@ void bluetooth_targeted_attack_enhanced(void) {
         return;
     }
     
-    // Target first scanned device
+    // Target the strongest device from the last scan
+    device_info_t target;
+    if (!device_table_get(scan_ids[0], &target)) {
+        display_draw_text(10, 30, "Target expired", COLOR_RED, COLOR_BLACK);
+        return;
+    }
     esp_bd_addr_t target_addr;
-    memcpy(target_addr, scan_results[0], 6);
+    memcpy(target_addr, target.mac, 6);
     
     char target_info[50];
     snprintf(target_info, sizeof(target_info), "Target: %02X:%02X:%02X:%02X:%02X:%02X", 
@@ -515,15 +494,7 @@ void ble_sour_apple(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Sour Apple Attack", COLOR_RED, COLOR_BLACK);
@@ -576,15 +547,7 @@ void ble_sniffer_start(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "BLE Traffic Sniffer", COLOR_WHITE, COLOR_BLACK);
@@ -601,12 +564,12 @@ void ble_sniffer_start(void) {
     };
     
     int packet_count = 0;
-    scan_count = 0;
+    scan_list_reset();
     
-    esp_ble_gap_set_scan_params(&sniff_params);
-    esp_ble_gap_start_scanning(30); // Sniff for 30 seconds
+    ble_radio_scan_start(&sniff_params, 30); // Sniff for 30 seconds
     
     for (int i = 0; i < 300; i++) {
+        scan_list_refresh(DEVICE_ORDER_LAST_SEEN);
         packet_count += scan_count;
         
         char packet_info[30];
@@ -623,11 +586,12 @@ void ble_sniffer_start(void) {
         if (scan_count > 0) {
             display_draw_text(10, 90, "Recent devices:", COLOR_BLUE, COLOR_BLACK);
             for (int j = 0; j < scan_count && j < 3; j++) {
+                device_info_t dev;
+                if (!device_table_get(scan_ids[j], &dev)) continue;
                 char device_info[40];
                 snprintf(device_info, sizeof(device_info), "%02X:%02X:%02X:%02X:%02X:%02X", 
-                        scan_results[j][0], scan_results[j][1], 
-                        scan_results[j][2], scan_results[j][3], 
-                        scan_results[j][4], scan_results[j][5]);
+                        dev.mac[0], dev.mac[1], dev.mac[2],
+                        dev.mac[3], dev.mac[4], dev.mac[5]);
                 display_draw_text(10, 110 + j * 15, device_info, COLOR_WHITE, COLOR_BLACK);
             }
         }
@@ -636,7 +600,7 @@ void ble_sniffer_start(void) {
         if (touchscreen_is_touched()) break;
     }
     
-    esp_ble_gap_stop_scanning();
+    ble_radio_scan_stop();
     display_draw_text(10, 280, "Sniffing complete", COLOR_GREEN, COLOR_BLACK);
 }
 
@@ -646,15 +610,7 @@ void ble_targeted_attack(void) {
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    if (bt_initialized) {
-        esp_bluedroid_disable();
-        esp_bluedroid_deinit();
-        esp_bt_controller_disable();
-        esp_bt_controller_deinit();
-        bt_initialized = false;
-    }
     bluetooth_init();
-    vTaskDelay(pdMS_TO_TICKS(500));
     
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Targeted BLE Attack", COLOR_RED, COLOR_BLACK);
@@ -675,16 +631,21 @@ void ble_targeted_attack(void) {
     
     // Show available targets
     display_draw_text(10, 40, "Tap device to attack:", COLOR_WHITE, COLOR_BLACK);
-    for (int i = 0; i < scan_count && i < 6; i++) {
+    device_info_t shown[6];
+    int shown_count = 0;
+    for (int i = 0; i < scan_count && shown_count < 6; i++) {
+        if (!device_table_get(scan_ids[i], &shown[shown_count])) continue;
+        const device_info_t* dev = &shown[shown_count++];
+        int row = shown_count - 1;
         char device_info[50];
-        snprintf(device_info, sizeof(device_info), "%d: %.20s", i + 1, device_names[i]);
-        display_draw_text(10, 60 + i * 30, device_info, COLOR_GREEN, COLOR_BLACK);
+        snprintf(device_info, sizeof(device_info), "%d: %.20s", shown_count, dev->name);
+        display_draw_text(10, 60 + row * 30, device_info, COLOR_GREEN, COLOR_BLACK);
         
         char mac_info[32];
         snprintf(mac_info, sizeof(mac_info), "   %02X:%02X:%02X:%02X:%02X:%02X", 
-                scan_results[i][0], scan_results[i][1], scan_results[i][2],
-                scan_results[i][3], scan_results[i][4], scan_results[i][5]);
-        display_draw_text(10, 60 + i * 30 + 12, mac_info, COLOR_GRAY, COLOR_BLACK);
+                dev->mac[0], dev->mac[1], dev->mac[2],
+                dev->mac[3], dev->mac[4], dev->mac[5]);
+        display_draw_text(10, 60 + row * 30 + 12, mac_info, COLOR_GRAY, COLOR_BLACK);
     }
     
     // Back button
@@ -703,21 +664,20 @@ void ble_targeted_attack(void) {
             // Check device selection
             if (point.y >= 60 && point.y < 240) {
                 int selected = (point.y - 60) / 30;
-                if (selected >= 0 && selected < scan_count) {
+                if (selected >= 0 && selected < shown_count) {
                     // Attack selected device
                     display_fill_screen(COLOR_BLACK);
                     display_draw_text(10, 10, "Attacking Device", COLOR_RED, COLOR_BLACK);
                     display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
                     
                     char target_info[50];
+                    const uint8_t* mac = shown[selected].mac;
                     snprintf(target_info, sizeof(target_info), "Target: %02X:%02X:%02X:%02X:%02X:%02X",
-                            scan_results[selected][0], scan_results[selected][1],
-                            scan_results[selected][2], scan_results[selected][3],
-                            scan_results[selected][4], scan_results[selected][5]);
+                            mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
                     display_draw_text(10, 40, target_info, COLOR_ORANGE, COLOR_BLACK);
                     
                     esp_bd_addr_t target_addr;
-                    memcpy(target_addr, scan_results[selected], 6);
+                    memcpy(target_addr, mac, 6);
                     
                     // Connection hijack attempts
                     for (int i = 0; i < 100; i++) {
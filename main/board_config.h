@@ -24,6 +24,84 @@
 #define DISPLAY_WIDTH   240
 #define DISPLAY_HEIGHT  320
 
+// Display compositor: a display list of DISPLAY_FB_LIST_BYTES (PSRAM when
+// present) rendered one 16-row band at a time into a 7.5 KB internal
+// buffer. Without PSRAM both are only taken while DISPLAY_FB_INTERNAL_RESERVE
+// bytes of internal heap stay free for the Wi-Fi and BT stacks, which start
+// after the display and need roughly 100 KB between them. Changes are sent
+// once drawing pauses for IDLE, or after MAX_HOLD of continuous drawing.
+#define DISPLAY_FB_LIST_BYTES           (8 * 1024)
+#define DISPLAY_FB_INTERNAL_RESERVE     (120 * 1024)
+#define DISPLAY_FB_IDLE_MS              30
+#define DISPLAY_FB_MAX_HOLD_MS          250
+
+// Packet capture file writer: records are written in whole blocks and
+// synced by time or volume; preallocation is skipped when 0
+#define CAPTURE_BLOCK_SIZE      (16 * 1024)
+#define CAPTURE_PREALLOC_BYTES  0
+#define CAPTURE_SYNC_BYTES      (64 * 1024)
+#define CAPTURE_SYNC_MS         2000
+
+// Capture rotation: start a new file after this many bytes or seconds
+// (0 = no limit) and keep only the newest N files (0 = keep all)
+#define CAPTURE_ROTATE_BYTES    (512 * 1024)
+#define CAPTURE_ROTATE_SECONDS  600
+#define CAPTURE_KEEP_FILES      4
+
+// BLE advertisement log: scan-callback ring and file block size
+#define BLE_CAPTURE_RING_SIZE   (16 * 1024)
+#define BLE_CAPTURE_BLOCK_SIZE  (8 * 1024)
+#define BLE_CAPTURE_SYNC_BYTES  (32 * 1024)
+
+// Channel hopping for promiscuous modes: default hop list is 1..LAST,
+// adaptive dwell stays within MIN..MAX
+#define CHANNEL_HOP_LAST_CHANNEL    13
+#define CHANNEL_HOP_DWELL_MS        250
+#define CHANNEL_HOP_MIN_DWELL_MS    100
+#define CHANNEL_HOP_MAX_DWELL_MS    800
+
+// Channel-by-channel AP scan: sweeps 1..LAST with a per-channel dwell set by
+// the selected profile
+#define WIFI_SCAN_LAST_CHANNEL      13
+#define WIFI_SCAN_ACTIVE_MIN_MS     60
+#define WIFI_SCAN_ACTIVE_MAX_MS     150
+#define WIFI_SCAN_QUICK_MAX_MS      50
+#define WIFI_SCAN_PASSIVE_MS        360
+
+// Features reuse the last AP sweep while it is younger than REUSE, and wait
+// at most WAIT for a fresh one
+#define WIFI_SCAN_REUSE_MS          (30 * 1000)
+#define WIFI_SCAN_WAIT_MS           (10 * 1000)
+
+// How long a stop waits for the driver's SCAN_DONE of the aborted channel
+#define WIFI_SCAN_ABORT_WAIT_MS     200
+
+// FIND3 reports each AP's median RSSI over its last SAMPLES sightings
+// (at most DEVICE_RSSI_HISTORY)
+#define FIND3_RSSI_SAMPLES          5
+
+// Channel utilization analyzer: hop dwell while measuring, and how many
+// sweeps the reported averages cover
+#define AIRTIME_DWELL_MS            200
+#define AIRTIME_BUCKETS             16
+
+// Probe-request analytics: top-K sizes, HyperLogLog precision (2^BITS one-byte
+// registers) and the callback-to-worker ring
+#define PROBE_STATS_TOP_SSIDS       32
+#define PROBE_STATS_TOP_DEVICES     32
+#define PROBE_STATS_HLL_BITS        10
+#define PROBE_STATS_RING_SIZE       4096
+
+// Shared AP/station/BLE device table: hard memory budget for all columns
+// plus its index (74 B per row + 2048 index slots holds 664 rows, enough for
+// a venue's 150 APs and 500 BLE devices); scanned APs not seen for MAX_AGE
+// are dropped
+#define DEVICE_TABLE_BUDGET         (52 * 1024)
+#define DEVICE_TABLE_AP_MAX_AGE_MS  (5 * 60 * 1000)
+
+// OUI-Spy watchlist: one "<mac or prefix[/bits]> <description>" per line
+#define OUI_SPY_WATCHLIST_PATH      "/sdcard/oui_spy/watchlist.txt"
+
 // Touch Calibration (ESP32-32E XPT2046)
 #define TS_MINX         200
 #define TS_MAXX         3900
@@ -0,0 +1,286 @@
+#include "capture_filter.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "wifi_frame.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static const char* TAG = "CAP_FILTER";
+
+enum {
+    OP_MATCH,       // masked compare of len bytes at offset
+    OP_EAPOL,       // unprotected data frame carrying 802.1X
+    OP_RSSI_GT,
+    OP_RSSI_LT,
+    OP_CHANNEL,
+    OP_AND,
+    OP_OR,
+    OP_NOT
+};
+
+typedef struct {
+    const char* name;
+    uint8_t fc;         // frame control byte 0 with type and subtype
+} subtype_name_t;
+
+static const subtype_name_t subtype_names[] = {
+    {"assoc-req", 0x00}, {"assoc-resp", 0x10}, {"reassoc-req", 0x20},
+    {"reassoc-resp", 0x30}, {"probe-req", 0x40}, {"probe-resp", 0x50},
+    {"beacon", 0x80}, {"disassoc", 0xA0}, {"auth", 0xB0},
+    {"deauth", 0xC0}, {"action", 0xD0}, {"qos-data", 0x88},
+};
+
+typedef struct {
+    const char* pos;
+    char tok[24];
+    capture_filter_t* out;
+    bool failed;
+} parser_t;
+
+static void next_token(parser_t* p) {
+    while (*p->pos && isspace((unsigned char)*p->pos)) p->pos++;
+
+    size_t n = 0;
+    if (*p->pos == '(' || *p->pos == ')') {
+        p->tok[n++] = *p->pos++;
+    } else {
+        while (*p->pos && !isspace((unsigned char)*p->pos) &&
+               *p->pos != '(' && *p->pos != ')') {
+            if (n < sizeof(p->tok) - 1) p->tok[n++] = tolower((unsigned char)*p->pos);
+            p->pos++;
+        }
+    }
+    p->tok[n] = '\0';
+}
+
+static void fail(parser_t* p, const char* why) {
+    if (!p->failed) {
+        ESP_LOGE(TAG, "%s at '%s'", why, p->tok[0] ? p->tok : "<end>");
+    }
+    p->failed = true;
+}
+
+static capture_filter_insn_t* emit(parser_t* p, uint8_t op) {
+    if (p->out->count >= CAPTURE_FILTER_MAX_INSNS) {
+        fail(p, "Filter too long");
+        return NULL;
+    }
+    capture_filter_insn_t* insn = &p->out->insn[p->out->count++];
+    memset(insn, 0, sizeof(*insn));
+    insn->op = op;
+    return insn;
+}
+
+static void emit_fc(parser_t* p, uint8_t mask, uint8_t value) {
+    capture_filter_insn_t* insn = emit(p, OP_MATCH);
+    if (insn) {
+        insn->len = 1;
+        insn->mask[0] = mask;
+        insn->value[0] = value;
+    }
+}
+
+static bool parse_number(const char* s, long* out) {
+    char* end;
+    *out = strtol(s, &end, 0);
+    return *s && *end == '\0';
+}
+
+// Accepts 3 (OUI) or 6 (full address) hex octets separated by ':' or '-'
+static int parse_mac(const char* s, uint8_t* out) {
+    int n = 0;
+    while (n < 6) {
+        char* end;
+        unsigned long v = strtoul(s, &end, 16);
+        if (end == s || end - s > 2 || v > 0xFF) return 0;
+        out[n++] = v;
+        if (*end == '\0') break;
+        if (*end != ':' && *end != '-') return 0;
+        s = end + 1;
+    }
+    return (n == 3 || n == 6) ? n : 0;
+}
+
+static void parse_term(parser_t* p) {
+    long num;
+
+    if (strcmp(p->tok, "mgmt") == 0) {
+        emit_fc(p, 0x0C, 0x00);
+    } else if (strcmp(p->tok, "ctrl") == 0) {
+        emit_fc(p, 0x0C, 0x04);
+    } else if (strcmp(p->tok, "data") == 0) {
+        emit_fc(p, 0x0C, 0x08);
+    } else if (strcmp(p->tok, "eapol") == 0) {
+        emit(p, OP_EAPOL);
+    } else if (strcmp(p->tok, "subtype") == 0) {
+        next_token(p);
+        for (size_t i = 0; i < sizeof(subtype_names) / sizeof(subtype_names[0]); i++) {
+            if (strcmp(p->tok, subtype_names[i].name) == 0) {
+                emit_fc(p, 0xFC, subtype_names[i].fc);
+                next_token(p);
+                return;
+            }
+        }
+        if (!parse_number(p->tok, &num) || num < 0 || num > 15) {
+            fail(p, "Unknown subtype");
+            return;
+        }
+        emit_fc(p, 0xF0, num << 4);
+    } else if (strncmp(p->tok, "addr", 4) == 0 && p->tok[4] >= '1' && p->tok[4] <= '3' &&
+               p->tok[5] == '\0') {
+        static const uint8_t addr_offset[] = {4, 10, 16};
+        uint8_t offset = addr_offset[p->tok[4] - '1'];
+        next_token(p);
+        if (strcmp(p->tok, "oui") == 0) {
+            next_token(p);
+        }
+        capture_filter_insn_t insn = {.op = OP_MATCH, .offset = offset};
+        insn.len = parse_mac(p->tok, insn.value);
+        if (insn.len == 0) {
+            fail(p, "Bad address");
+            return;
+        }
+        memset(insn.mask, 0xFF, insn.len);
+        capture_filter_insn_t* slot = emit(p, OP_MATCH);
+        if (slot) *slot = insn;
+    } else if (strcmp(p->tok, "rssi") == 0) {
+        next_token(p);
+        uint8_t op = strcmp(p->tok, ">") == 0 ? OP_RSSI_GT :
+                     strcmp(p->tok, "<") == 0 ? OP_RSSI_LT : OP_AND;
+        next_token(p);
+        if (op == OP_AND || !parse_number(p->tok, &num) || num < -128 || num > 127) {
+            fail(p, "Expected rssi > or < dBm");
+            return;
+        }
+        capture_filter_insn_t* insn = emit(p, op);
+        if (insn) insn->arg = num;
+    } else if (strcmp(p->tok, "channel") == 0) {
+        next_token(p);
+        if (!parse_number(p->tok, &num) || num < 1 || num > 14) {
+            fail(p, "Bad channel");
+            return;
+        }
+        capture_filter_insn_t* insn = emit(p, OP_CHANNEL);
+        if (insn) insn->arg = num;
+    } else {
+        fail(p, "Unknown term");
+        return;
+    }
+    next_token(p);
+}
+
+static void parse_expr(parser_t* p);
+
+static void parse_unary(parser_t* p) {
+    if (strcmp(p->tok, "not") == 0) {
+        next_token(p);
+        parse_unary(p);
+        emit(p, OP_NOT);
+    } else if (strcmp(p->tok, "(") == 0) {
+        next_token(p);
+        parse_expr(p);
+        if (strcmp(p->tok, ")") != 0) {
+            fail(p, "Expected )");
+            return;
+        }
+        next_token(p);
+    } else {
+        parse_term(p);
+    }
+}
+
+static void parse_and(parser_t* p) {
+    parse_unary(p);
+    while (!p->failed && p->tok[0] && strcmp(p->tok, "or") != 0 && strcmp(p->tok, ")") != 0) {
+        if (strcmp(p->tok, "and") == 0) {
+            next_token(p);
+        }
+        parse_unary(p);
+        emit(p, OP_AND);
+    }
+}
+
+static void parse_expr(parser_t* p) {
+    parse_and(p);
+    while (!p->failed && strcmp(p->tok, "or") == 0) {
+        next_token(p);
+        parse_and(p);
+        emit(p, OP_OR);
+    }
+}
+
+esp_err_t capture_filter_compile(capture_filter_t* filter, const char* expr) {
+    filter->count = 0;
+    if (expr == NULL) {
+        return ESP_OK;
+    }
+
+    parser_t p = {.pos = expr, .out = filter};
+    next_token(&p);
+    if (p.tok[0] == '\0') {
+        return ESP_OK;
+    }
+
+    parse_expr(&p);
+    if (!p.failed && p.tok[0]) {
+        fail(&p, "Unexpected token");
+    }
+    if (p.failed) {
+        filter->count = 0;
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Compiled \"%s\" to %d ops", expr, filter->count);
+    return ESP_OK;
+}
+
+bool IRAM_ATTR capture_filter_match_frame(const capture_filter_t* filter, const uint8_t* frame,
+                                          size_t len, int8_t rssi, uint8_t channel) {
+    // One bit per stack slot; the compiler guarantees a balanced program
+    uint32_t stack = 0;
+    int sp = 0;
+
+    for (int i = 0; i < filter->count; i++) {
+        const capture_filter_insn_t* insn = &filter->insn[i];
+        bool r;
+
+        switch (insn->op) {
+        case OP_MATCH:
+            r = insn->offset + insn->len <= len;
+            for (int j = 0; r && j < insn->len; j++) {
+                r = (frame[insn->offset + j] & insn->mask[j]) == insn->value[j];
+            }
+            break;
+        case OP_EAPOL: {
+            wifi_frame_t f;
+            r = wifi_frame_parse(&f, frame, len) && wifi_frame_is_eapol(&f);
+            break;
+        }
+        case OP_RSSI_GT:
+            r = rssi > insn->arg;
+            break;
+        case OP_RSSI_LT:
+            r = rssi < insn->arg;
+            break;
+        case OP_CHANNEL:
+            r = channel == (uint8_t)insn->arg;
+            break;
+        case OP_NOT:
+            stack ^= 1u << (sp - 1);
+            continue;
+        default: {
+            // Binary ops pop two results and push one
+            bool b = (stack >> --sp) & 1;
+            bool a = (stack >> --sp) & 1;
+            r = insn->op == OP_AND ? (a && b) : (a || b);
+            stack &= ~(1u << sp);
+            break;
+        }
+        }
+
+        stack = (stack & ~(1u << sp)) | ((uint32_t)r << sp);
+        sp++;
+    }
+    return stack & 1;
+}
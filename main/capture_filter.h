@@ -0,0 +1,62 @@
+#ifndef CAPTURE_FILTER_H
+#define CAPTURE_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Frame filter for promiscuous callbacks. An expression such as
+//
+//     mgmt subtype beacon and addr2 oui b4:1e:52
+//
+// is compiled once into a short postfix program that the RX path can run
+// before copying anything. Grammar (adjacent terms are ANDed):
+//
+//     expr    := and ("or" and)*
+//     and     := unary (["and"] unary)*
+//     unary   := "not" unary | "(" expr ")" | term
+//     term    := "mgmt" | "ctrl" | "data" | "eapol"
+//              | "subtype" (name | number)
+//              | ("addr1" | "addr2" | "addr3") ["oui"] mac
+//              | "rssi" (">" | "<") number
+//              | "channel" number
+//
+// Subtype names: assoc-req, assoc-resp, reassoc-req, reassoc-resp,
+// probe-req, probe-resp, beacon, disassoc, auth, deauth, action, qos-data.
+#define CAPTURE_FILTER_MAX_INSNS    32
+
+typedef struct {
+    uint8_t op;
+    uint8_t len;        // bytes compared for OP_MATCH
+    uint8_t offset;     // frame offset for OP_MATCH
+    int8_t  arg;        // rssi threshold or channel
+    uint8_t mask[6];
+    uint8_t value[6];
+} capture_filter_insn_t;
+
+typedef struct {
+    uint8_t count;      // 0 = match everything
+    capture_filter_insn_t insn[CAPTURE_FILTER_MAX_INSNS];
+} capture_filter_t;
+
+// Compiles expr (NULL or empty clears the filter). On a syntax error the
+// filter is left empty and the offending token is logged.
+esp_err_t capture_filter_compile(capture_filter_t* filter, const char* expr);
+
+// Runs the program against a raw 802.11 frame of len bytes
+bool capture_filter_match_frame(const capture_filter_t* filter, const uint8_t* frame,
+                                size_t len, int8_t rssi, uint8_t channel);
+
+// Convenience wrapper for promiscuous callbacks; the trailing FCS is not
+// part of the frame, so address matches cannot run into it
+static inline bool capture_filter_match(const capture_filter_t* filter,
+                                        const wifi_promiscuous_pkt_t* pkt) {
+    size_t len = pkt->rx_ctrl.sig_len;
+    return filter->count == 0 ||
+           capture_filter_match_frame(filter, pkt->payload, len >= 4 ? len - 4 : 0,
+                                      pkt->rx_ctrl.rssi, pkt->rx_ctrl.channel);
+}
+
+#endif // CAPTURE_FILTER_H
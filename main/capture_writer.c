@@ -0,0 +1,178 @@
+#include "capture_writer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+static const char* TAG = "CAP_WRITER";
+
+// Bytes left before the file offset reaches the next block boundary. A timed
+// partial flush leaves the offset mid-block; the following write is shortened
+// so every later one starts on a boundary again.
+static size_t block_room(const capture_writer_t* w) {
+    return w->block_size - (size_t)(w->file_off % w->block_size);
+}
+
+static void note_latency(capture_writer_t* w, int64_t start_us) {
+    int64_t took = esp_timer_get_time() - start_us;
+    w->stats.busy_us += took;
+    if (took > w->stats.worst_write_us) {
+        w->stats.worst_write_us = (uint32_t)took;
+    }
+}
+
+static esp_err_t write_block(capture_writer_t* w) {
+    size_t done = 0;
+
+    while (done < w->fill) {
+        int64_t start = esp_timer_get_time();
+        ssize_t n = write(w->fd, w->block + done, w->fill - done);
+        note_latency(w, start);
+        if (n <= 0) {
+            ESP_LOGE(TAG, "write failed after %llu bytes", (unsigned long long)w->file_off);
+            return ESP_FAIL;
+        }
+        done += n;
+        w->stats.writes++;
+    }
+
+    w->file_off += w->fill;
+    w->stats.bytes_written += w->fill;
+    w->unsynced += w->fill;
+    w->fill = 0;
+    return ESP_OK;
+}
+
+static esp_err_t sync_file(capture_writer_t* w) {
+    int64_t start = esp_timer_get_time();
+    int ret = fsync(w->fd);
+    note_latency(w, start);
+    w->last_sync_us = esp_timer_get_time();
+    w->unsynced = 0;
+    w->stats.syncs++;
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t capture_writer_open(capture_writer_t* w, const char* path,
+                              const capture_writer_config_t* config) {
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+
+    size_t block = config->block_size;
+    if (block < CAPTURE_WRITER_MIN_BLOCK) block = CAPTURE_WRITER_MIN_BLOCK;
+    if (block > CAPTURE_WRITER_MAX_BLOCK) block = CAPTURE_WRITER_MAX_BLOCK;
+    block -= block % CAPTURE_WRITER_SECTOR;
+
+    w->block = heap_caps_malloc(block, MALLOC_CAP_8BIT);
+    if (w->block == NULL) {
+        ESP_LOGE(TAG, "No memory for %u byte block", (unsigned)block);
+        return ESP_ERR_NO_MEM;
+    }
+
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        heap_caps_free(w->block);
+        w->block = NULL;
+        return ESP_FAIL;
+    }
+
+    // Preallocation is best effort; not every filesystem supports it
+    if (config->prealloc_bytes > 0) {
+        if (ftruncate(w->fd, config->prealloc_bytes) == 0) {
+            w->prealloc_bytes = config->prealloc_bytes;
+        } else {
+            ESP_LOGW(TAG, "Preallocation of %u bytes not supported", (unsigned)config->prealloc_bytes);
+        }
+    }
+
+    w->block_size = block;
+    w->sync_bytes = config->sync_bytes;
+    w->sync_ms = config->sync_ms;
+    w->opened_us = esp_timer_get_time();
+    w->last_sync_us = w->opened_us;
+    return ESP_OK;
+}
+
+esp_err_t capture_writer_append(capture_writer_t* w, const void* data, size_t len) {
+    const uint8_t* src = data;
+
+    while (len > 0) {
+        size_t room = block_room(w) - w->fill;
+        size_t n = len < room ? len : room;
+
+        memcpy(w->block + w->fill, src, n);
+        w->fill += n;
+        src += n;
+        len -= n;
+
+        if (w->fill == block_room(w)) {
+            if (write_block(w) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            if (w->sync_bytes > 0 && w->unsynced >= w->sync_bytes) {
+                sync_file(w);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t capture_writer_sync(capture_writer_t* w) {
+    if (w->fill > 0 && write_block(w) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (w->unsynced == 0) {
+        return ESP_OK;
+    }
+    return sync_file(w);
+}
+
+esp_err_t capture_writer_poll(capture_writer_t* w) {
+    if (w->sync_ms == 0 || (w->fill == 0 && w->unsynced == 0)) {
+        return ESP_OK;
+    }
+    if (esp_timer_get_time() - w->last_sync_us < (int64_t)w->sync_ms * 1000) {
+        return ESP_OK;
+    }
+    return capture_writer_sync(w);
+}
+
+esp_err_t capture_writer_close(capture_writer_t* w) {
+    if (w->fd < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = capture_writer_sync(w);
+
+    if (w->prealloc_bytes > w->file_off) {
+        ftruncate(w->fd, w->file_off);
+    }
+    close(w->fd);
+    w->fd = -1;
+    w->stats.elapsed_us = esp_timer_get_time() - w->opened_us;
+
+    heap_caps_free(w->block);
+    w->block = NULL;
+
+    ESP_LOGI(TAG, "Closed: %llu bytes, %.2f MB/s, worst write %lu us",
+             (unsigned long long)w->stats.bytes_written, capture_writer_mbps(&w->stats),
+             (unsigned long)w->stats.worst_write_us);
+    return ret;
+}
+
+void capture_writer_get_stats(const capture_writer_t* w, capture_writer_stats_t* stats) {
+    *stats = w->stats;
+    if (w->fd >= 0) {
+        stats->elapsed_us = esp_timer_get_time() - w->opened_us;
+    }
+}
+
+float capture_writer_mbps(const capture_writer_stats_t* stats) {
+    if (stats->elapsed_us <= 0) {
+        return 0.0f;
+    }
+    return (float)stats->bytes_written / (float)stats->elapsed_us;
+}
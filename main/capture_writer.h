@@ -0,0 +1,67 @@
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Block writer for capture files. Records are gathered into a RAM block and
+// handed to the filesystem in whole, sector-aligned blocks with POSIX write(),
+// so flash sees a few large writes instead of many small ones. Syncing is
+// driven by elapsed time and unsynced bytes rather than a record count.
+#define CAPTURE_WRITER_SECTOR       4096
+#define CAPTURE_WRITER_MIN_BLOCK    (4 * 1024)
+#define CAPTURE_WRITER_MAX_BLOCK    (32 * 1024)
+
+typedef struct {
+    size_t block_size;      // rounded to a sector multiple, 4..32 KB
+    size_t prealloc_bytes;  // reserve this much up front (0 = grow as needed)
+    size_t sync_bytes;      // fsync after this many unsynced bytes (0 = never)
+    uint32_t sync_ms;       // also push out a partial block after this long (0 = never)
+} capture_writer_config_t;
+
+typedef struct {
+    uint64_t bytes_written;
+    uint32_t writes;
+    uint32_t syncs;
+    uint32_t worst_write_us;    // slowest single write() or fsync()
+    int64_t busy_us;            // time spent inside write()/fsync()
+    int64_t elapsed_us;         // since the file was opened
+} capture_writer_stats_t;
+
+typedef struct {
+    int fd;
+    uint8_t* block;
+    size_t block_size;
+    size_t fill;
+    uint64_t file_off;          // bytes handed to write() so far
+    size_t unsynced;
+    size_t prealloc_bytes;
+    size_t sync_bytes;
+    uint32_t sync_ms;
+    int64_t opened_us;
+    int64_t last_sync_us;
+    capture_writer_stats_t stats;
+} capture_writer_t;
+
+esp_err_t capture_writer_open(capture_writer_t* w, const char* path,
+                              const capture_writer_config_t* config);
+
+// Queue bytes for the file; full blocks are written immediately
+esp_err_t capture_writer_append(capture_writer_t* w, const void* data, size_t len);
+
+// Call periodically from the writer task to apply the time-based policy
+esp_err_t capture_writer_poll(capture_writer_t* w);
+
+// Write out everything buffered and fsync
+esp_err_t capture_writer_sync(capture_writer_t* w);
+
+// Sync, trim any preallocated tail and close
+esp_err_t capture_writer_close(capture_writer_t* w);
+
+void capture_writer_get_stats(const capture_writer_t* w, capture_writer_stats_t* stats);
+
+// Sustained throughput over the life of the file
+float capture_writer_mbps(const capture_writer_stats_t* stats);
+
+#endif // CAPTURE_WRITER_H
@@ -0,0 +1,261 @@
+#include "channel_hopper.h"
+#include "board_config.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "wifi_frame.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char* TAG = "CH_HOP";
+
+// Weight of one new BSSID per second against one frame per second of yield
+#define NOVELTY_WEIGHT  20.0f
+// Smoothing applied to each sweep's per-channel measurements
+#define YIELD_ALPHA     0.3f
+
+#define SEEN_SLOTS      256
+
+typedef struct {
+    channel_hopper_cb_t cb;
+    void* ctx;
+} subscriber_t;
+
+static channel_hopper_config_t config;
+static channel_hopper_stats_t stats;
+static float novelty[CHANNEL_HOPPER_MAX_CHANNELS];
+static uint8_t channel_slot[16];     // channel number -> stats index + 1
+static volatile uint8_t current_channel;
+static subscriber_t subscribers[CHANNEL_HOPPER_MAX_SUBSCRIBERS];
+
+// Open-addressed set of BSSID hashes, written only by the RX callback
+static uint32_t seen_bssids[SEEN_SLOTS];
+static uint32_t seen_count;
+
+static TaskHandle_t hopper_task = NULL;
+static SemaphoreHandle_t hopper_done = NULL;
+static volatile bool hopper_stop = false;
+
+static uint32_t IRAM_ATTR bssid_hash(const uint8_t* mac) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        h = (h ^ mac[i]) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+// Returns true the first time a BSSID is inserted
+static bool IRAM_ATTR seen_insert(const uint8_t* mac) {
+    uint32_t h = bssid_hash(mac);
+
+    // Keep probe chains short; forgetting everything only re-credits novelty
+    if (seen_count >= SEEN_SLOTS * 3 / 4) {
+        memset(seen_bssids, 0, sizeof(seen_bssids));
+        seen_count = 0;
+    }
+
+    for (uint32_t i = h % SEEN_SLOTS;; i = (i + 1) % SEEN_SLOTS) {
+        if (seen_bssids[i] == h) return false;
+        if (seen_bssids[i] == 0) {
+            seen_bssids[i] = h;
+            seen_count++;
+            return true;
+        }
+    }
+}
+
+void IRAM_ATTR channel_hopper_note_frame(const wifi_promiscuous_pkt_t* pkt) {
+    uint8_t ch = pkt->rx_ctrl.channel;
+    if (ch >= sizeof(channel_slot) || channel_slot[ch] == 0) {
+        return;
+    }
+    channel_hopper_channel_t* c = &stats.channels[channel_slot[ch] - 1];
+    c->frames++;
+
+    // Beacons and probe responses announce a BSSID
+    wifi_frame_t f;
+    if (wifi_frame_from_pkt(&f, pkt) &&
+        (wifi_frame_is_mgmt(&f, WIFI_MGMT_BEACON) || wifi_frame_is_mgmt(&f, WIFI_MGMT_PROBE_RESP)) &&
+        seen_insert(f.addr3)) {
+        c->new_bssids++;
+    }
+}
+
+// Re-plans every channel's dwell from what the last sweep produced
+static void plan_dwell(const uint32_t* frames, const uint32_t* fresh, const uint32_t* dwelt) {
+    float best = 0.0f;
+    float score[CHANNEL_HOPPER_MAX_CHANNELS];
+
+    for (int i = 0; i < stats.channel_count; i++) {
+        channel_hopper_channel_t* c = &stats.channels[i];
+        float secs = dwelt[i] > 0 ? dwelt[i] / 1000.0f : 1.0f;
+        c->yield += YIELD_ALPHA * (frames[i] / secs - c->yield);
+        novelty[i] += YIELD_ALPHA * (fresh[i] / secs - novelty[i]);
+        score[i] = c->yield + NOVELTY_WEIGHT * novelty[i];
+        if (score[i] > best) best = score[i];
+    }
+
+    for (int i = 0; i < stats.channel_count; i++) {
+        channel_hopper_channel_t* c = &stats.channels[i];
+        if (!config.adaptive || best <= 0.0f) {
+            c->dwell_ms = config.dwell_ms;
+        } else {
+            c->dwell_ms = config.min_dwell_ms +
+                          (uint16_t)((config.max_dwell_ms - config.min_dwell_ms) * score[i] / best);
+        }
+    }
+}
+
+static void hopper_task_fn(void* arg) {
+    uint32_t frames[CHANNEL_HOPPER_MAX_CHANNELS];
+    uint32_t fresh[CHANNEL_HOPPER_MAX_CHANNELS];
+    uint32_t dwelt[CHANNEL_HOPPER_MAX_CHANNELS];
+
+    while (!hopper_stop) {
+        for (int i = 0; i < stats.channel_count && !hopper_stop; i++) {
+            channel_hopper_channel_t* c = &stats.channels[i];
+            uint32_t frames_before = c->frames;
+            uint32_t fresh_before = c->new_bssids;
+
+            current_channel = c->channel;
+            esp_wifi_set_channel(c->channel, WIFI_SECOND_CHAN_NONE);
+
+            TickType_t start = xTaskGetTickCount();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(c->dwell_ms));
+            uint32_t ms = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+
+            c->visits++;
+            c->total_dwell_ms += ms;
+            frames[i] = c->frames - frames_before;
+            fresh[i] = c->new_bssids - fresh_before;
+            dwelt[i] = ms;
+        }
+        if (hopper_stop) {
+            break;
+        }
+
+        plan_dwell(frames, fresh, dwelt);
+        stats.sweeps++;
+
+        for (int i = 0; i < CHANNEL_HOPPER_MAX_SUBSCRIBERS; i++) {
+            if (subscribers[i].cb) {
+                subscribers[i].cb(&stats, subscribers[i].ctx);
+            }
+        }
+    }
+
+    xSemaphoreGive(hopper_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t channel_hopper_start(const channel_hopper_config_t* cfg) {
+    static const uint8_t all_channels[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+
+    if (hopper_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (cfg) {
+        config = *cfg;
+    } else {
+        config = (channel_hopper_config_t){
+            .dwell_ms = CHANNEL_HOP_DWELL_MS,
+            .adaptive = true,
+            .min_dwell_ms = CHANNEL_HOP_MIN_DWELL_MS,
+            .max_dwell_ms = CHANNEL_HOP_MAX_DWELL_MS
+        };
+    }
+    if (config.channels == NULL || config.channel_count == 0) {
+        config.channels = all_channels;
+        config.channel_count = CHANNEL_HOP_LAST_CHANNEL;
+    }
+    if (config.channel_count > CHANNEL_HOPPER_MAX_CHANNELS) {
+        config.channel_count = CHANNEL_HOPPER_MAX_CHANNELS;
+    }
+    if (config.max_dwell_ms < config.min_dwell_ms) {
+        config.max_dwell_ms = config.min_dwell_ms;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    memset(novelty, 0, sizeof(novelty));
+    memset(channel_slot, 0, sizeof(channel_slot));
+    memset(seen_bssids, 0, sizeof(seen_bssids));
+    seen_count = 0;
+
+    for (int i = 0; i < config.channel_count; i++) {
+        uint8_t ch = config.channels[i];
+        if (ch < 1 || ch > 14 || channel_slot[ch]) {
+            continue;
+        }
+        channel_hopper_channel_t* c = &stats.channels[stats.channel_count];
+        c->channel = ch;
+        c->dwell_ms = config.dwell_ms;
+        channel_slot[ch] = ++stats.channel_count;
+    }
+    if (stats.channel_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (hopper_done == NULL) {
+        hopper_done = xSemaphoreCreateBinary();
+        if (hopper_done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    hopper_stop = false;
+    if (xTaskCreate(hopper_task_fn, "ch_hopper", 3072, NULL, 5, &hopper_task) != pdPASS) {
+        hopper_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Hopping %d channels, %s dwell %d ms", stats.channel_count,
+             config.adaptive ? "adaptive" : "fixed", config.dwell_ms);
+    return ESP_OK;
+}
+
+void channel_hopper_stop(void) {
+    if (hopper_task == NULL) {
+        return;
+    }
+
+    hopper_stop = true;
+    xTaskNotifyGive(hopper_task);
+    xSemaphoreTake(hopper_done, portMAX_DELAY);
+    hopper_task = NULL;
+
+    ESP_LOGI(TAG, "Stopped after %lu sweeps", (unsigned long)stats.sweeps);
+}
+
+bool channel_hopper_is_running(void) {
+    return hopper_task != NULL;
+}
+
+uint8_t channel_hopper_current_channel(void) {
+    return current_channel;
+}
+
+esp_err_t channel_hopper_subscribe(channel_hopper_cb_t cb, void* ctx) {
+    for (int i = 0; i < CHANNEL_HOPPER_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].cb == NULL) {
+            subscribers[i].ctx = ctx;
+            subscribers[i].cb = cb;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void channel_hopper_unsubscribe(channel_hopper_cb_t cb) {
+    for (int i = 0; i < CHANNEL_HOPPER_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].cb == cb) {
+            subscribers[i].cb = NULL;
+        }
+    }
+}
+
+void channel_hopper_get_stats(channel_hopper_stats_t* out) {
+    *out = stats;
+}
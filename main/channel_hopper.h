@@ -0,0 +1,58 @@
+#ifndef CHANNEL_HOPPER_H
+#define CHANNEL_HOPPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Channel-hopping service for promiscuous modes. A task walks the hop list,
+// parking the radio on each channel for its dwell time. In adaptive mode the
+// dwell of each channel is re-weighted after every sweep from its recent
+// frame yield and how many previously unseen BSSIDs it produced, so busy or
+// new channels get more air time while quiet ones are still visited.
+#define CHANNEL_HOPPER_MAX_CHANNELS 14
+#define CHANNEL_HOPPER_MAX_SUBSCRIBERS 4
+
+typedef struct {
+    const uint8_t* channels;    // NULL = 1..CHANNEL_HOP_LAST_CHANNEL
+    uint8_t channel_count;
+    uint16_t dwell_ms;          // fixed dwell, or the starting dwell when adaptive
+    bool adaptive;
+    uint16_t min_dwell_ms;
+    uint16_t max_dwell_ms;
+} channel_hopper_config_t;
+
+typedef struct {
+    uint8_t channel;
+    uint32_t frames;            // total frames seen on this channel
+    uint32_t new_bssids;        // BSSIDs first seen on this channel
+    uint32_t visits;
+    uint32_t total_dwell_ms;    // time the radio has spent here
+    uint16_t dwell_ms;          // dwell planned for the next visit
+    float yield;                // smoothed frames per second while parked
+} channel_hopper_channel_t;
+
+typedef struct {
+    uint32_t sweeps;
+    uint8_t channel_count;
+    channel_hopper_channel_t channels[CHANNEL_HOPPER_MAX_CHANNELS];
+} channel_hopper_stats_t;
+
+// Called from the hopper task after every full sweep
+typedef void (*channel_hopper_cb_t)(const channel_hopper_stats_t* stats, void* ctx);
+
+// Starts hopping; config NULL uses the board defaults (adaptive, all channels)
+esp_err_t channel_hopper_start(const channel_hopper_config_t* config);
+void channel_hopper_stop(void);
+bool channel_hopper_is_running(void);
+uint8_t channel_hopper_current_channel(void);
+
+// Feed from promiscuous callbacks so the adaptive mode can score channels
+void channel_hopper_note_frame(const wifi_promiscuous_pkt_t* pkt);
+
+esp_err_t channel_hopper_subscribe(channel_hopper_cb_t cb, void* ctx);
+void channel_hopper_unsubscribe(channel_hopper_cb_t cb);
+void channel_hopper_get_stats(channel_hopper_stats_t* stats);
+
+#endif // CHANNEL_HOPPER_H
@@ -0,0 +1,424 @@
+#include "device_table.h"
+#include "board_config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char* TAG = "DEV_TABLE";
+
+#define NONE            0xFFFF
+#define RSSI_SHIFT      4       // smoothed RSSI is kept in 1/16 dB
+#define RSSI_ALPHA_SHIFT 2      // each sighting moves it a quarter of the way
+
+// Column store; every array has `capacity` rows
+static struct {
+    uint8_t (*mac)[6];
+    uint8_t* kind;
+    uint8_t* flags;
+    char (*name)[DEVICE_NAME_LEN];
+    int16_t* rssi_avg;
+    int8_t* rssi_last;
+    int8_t* rssi_min;
+    int8_t* rssi_max;
+    int8_t (*rssi_hist)[DEVICE_RSSI_HISTORY];   // ring indexed by sightings
+    uint8_t* channel;
+    uint8_t* authmode;
+    uint32_t* first_seen;
+    uint32_t* last_seen;
+    uint32_t* sightings;
+    uint16_t* free_stack;
+    uint16_t* lru_prev;     // recency list, most recently seen at lru_head
+    uint16_t* lru_next;
+    uint16_t* index;        // index_slots entries, NONE when empty
+} col;
+
+static void* storage = NULL;
+static uint16_t capacity;
+static uint16_t index_mask;
+static uint16_t high_water;     // rows ever handed out
+static uint16_t free_top;
+static uint16_t lru_head = NONE;
+static uint16_t lru_tail = NONE;
+static uint16_t kind_count[4];
+
+// Every caller runs in a task (scan events, the BLE dispatcher, UI), so the
+// table is guarded by a mutex: full-table scans no longer hold a critical
+// section with interrupts off while the radios are inserting
+static SemaphoreHandle_t table_mutex = NULL;
+static StaticSemaphore_t table_mutex_buf;
+
+static void table_lock(void) {
+    xSemaphoreTake(table_mutex, portMAX_DELAY);
+}
+
+static void table_unlock(void) {
+    xSemaphoreGive(table_mutex);
+}
+
+static size_t row_bytes(void) {
+    return 6 + 1 + 1 + DEVICE_NAME_LEN + 2 + 1 + 1 + 1 + DEVICE_RSSI_HISTORY + 1 + 1 + 4 + 4 + 4 + 2 + 2 + 2;
+}
+
+uint32_t device_table_now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+static uint32_t key_hash(uint8_t kind, const uint8_t* mac) {
+    uint32_t h = (2166136261u ^ kind) * 16777619u;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    return h & index_mask;
+}
+
+// Rows and power-of-two index slots (at least twice the rows) that fit budget
+static size_t table_layout(size_t budget, size_t* slots) {
+    size_t rows = budget / (row_bytes() + 2 * sizeof(uint16_t));
+    if (rows > 0x8000) rows = 0x8000;
+    *slots = 1;
+    while (*slots < rows * 2) *slots <<= 1;
+    while (rows > 0 && rows * row_bytes() + *slots * sizeof(uint16_t) > budget) rows--;
+    return rows;
+}
+
+esp_err_t device_table_init(void) {
+    if (storage) {
+        return ESP_OK;
+    }
+
+    // Without PSRAM the full budget may not fit next to the radio stacks;
+    // a smaller table beats none
+    size_t rows = 0, slots = 0, total = 0;
+    for (size_t budget = DEVICE_TABLE_BUDGET; storage == NULL; budget /= 2) {
+        rows = table_layout(budget, &slots);
+        if (rows < 16) {
+            ESP_LOGE(TAG, "No memory for a device table");
+            return ESP_ERR_NO_MEM;
+        }
+        total = rows * row_bytes() + slots * sizeof(uint16_t);
+        storage = heap_caps_calloc(1, total, MALLOC_CAP_SPIRAM);
+        if (storage == NULL) {
+            storage = heap_caps_calloc(1, total, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (storage == NULL) {
+            ESP_LOGW(TAG, "No memory for %u byte table, trying half", (unsigned)total);
+        }
+    }
+    table_mutex = xSemaphoreCreateMutexStatic(&table_mutex_buf);
+
+    // Widest columns first so every array stays naturally aligned
+    uint8_t* p = storage;
+    col.first_seen = (uint32_t*)p;  p += rows * sizeof(uint32_t);
+    col.last_seen = (uint32_t*)p;   p += rows * sizeof(uint32_t);
+    col.sightings = (uint32_t*)p;   p += rows * sizeof(uint32_t);
+    col.rssi_avg = (int16_t*)p;     p += rows * sizeof(int16_t);
+    col.free_stack = (uint16_t*)p;  p += rows * sizeof(uint16_t);
+    col.lru_prev = (uint16_t*)p;    p += rows * sizeof(uint16_t);
+    col.lru_next = (uint16_t*)p;    p += rows * sizeof(uint16_t);
+    col.index = (uint16_t*)p;       p += slots * sizeof(uint16_t);
+    col.mac = (void*)p;             p += rows * 6;
+    col.name = (void*)p;            p += rows * DEVICE_NAME_LEN;
+    col.kind = p;                   p += rows;
+    col.flags = p;                  p += rows;
+    col.rssi_last = (int8_t*)p;     p += rows;
+    col.rssi_min = (int8_t*)p;      p += rows;
+    col.rssi_max = (int8_t*)p;      p += rows;
+    col.rssi_hist = (void*)p;       p += rows * DEVICE_RSSI_HISTORY;
+    col.channel = p;                p += rows;
+    col.authmode = p;
+
+    capacity = rows;
+    index_mask = slots - 1;
+    memset(col.index, 0xFF, slots * sizeof(uint16_t));
+
+    ESP_LOGI(TAG, "Device table: %u entries in %u bytes", (unsigned)rows, (unsigned)total);
+    return ESP_OK;
+}
+
+uint16_t device_table_capacity(void) {
+    return capacity;
+}
+
+static uint32_t index_slot(uint8_t kind, const uint8_t* mac) {
+    uint32_t i = key_hash(kind, mac);
+    while (col.index[i] != NONE) {
+        uint16_t r = col.index[i];
+        if (col.kind[r] == kind && memcmp(col.mac[r], mac, 6) == 0) break;
+        i = (i + 1) & index_mask;
+    }
+    return i;
+}
+
+static void lru_unlink(uint16_t r) {
+    uint16_t prev = col.lru_prev[r];
+    uint16_t next = col.lru_next[r];
+    if (prev != NONE) col.lru_next[prev] = next; else lru_head = next;
+    if (next != NONE) col.lru_prev[next] = prev; else lru_tail = prev;
+}
+
+// Every sighting stamps last_seen with the current time, so moving the row
+// to the head keeps the list in last_seen order and its tail is the entry
+// heard from least recently
+static void lru_push_head(uint16_t r) {
+    col.lru_prev[r] = NONE;
+    col.lru_next[r] = lru_head;
+    if (lru_head != NONE) col.lru_prev[lru_head] = r; else lru_tail = r;
+    lru_head = r;
+}
+
+// Linear-probing delete with backward shift, so lookups need no tombstones
+static void remove_row(uint16_t r) {
+    uint32_t i = index_slot(col.kind[r], col.mac[r]);
+
+    col.index[i] = NONE;
+    for (uint32_t j = (i + 1) & index_mask; col.index[j] != NONE; j = (j + 1) & index_mask) {
+        uint16_t moved = col.index[j];
+        uint32_t home = key_hash(col.kind[moved], col.mac[moved]);
+        bool stays = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            col.index[i] = moved;
+            col.index[j] = NONE;
+            i = j;
+        }
+    }
+
+    lru_unlink(r);
+    kind_count[col.kind[r]]--;
+    col.kind[r] = DEVICE_KIND_NONE;
+    col.free_stack[free_top++] = r;
+}
+
+static uint16_t take_row(void) {
+    if (free_top > 0) {
+        return col.free_stack[--free_top];
+    }
+    if (high_water < capacity) {
+        return high_water++;
+    }
+
+    // Full: age out whichever entry was heard from least recently
+    remove_row(lru_tail);
+    return col.free_stack[--free_top];
+}
+
+int device_table_update(const device_sighting_t* s, bool* is_new) {
+    if (storage == NULL || s->kind == DEVICE_KIND_NONE || s->kind == DEVICE_KIND_ANY) {
+        return -1;
+    }
+
+    bool created = false;
+
+    // Stamped under the mutex so the recency list stays in last_seen order
+    table_lock();
+    uint32_t now = device_table_now_ms();
+    uint32_t slot = index_slot(s->kind, s->mac);
+    uint16_t r = col.index[slot];
+
+    if (r == NONE) {
+        r = take_row();
+        // Eviction may have shifted entries along our probe chain
+        slot = index_slot(s->kind, s->mac);
+        col.index[slot] = r;
+
+        memcpy(col.mac[r], s->mac, 6);
+        col.kind[r] = s->kind;
+        col.flags[r] = 0;
+        col.name[r][0] = '\0';
+        col.rssi_avg[r] = s->rssi * (1 << RSSI_SHIFT);
+        col.rssi_min[r] = s->rssi;
+        col.rssi_max[r] = s->rssi;
+        col.channel[r] = 0;
+        col.authmode[r] = 0;
+        col.first_seen[r] = now;
+        col.sightings[r] = 0;
+        kind_count[s->kind]++;
+        created = true;
+    } else {
+        lru_unlink(r);
+    }
+    lru_push_head(r);
+
+    col.rssi_avg[r] += ((s->rssi * (1 << RSSI_SHIFT)) - col.rssi_avg[r]) >> RSSI_ALPHA_SHIFT;
+    col.rssi_last[r] = s->rssi;
+    if (s->rssi < col.rssi_min[r]) col.rssi_min[r] = s->rssi;
+    if (s->rssi > col.rssi_max[r]) col.rssi_max[r] = s->rssi;
+    col.rssi_hist[r][col.sightings[r] % DEVICE_RSSI_HISTORY] = s->rssi;
+    if (s->channel) col.channel[r] = s->channel;
+    if (s->authmode) col.authmode[r] = s->authmode;
+    if (s->name) {
+        strncpy(col.name[r], s->name, DEVICE_NAME_LEN - 1);
+        col.name[r][DEVICE_NAME_LEN - 1] = '\0';
+    }
+    col.flags[r] |= s->flags;
+    col.last_seen[r] = now;
+    col.sightings[r]++;
+    table_unlock();
+
+    if (is_new) *is_new = created;
+    return r;
+}
+
+int device_table_find(device_kind_t kind, const uint8_t* mac) {
+    if (storage == NULL) return -1;
+
+    table_lock();
+    uint16_t r = col.index[index_slot(kind, mac)];
+    table_unlock();
+    return r == NONE ? -1 : r;
+}
+
+bool device_table_get(uint16_t id, device_info_t* info) {
+    if (storage == NULL || id >= capacity) return false;
+
+    table_lock();
+    bool valid = col.kind[id] != DEVICE_KIND_NONE;
+    if (valid) {
+        memcpy(info->mac, col.mac[id], 6);
+        info->kind = col.kind[id];
+        info->flags = col.flags[id];
+        memcpy(info->name, col.name[id], DEVICE_NAME_LEN);
+        info->rssi = col.rssi_avg[id] >> RSSI_SHIFT;
+        info->rssi_last = col.rssi_last[id];
+        info->rssi_min = col.rssi_min[id];
+        info->rssi_max = col.rssi_max[id];
+        info->channel = col.channel[id];
+        info->authmode = col.authmode[id];
+        info->first_seen_ms = col.first_seen[id];
+        info->last_seen_ms = col.last_seen[id];
+        info->sightings = col.sightings[id];
+    }
+    table_unlock();
+    return valid;
+}
+
+size_t device_table_rssi_history(uint16_t id, int8_t* rssi, size_t max) {
+    if (storage == NULL || id >= capacity) return 0;
+
+    size_t n = 0;
+    table_lock();
+    if (col.kind[id] != DEVICE_KIND_NONE) {
+        uint32_t total = col.sightings[id];
+        uint32_t kept = total < DEVICE_RSSI_HISTORY ? total : DEVICE_RSSI_HISTORY;
+        if (kept > max) kept = max;
+        for (uint32_t i = total - kept; i < total; i++) {
+            rssi[n++] = col.rssi_hist[id][i % DEVICE_RSSI_HISTORY];
+        }
+    }
+    table_unlock();
+    return n;
+}
+
+// Query results are sorted on a snapshot of their keys taken under the
+// mutex, so a concurrent update cannot change a key mid-sort
+typedef struct {
+    int32_t key;        // ascending
+    uint16_t id;
+} sort_row_t;
+
+static int32_t sort_key(uint16_t r, device_order_t order, uint32_t now) {
+    switch (order) {
+    case DEVICE_ORDER_RSSI:
+        return -col.rssi_avg[r];                        // strongest first
+    case DEVICE_ORDER_LAST_SEEN:
+        return (int32_t)(now - col.last_seen[r]);       // most recent first
+    default:
+        return -(int32_t)(now - col.first_seen[r]);     // oldest first
+    }
+}
+
+static int compare_sort_rows(const void* a, const void* b) {
+    const sort_row_t* ra = a;
+    const sort_row_t* rb = b;
+    if (ra->key != rb->key) return ra->key < rb->key ? -1 : 1;
+    return ra->id - rb->id;
+}
+
+size_t device_table_query(device_kind_t kind, uint8_t flags_mask, uint32_t seen_since_ms,
+                          device_order_t order, uint16_t* ids, size_t max) {
+    if (storage == NULL || max == 0) return 0;
+
+    // Every match is keyed so the first max after sorting are the best ones
+    sort_row_t* rows = heap_caps_malloc(capacity * sizeof(sort_row_t), MALLOC_CAP_SPIRAM);
+    if (rows == NULL) {
+        rows = heap_caps_malloc(capacity * sizeof(sort_row_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (rows == NULL) {
+        ESP_LOGW(TAG, "No memory to sort %u rows", (unsigned)capacity);
+        return 0;
+    }
+
+    size_t n = 0;
+    table_lock();
+    uint32_t now = device_table_now_ms();
+    for (uint16_t r = 0; r < high_water; r++) {
+        if (col.kind[r] == DEVICE_KIND_NONE) continue;
+        if (kind != DEVICE_KIND_ANY && col.kind[r] != kind) continue;
+        if ((col.flags[r] & flags_mask) != flags_mask) continue;
+        if (seen_since_ms && (int32_t)(col.last_seen[r] - seen_since_ms) < 0) continue;
+        rows[n].key = sort_key(r, order, now);
+        rows[n].id = r;
+        n++;
+    }
+    table_unlock();
+
+    qsort(rows, n, sizeof(sort_row_t), compare_sort_rows);
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) {
+        ids[i] = rows[i].id;
+    }
+    free(rows);
+    return n;
+}
+
+uint16_t device_table_count(device_kind_t kind) {
+    if (kind == DEVICE_KIND_ANY) {
+        return kind_count[DEVICE_KIND_WIFI_AP] + kind_count[DEVICE_KIND_WIFI_STA] +
+               kind_count[DEVICE_KIND_BLE];
+    }
+    return kind < 4 ? kind_count[kind] : 0;
+}
+
+void device_table_clear(device_kind_t kind) {
+    if (storage == NULL) return;
+
+    table_lock();
+    for (uint16_t r = 0; r < high_water; r++) {
+        if (col.kind[r] != DEVICE_KIND_NONE && (kind == DEVICE_KIND_ANY || col.kind[r] == kind)) {
+            remove_row(r);
+        }
+    }
+    table_unlock();
+}
+
+void device_table_clear_flags(device_kind_t kind, uint8_t flags) {
+    if (storage == NULL) return;
+
+    table_lock();
+    for (uint16_t r = 0; r < high_water; r++) {
+        if (kind == DEVICE_KIND_ANY || col.kind[r] == kind) {
+            col.flags[r] &= ~flags;
+        }
+    }
+    table_unlock();
+}
+
+uint16_t device_table_expire(device_kind_t kind, uint32_t max_age_ms) {
+    if (storage == NULL) return 0;
+
+    uint32_t now = device_table_now_ms();
+    uint16_t dropped = 0;
+    table_lock();
+    for (uint16_t r = 0; r < high_water; r++) {
+        if (col.kind[r] == DEVICE_KIND_NONE || (kind != DEVICE_KIND_ANY && col.kind[r] != kind)) {
+            continue;
+        }
+        if (now - col.last_seen[r] > max_age_ms) {
+            remove_row(r);
+            dropped++;
+        }
+    }
+    table_unlock();
+    return dropped;
+}
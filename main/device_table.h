@@ -0,0 +1,91 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Shared store of everything the radios have seen: Wi-Fi APs, Wi-Fi
+// stations and BLE devices, keyed by (kind, MAC). Columns are kept as
+// separate arrays (struct-of-arrays) in one allocation sized from
+// DEVICE_TABLE_BUDGET, with an open-addressing hash index on top. When the
+// table is full the entry heard from least recently is evicted.
+#define DEVICE_NAME_LEN     33
+#define DEVICE_RSSI_HISTORY 8       // raw RSSI of the most recent sightings, per entry
+
+typedef enum {
+    DEVICE_KIND_NONE = 0,
+    DEVICE_KIND_WIFI_AP,
+    DEVICE_KIND_WIFI_STA,
+    DEVICE_KIND_BLE,
+    DEVICE_KIND_ANY = 0xFF
+} device_kind_t;
+
+// Flags owned by consumers
+#define DEVICE_FLAG_WATCHED     0x01    // matched an OUI filter / watchlist
+
+typedef enum {
+    DEVICE_ORDER_RSSI,          // strongest (smoothed) first
+    DEVICE_ORDER_LAST_SEEN,     // most recent first
+    DEVICE_ORDER_FIRST_SEEN     // oldest first, i.e. discovery order
+} device_order_t;
+
+// One observation to merge into the table
+typedef struct {
+    device_kind_t kind;
+    const uint8_t* mac;
+    int8_t rssi;
+    uint8_t channel;            // 0 = unknown / keep previous
+    const char* name;           // SSID or BLE name; NULL keeps previous
+    uint8_t authmode;
+    uint8_t flags;              // ORed into the entry's flags
+} device_sighting_t;
+
+typedef struct {
+    uint8_t mac[6];
+    device_kind_t kind;
+    uint8_t flags;
+    char name[DEVICE_NAME_LEN];
+    int8_t rssi;                // smoothed
+    int8_t rssi_last;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    uint8_t channel;
+    uint8_t authmode;
+    uint32_t first_seen_ms;
+    uint32_t last_seen_ms;
+    uint32_t sightings;
+} device_info_t;
+
+esp_err_t device_table_init(void);
+uint16_t device_table_capacity(void);
+
+// Clock used for first/last seen stamps
+uint32_t device_table_now_ms(void);
+
+// Inserts or refreshes an entry; returns its id or -1 if the table is not
+// initialized. is_new (optional) reports whether the device was unknown.
+int device_table_update(const device_sighting_t* sighting, bool* is_new);
+
+int device_table_find(device_kind_t kind, const uint8_t* mac);
+bool device_table_get(uint16_t id, device_info_t* info);
+
+// Copies up to max of the entry's recent raw RSSI readings, oldest first;
+// returns how many were written
+size_t device_table_rssi_history(uint16_t id, int8_t* rssi, size_t max);
+
+// Fills ids with entries of kind whose flags include all of flags_mask and
+// that were seen at or after seen_since_ms (0 = any time), sorted by order;
+// returns how many were written
+size_t device_table_query(device_kind_t kind, uint8_t flags_mask, uint32_t seen_since_ms,
+                          device_order_t order, uint16_t* ids, size_t max);
+uint16_t device_table_count(device_kind_t kind);
+
+void device_table_clear(device_kind_t kind);
+void device_table_clear_flags(device_kind_t kind, uint8_t flags);
+
+// Drops entries of kind not heard from in max_age_ms; returns how many
+uint16_t device_table_expire(device_kind_t kind, uint32_t max_age_ms);
+
+#endif // DEVICE_TABLE_H
@@ -1,7 +1,11 @@
 #include "display.h"
+#include "font_large.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -11,6 +15,8 @@ static const char* TAG = "DISPLAY";
 spi_device_handle_t spi_device;
 static SemaphoreHandle_t display_mutex = NULL;
 
+static void display_compositor_init(void);
+
 // ILI9341 Commands
 #define ILI9341_SWRESET     0x01
 #define ILI9341_SLPOUT      0x11
@@ -18,29 +24,118 @@ static SemaphoreHandle_t display_mutex = NULL;
 #define ILI9341_CASET       0x2A
 #define ILI9341_PASET       0x2B
 #define ILI9341_RAMWR       0x2C
+#define ILI9341_VSCRDEF     0x33
 #define ILI9341_MADCTL      0x36
+#define ILI9341_VSCRSADD    0x37
 #define ILI9341_COLMOD      0x3A
 
+// Display traffic is queued to the SPI driver instead of polled, so drawing
+// calls return while DMA is still shifting the previous burst out. The
+// driver completes transactions in order; DC is driven from the pre-transfer
+// callback using the level stashed in t->user. All queue state is guarded by
+// display_mutex.
+#define LCD_QUEUE_DEPTH     7
+#define LCD_BUF_COUNT       2
+#define LCD_BUF_PIXELS      (DISPLAY_WIDTH * 8)
+
+static display_stats_t lcd_stats;
+
+static spi_transaction_t lcd_trans[LCD_QUEUE_DEPTH];
+static int lcd_trans_head = 0;
+static uint32_t lcd_queued_seq = 0;     // transactions handed to the driver
+static uint32_t lcd_done_seq = 0;       // transactions reaped
+
+// Double-buffered DMA line buffers; each remembers the last transaction
+// reading from it so it is only rewritten once that burst has left
+static DMA_ATTR uint16_t lcd_bufs[LCD_BUF_COUNT][LCD_BUF_PIXELS];
+static uint32_t lcd_buf_seq[LCD_BUF_COUNT];
+static int lcd_buf_next = 0;
+
+// Last address window sent to the panel. CASET/PASET persist across RAMWR,
+// so a window that repeats a column or page range only needs RAMWR for it.
+// Raw commands through lcd_cmd() invalidate the cache.
+static bool win_valid = false;
+static uint16_t win_x0, win_x1, win_y0, win_y1;
+
+static void IRAM_ATTR lcd_pre_transfer_cb(spi_transaction_t* t) {
+    gpio_set_level(LCD_DC_PIN, (int)(intptr_t)t->user);
+}
+
+static void lcd_reap_until(uint32_t seq) {
+    while ((int32_t)(lcd_done_seq - seq) < 0) {
+        spi_transaction_t* done;
+        if (spi_device_get_trans_result(spi_device, &done, portMAX_DELAY) != ESP_OK) {
+            break;
+        }
+        lcd_done_seq++;
+    }
+}
+
+static esp_err_t lcd_queue(const void* data, size_t len, int dc) {
+    // The slot at head is free once the transaction queued depth ago is reaped
+    if (lcd_queued_seq - lcd_done_seq >= LCD_QUEUE_DEPTH) {
+        lcd_reap_until(lcd_queued_seq - LCD_QUEUE_DEPTH + 1);
+    }
+
+    spi_transaction_t* t = &lcd_trans[lcd_trans_head];
+    memset(t, 0, sizeof(*t));
+    t->length = len * 8;
+    t->user = (void*)(intptr_t)dc;
+    if (len <= sizeof(t->tx_data)) {
+        t->flags = SPI_TRANS_USE_TXDATA;
+        memcpy(t->tx_data, data, len);
+    } else {
+        t->tx_buffer = data;
+    }
+
+    esp_err_t ret = spi_device_queue_trans(spi_device, t, portMAX_DELAY);
+    if (ret == ESP_OK) {
+        lcd_trans_head = (lcd_trans_head + 1) % LCD_QUEUE_DEPTH;
+        lcd_queued_seq++;
+        lcd_stats.transactions++;
+        lcd_stats.bytes += len;
+    }
+    return ret;
+}
+
+// Returns the next line buffer once the DMA reading it has finished
+static int lcd_acquire_buffer(void) {
+    int idx = lcd_buf_next;
+    lcd_buf_next = (lcd_buf_next + 1) % LCD_BUF_COUNT;
+    lcd_reap_until(lcd_buf_seq[idx]);
+    return idx;
+}
+
+static esp_err_t lcd_queue_pixels(int idx, const uint16_t* pixels, size_t count) {
+    esp_err_t ret = lcd_queue(pixels, count * 2, 1);
+    lcd_buf_seq[idx] = lcd_queued_seq;
+    return ret;
+}
+
+static bool lcd_lock(void) {
+    return display_mutex == NULL || xSemaphoreTake(display_mutex, pdMS_TO_TICKS(100)) == pdTRUE;
+}
+
+static void lcd_unlock(void) {
+    if (display_mutex) {
+        xSemaphoreGive(display_mutex);
+    }
+}
+
 esp_err_t lcd_cmd(uint8_t cmd) {
     if (spi_device == NULL) {
         ESP_LOGE(TAG, "SPI device not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (display_mutex && xSemaphoreTake(display_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    if (!lcd_lock()) {
         return ESP_ERR_TIMEOUT;
     }
     
-    gpio_set_level(LCD_DC_PIN, 0);
-    spi_transaction_t t = {
-        .length = 8,
-        .tx_buffer = &cmd,
-    };
-    esp_err_t ret = spi_device_polling_transmit(spi_device, &t);
+    win_valid = false;
+    esp_err_t ret = lcd_queue(&cmd, 1, 0);
     
-    if (display_mutex) {
-        xSemaphoreGive(display_mutex);
-    }
+    lcd_unlock();
     return ret;
 }
 
@@ -50,23 +145,38 @@ esp_err_t lcd_data(uint8_t data) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (display_mutex && xSemaphoreTake(display_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    if (!lcd_lock()) {
         return ESP_ERR_TIMEOUT;
     }
     
-    gpio_set_level(LCD_DC_PIN, 1);
-    spi_transaction_t t = {
-        .length = 8,
-        .tx_buffer = &data,
-    };
-    esp_err_t ret = spi_device_polling_transmit(spi_device, &t);
+    esp_err_t ret = lcd_queue(&data, 1, 1);
     
-    if (display_mutex) {
-        xSemaphoreGive(display_mutex);
-    }
+    lcd_unlock();
     return ret;
 }
 
+void display_get_stats(display_stats_t* stats) {
+    if (lcd_lock()) {
+        *stats = lcd_stats;
+        lcd_unlock();
+    }
+}
+
+void display_reset_stats(void) {
+    if (lcd_lock()) {
+        memset(&lcd_stats, 0, sizeof(lcd_stats));
+        lcd_unlock();
+    }
+}
+
+void display_wait_idle(void) {
+    if (spi_device == NULL || !lcd_lock()) {
+        return;
+    }
+    lcd_reap_until(lcd_queued_seq);
+    lcd_unlock();
+}
+
 esp_err_t display_init(void) {
     // Create mutex first
     display_mutex = xSemaphoreCreateMutex();
@@ -99,8 +209,9 @@ esp_err_t display_init(void) {
         .clock_speed_hz = SPI_FREQUENCY,
         .mode = 0,
         .spics_io_num = LCD_CS_PIN,
-        .queue_size = 7,
+        .queue_size = LCD_QUEUE_DEPTH,
         .flags = SPI_DEVICE_NO_DUMMY,
+        .pre_cb = lcd_pre_transfer_cb,
     };
 
     esp_err_t ret = spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO);
@@ -118,9 +229,11 @@ esp_err_t display_init(void) {
     
     // Initialize ILI9341 with complete sequence
     lcd_cmd(ILI9341_SWRESET);
+    display_wait_idle();
     vTaskDelay(pdMS_TO_TICKS(150));
     
     lcd_cmd(ILI9341_SLPOUT);
+    display_wait_idle();
     vTaskDelay(pdMS_TO_TICKS(150));
     
     // Power control
@@ -185,12 +298,15 @@ esp_err_t display_init(void) {
     lcd_data(0x31); lcd_data(0x36); lcd_data(0x0F);
     
     lcd_cmd(ILI9341_SLPOUT);
+    display_wait_idle();
     vTaskDelay(pdMS_TO_TICKS(120));
     
     lcd_cmd(ILI9341_DISPON);
+    display_wait_idle();
     vTaskDelay(pdMS_TO_TICKS(120));
     
     display_fill_screen(COLOR_BLACK);
+    display_compositor_init();
 
     ESP_LOGI(TAG, "Display initialized");
     return ESP_OK;
@@ -200,20 +316,436 @@ void display_fill_screen(uint16_t color) {
     display_fill_rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, color);
 }
 
+static void lcd_queue_cmd(uint8_t cmd, const uint8_t* args, size_t len) {
+    lcd_queue(&cmd, 1, 0);
+    if (len > sizeof(((spi_transaction_t*)0)->tx_data)) {
+        // Too long to copy into the transaction; stage it so the caller's
+        // buffer may go out of scope while DMA is pending
+        int idx = lcd_acquire_buffer();
+        memcpy(lcd_bufs[idx], args, len);
+        lcd_queue(lcd_bufs[idx], len, 1);
+        lcd_buf_seq[idx] = lcd_queued_seq;
+    } else if (len > 0) {
+        lcd_queue(args, len, 1);
+    }
+}
+
+// Queues the window setup as one batch under the caller's lock: 5
+// transactions when both ranges change, down to a lone RAMWR when neither does
+static void lcd_window(int x, int y, int w, int h) {
+    uint16_t x1 = x + w - 1;
+    uint16_t y1 = y + h - 1;
+
+    lcd_stats.windows++;
+    if (win_valid && win_x0 == x && win_x1 == x1) lcd_stats.ranges_skipped++;
+    if (win_valid && win_y0 == y && win_y1 == y1) lcd_stats.ranges_skipped++;
+
+    if (!win_valid || win_x0 != x || win_x1 != x1) {
+        uint8_t xa[4] = { x >> 8, x & 0xFF, x1 >> 8, x1 & 0xFF };
+        lcd_queue_cmd(ILI9341_CASET, xa, sizeof(xa));
+        win_x0 = x;
+        win_x1 = x1;
+    }
+    if (!win_valid || win_y0 != y || win_y1 != y1) {
+        uint8_t ya[4] = { y >> 8, y & 0xFF, y1 >> 8, y1 & 0xFF };
+        lcd_queue_cmd(ILI9341_PASET, ya, sizeof(ya));
+        win_y0 = y;
+        win_y1 = y1;
+    }
+    win_valid = true;
+
+    lcd_queue_cmd(ILI9341_RAMWR, NULL, 0);
+}
+
 void set_addr_window(int16_t x, int16_t y, int16_t w, int16_t h) {
-    lcd_cmd(ILI9341_CASET);
-    lcd_data(x >> 8);
-    lcd_data(x & 0xFF);
-    lcd_data((x + w - 1) >> 8);
-    lcd_data((x + w - 1) & 0xFF);
+    if (spi_device == NULL || !lcd_lock()) return;
+    lcd_window(x, y, w, h);
+    lcd_unlock();
+}
+
+static void lcd_fill_direct(int x, int y, int w, int h, uint16_t color_be) {
+    uint32_t pixels = w * h;
+
+    lcd_window(x, y, w, h);
 
-    lcd_cmd(ILI9341_PASET);
-    lcd_data(y >> 8);
-    lcd_data(y & 0xFF);
-    lcd_data((y + h - 1) >> 8);
-    lcd_data((y + h - 1) & 0xFF);
+    // One buffer of solid color is queued repeatedly for the whole area
+    int idx = lcd_acquire_buffer();
+    uint16_t* buf = lcd_bufs[idx];
+    uint32_t chunk = pixels < LCD_BUF_PIXELS ? pixels : LCD_BUF_PIXELS;
+    for (uint32_t i = 0; i < chunk; i++) {
+        buf[i] = color_be;
+    }
+
+    while (pixels > 0) {
+        uint32_t n = pixels < chunk ? pixels : chunk;
+        lcd_queue_pixels(idx, buf, n);
+        pixels -= n;
+    }
+}
+
+// Banded compositor. Fills and text are kept as a display list instead of
+// pixels, so no framebuffer is needed: at flush time each 16-row band with
+// touched tiles is rendered from the list into one reused band buffer, tiles
+// whose CRC still matches what was last sent are dropped, and the remaining
+// runs of tiles go to the panel. A screen that is cleared and repainted with
+// the same content therefore costs no bus traffic, over the whole screen.
+//
+// A tile is "known" while the list fully describes it, which starts when a
+// single operation covers it (display_fill_screen covers them all). Drawing
+// that only partly covers an unknown tile goes straight to the panel, as do
+// bitmaps, which leave their tiles unknown. Every list entry is opaque, so
+// an entry entirely under a newer one is dropped; a list that still fills up
+// is flushed and forgotten, leaving every tile unknown until repainted.
+// The list lives in PSRAM when present; pixels are in wire byte order.
+#define FB_TILE             16
+#define FB_TILES_X          (DISPLAY_WIDTH / FB_TILE)
+#define FB_TILES_Y          (DISPLAY_HEIGHT / FB_TILE)
+
+enum { FB_OP_DEAD, FB_OP_FILL, FB_OP_TEXT };
+
+// One list entry; text entries are followed by their visible characters
+typedef struct {
+    uint8_t kind;
+    uint8_t font;               // text: index into text_fonts
+    uint8_t scale;
+    uint8_t len;
+    uint16_t size;              // entry bytes, including the text
+    int16_t x0, y0, x1, y1;     // clipped extent, end exclusive
+    int16_t tx, ty;             // text: origin of the first character
+    uint16_t fg, bg;            // fill color is fg
+    char text[];
+} fb_op_t;
+
+static uint8_t* fb_list;
+static size_t fb_list_size;
+static size_t fb_list_used;
+static size_t fb_list_dead;
+static uint16_t* fb_band;                   // FB_TILE rows, reused per band
+static uint32_t fb_known[FB_TILES_Y];       // bit per tile column
+static uint32_t fb_dirty[FB_TILES_Y];       // touched since the last flush
+static uint32_t fb_sent[FB_TILES_Y];        // fb_tile_crc holds what was sent
+static uint32_t fb_tile_crc[FB_TILES_Y][FB_TILES_X];
+static uint32_t fb_draw_seq;                // bumped by every drawing call
+static bool fb_active = false;
+
+static void fb_render_text(const fb_op_t* op, int x0, int y0, int x1, int y1,
+                           uint16_t* dst, int stride);
+
+#define FB_OPS_FOREACH(op) \
+    for (fb_op_t* op = (fb_op_t*)fb_list; (uint8_t*)op < fb_list + fb_list_used; \
+         op = (fb_op_t*)((uint8_t*)op + op->size))
+
+static inline uint32_t fb_span_mask(int tx0, int tx1) {
+    return ((1u << (tx1 + 1)) - 1) & ~((1u << tx0) - 1);
+}
+
+// Renders the part of op inside [x0, x1) x [y0, y1) into dst
+static void fb_render_op(const fb_op_t* op, int x0, int y0, int x1, int y1,
+                         uint16_t* dst, int stride) {
+    if (op->kind == FB_OP_TEXT) {
+        fb_render_text(op, x0, y0, x1, y1, dst, stride);
+        return;
+    }
+    for (int y = y0; y < y1; y++, dst += stride) {
+        for (int i = 0; i < x1 - x0; i++) {
+            dst[i] = op->fg;
+        }
+    }
+}
+
+// Draws the part of op inside the given rectangle straight to the panel
+static void lcd_draw_op(const fb_op_t* op, int x, int y, int w, int h) {
+    if (op->kind == FB_OP_FILL) {
+        lcd_fill_direct(x, y, w, h, op->fg);
+        return;
+    }
+
+    int rows_per_buf = LCD_BUF_PIXELS / w;
+    lcd_window(x, y, w, h);
+    for (int r = 0; r < h; r += rows_per_buf) {
+        int rows = (h - r < rows_per_buf) ? h - r : rows_per_buf;
+        int idx = lcd_acquire_buffer();
+        fb_render_op(op, x, y + r, x + w, y + r + rows, lcd_bufs[idx], w);
+        lcd_queue_pixels(idx, lcd_bufs[idx], rows * w);
+    }
+}
+
+// Marks entries lying entirely inside the rectangle dead
+static void fb_list_prune(int x0, int y0, int x1, int y1) {
+    FB_OPS_FOREACH(op) {
+        if (op->kind != FB_OP_DEAD && op->x0 >= x0 && op->x1 <= x1 &&
+            op->y0 >= y0 && op->y1 <= y1) {
+            op->kind = FB_OP_DEAD;
+            fb_list_dead += op->size;
+        }
+    }
+    if (fb_list_dead == fb_list_used) {
+        fb_list_used = fb_list_dead = 0;
+    }
+}
+
+// Makes room for size more bytes, squeezing out dead entries if needed
+static bool fb_list_reserve(size_t size) {
+    if (fb_list_used + size <= fb_list_size) return true;
+    if (fb_list_used - fb_list_dead + size > fb_list_size) return false;
+
+    // The move can overwrite the entry's own header, so step over it first
+    size_t out = 0;
+    for (size_t in = 0; in < fb_list_used;) {
+        fb_op_t* op = (fb_op_t*)(fb_list + in);
+        size_t size = op->size;
+        if (op->kind != FB_OP_DEAD) {
+            memmove(fb_list + out, op, size);
+            out += size;
+        }
+        in += size;
+    }
+    fb_list_used = out;
+    fb_list_dead = 0;
+    return true;
+}
 
-    lcd_cmd(ILI9341_RAMWR);
+// Pushes one run of tiles from the band buffer
+static void fb_send_run(int tx0, int tx1, int band_y) {
+    int x = tx0 * FB_TILE;
+    int w = (tx1 - tx0 + 1) * FB_TILE;
+    int rows_per_buf = LCD_BUF_PIXELS / w;
+
+    lcd_stats.flush_rects++;
+    lcd_window(x, band_y, w, FB_TILE);
+    for (int r = 0; r < FB_TILE; r += rows_per_buf) {
+        int rows = (FB_TILE - r < rows_per_buf) ? FB_TILE - r : rows_per_buf;
+        int idx = lcd_acquire_buffer();
+        for (int i = 0; i < rows; i++) {
+            memcpy(&lcd_bufs[idx][i * w], fb_band + (r + i) * DISPLAY_WIDTH + x, w * sizeof(uint16_t));
+        }
+        lcd_queue_pixels(idx, lcd_bufs[idx], rows * w);
+    }
+}
+
+static uint32_t fb_tile_checksum(int tx) {
+    uint32_t crc = 0;
+    for (int i = 0; i < FB_TILE; i++) {
+        crc = esp_rom_crc32_le(crc, (const uint8_t*)(fb_band + i * DISPLAY_WIDTH + tx * FB_TILE),
+                               FB_TILE * sizeof(uint16_t));
+    }
+    return crc;
+}
+
+// Renders each band with touched tiles, drops tiles that ended up as they
+// were last sent and sends the rest as runs of tiles
+static void fb_flush_locked(void) {
+    for (int ty = 0; ty < FB_TILES_Y; ty++) {
+        uint32_t dirty = fb_dirty[ty];
+        if (!dirty) continue;
+        fb_dirty[ty] = 0;
+
+        int band_y = ty * FB_TILE;
+        int x0 = __builtin_ctz(dirty) * FB_TILE;
+        int x1 = (32 - __builtin_clz(dirty)) * FB_TILE;
+        FB_OPS_FOREACH(op) {
+            if (op->kind == FB_OP_DEAD || op->y1 <= band_y || op->y0 >= band_y + FB_TILE ||
+                op->x1 <= x0 || op->x0 >= x1) {
+                continue;
+            }
+            int cx0 = op->x0 > x0 ? op->x0 : x0;
+            int cx1 = op->x1 < x1 ? op->x1 : x1;
+            int cy0 = op->y0 > band_y ? op->y0 : band_y;
+            int cy1 = op->y1 < band_y + FB_TILE ? op->y1 : band_y + FB_TILE;
+            fb_render_op(op, cx0, cy0, cx1, cy1,
+                         fb_band + (cy0 - band_y) * DISPLAY_WIDTH + cx0, DISPLAY_WIDTH);
+        }
+
+        uint32_t send = 0;
+        for (uint32_t bits = dirty; bits; bits &= bits - 1) {
+            int tx = __builtin_ctz(bits);
+            uint32_t crc = fb_tile_checksum(tx);
+            if (!(fb_sent[ty] & (1u << tx)) || crc != fb_tile_crc[ty][tx]) {
+                fb_tile_crc[ty][tx] = crc;
+                send |= 1u << tx;
+            }
+        }
+        fb_sent[ty] |= dirty;
+
+        while (send) {
+            int tx0 = __builtin_ctz(send);
+            int tx1 = tx0;
+            while (tx1 + 1 < FB_TILES_X && (send & (1u << (tx1 + 1)))) tx1++;
+            send &= ~fb_span_mask(tx0, tx1);
+            fb_send_run(tx0, tx1, band_y);
+        }
+    }
+}
+
+// Stops describing the tiles under a rectangle that is about to be drawn
+// straight to the panel, after sending what is pending there
+static void fb_forget(int x0, int y0, int x1, int y1) {
+    int tx0 = x0 / FB_TILE, tx1 = (x1 - 1) / FB_TILE;
+    int ty0 = y0 / FB_TILE, ty1 = (y1 - 1) / FB_TILE;
+    uint32_t span = fb_span_mask(tx0, tx1);
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        if (fb_dirty[ty] & span) {
+            fb_flush_locked();
+            break;
+        }
+    }
+    for (int ty = ty0; ty <= ty1; ty++) {
+        fb_known[ty] &= ~span;
+        fb_sent[ty] &= ~span;
+    }
+    fb_list_prune(x0, y0, x1, y1);
+}
+
+// Records op for the tiles it leaves known and draws the rest of it now
+static void fb_draw(const fb_op_t* op) {
+    int tx0 = op->x0 / FB_TILE, tx1 = (op->x1 - 1) / FB_TILE;
+    int ty0 = op->y0 / FB_TILE, ty1 = (op->y1 - 1) / FB_TILE;
+    uint32_t span = fb_span_mask(tx0, tx1);
+    uint32_t direct[FB_TILES_Y];
+    bool record = false;
+
+    fb_draw_seq++;
+    if (fb_active && !fb_list_reserve(op->size)) {
+        // Out of list space: send everything and start over
+        fb_flush_locked();
+        memset(fb_known, 0, sizeof(fb_known));
+        memset(fb_sent, 0, sizeof(fb_sent));
+        fb_list_used = fb_list_dead = 0;
+    }
+
+    // Tiles the op covers completely, by column and by row
+    int fx0 = (op->x0 + FB_TILE - 1) / FB_TILE, fx1 = op->x1 / FB_TILE - 1;
+    uint32_t full_cols = fx0 <= fx1 ? fb_span_mask(fx0, fx1) : 0;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        direct[ty] = span;
+        if (!fb_active) continue;
+        if (op->y0 <= ty * FB_TILE && op->y1 >= (ty + 1) * FB_TILE) {
+            fb_known[ty] |= full_cols;
+        }
+        fb_dirty[ty] |= span & fb_known[ty];
+        direct[ty] = span & ~fb_known[ty];
+        record |= (span & fb_known[ty]) != 0;
+    }
+
+    if (record) {
+        fb_list_prune(op->x0, op->y0, op->x1, op->y1);
+        memcpy(fb_list + fb_list_used, op, op->size);
+        fb_list_used += op->size;
+    }
+
+    // Merge runs of tiles to draw directly with identical runs below them
+    for (int ty = ty0; ty <= ty1; ty++) {
+        while (direct[ty]) {
+            int rx0 = __builtin_ctz(direct[ty]);
+            int rx1 = rx0;
+            while (rx1 + 1 <= tx1 && (direct[ty] & (1u << (rx1 + 1)))) rx1++;
+
+            uint32_t mask = fb_span_mask(rx0, rx1);
+            int ry1 = ty;
+            while (ry1 + 1 <= ty1 && (direct[ry1 + 1] & mask) == mask) ry1++;
+            for (int t = ty; t <= ry1; t++) {
+                direct[t] &= ~mask;
+            }
+
+            int x0 = rx0 * FB_TILE > op->x0 ? rx0 * FB_TILE : op->x0;
+            int x1 = (rx1 + 1) * FB_TILE < op->x1 ? (rx1 + 1) * FB_TILE : op->x1;
+            int y0 = ty * FB_TILE > op->y0 ? ty * FB_TILE : op->y0;
+            int y1 = (ry1 + 1) * FB_TILE < op->y1 ? (ry1 + 1) * FB_TILE : op->y1;
+            lcd_draw_op(op, x0, y0, x1 - x0, y1 - y0);
+        }
+    }
+}
+
+void display_flush(void) {
+    if (!fb_active || !lcd_lock()) return;
+    fb_flush_locked();
+    lcd_unlock();
+}
+
+bool display_compositor_active(void) {
+    return fb_active;
+}
+
+// Screens clear and repaint in many calls, so pending tiles are only sent
+// once a whole period passes without drawing, or after DISPLAY_FB_MAX_HOLD_MS
+// of continuous drawing; display_flush() sends them at once
+static void display_compositor_task(void* arg) {
+    uint32_t seen = 0;
+    uint32_t held_ms = 0;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(DISPLAY_FB_IDLE_MS));
+        if (!lcd_lock()) continue;
+
+        uint32_t pending = 0;
+        for (int ty = 0; ty < FB_TILES_Y; ty++) {
+            pending |= fb_dirty[ty];
+        }
+        if (!pending) {
+            held_ms = 0;
+        } else if (fb_draw_seq == seen || held_ms >= DISPLAY_FB_MAX_HOLD_MS) {
+            fb_flush_locked();
+            held_ms = 0;
+        } else {
+            held_ms += DISPLAY_FB_IDLE_MS;
+        }
+        seen = fb_draw_seq;
+        lcd_unlock();
+    }
+}
+
+// Starts the list from the panel's known image (black after init)
+static void display_compositor_init(void) {
+    size_t band_bytes = FB_TILE * DISPLAY_WIDTH * sizeof(uint16_t);
+    size_t list_bytes = DISPLAY_FB_LIST_BYTES;
+
+    fb_list = heap_caps_malloc(list_bytes, MALLOC_CAP_SPIRAM);
+    bool in_psram = fb_list != NULL;
+    if (fb_list == NULL && heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >=
+                           list_bytes + band_bytes + DISPLAY_FB_INTERNAL_RESERVE) {
+        fb_list = heap_caps_malloc(list_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (fb_list) {
+        fb_band = heap_caps_calloc(1, band_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (fb_band == NULL) {
+        heap_caps_free(fb_list);
+        fb_list = NULL;
+        ESP_LOGI(TAG, "Compositor disabled (no memory)");
+        return;
+    }
+
+    if (xTaskCreate(display_compositor_task, "display_fb", 3072, NULL, 4, NULL) != pdPASS) {
+        heap_caps_free(fb_list);
+        heap_caps_free(fb_band);
+        fb_list = NULL;
+        fb_band = NULL;
+        ESP_LOGW(TAG, "Compositor task create failed");
+        return;
+    }
+
+    fb_list_size = list_bytes;
+    fb_op_t* black = (fb_op_t*)fb_list;
+    memset(black, 0, sizeof(*black));
+    black->kind = FB_OP_FILL;
+    black->size = sizeof(*black);
+    black->x1 = DISPLAY_WIDTH;
+    black->y1 = DISPLAY_HEIGHT;
+    fb_list_used = black->size;
+
+    uint32_t crc = fb_tile_checksum(0);
+    for (int ty = 0; ty < FB_TILES_Y; ty++) {
+        fb_known[ty] = fb_sent[ty] = fb_span_mask(0, FB_TILES_X - 1);
+        for (int tx = 0; tx < FB_TILES_X; tx++) {
+            fb_tile_crc[ty][tx] = crc;
+        }
+    }
+
+    fb_active = true;
+    ESP_LOGI(TAG, "Compositor active: %u byte list in %s, %u byte band",
+             (unsigned)list_bytes, in_psram ? "PSRAM" : "internal RAM",
+             (unsigned)band_bytes);
 }
 
 void display_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
@@ -223,35 +755,16 @@ void display_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colo
     if (y + h > DISPLAY_HEIGHT) h = DISPLAY_HEIGHT - y;
     if (w <= 0 || h <= 0) return;
 
-    set_addr_window(x, y, w, h);
-    
-    uint16_t color_be = (color >> 8) | (color << 8);
-    uint32_t pixels = w * h;
-    
-    gpio_set_level(LCD_DC_PIN, 1);
-    
-    if (pixels <= 64) {
-        for (uint32_t i = 0; i < pixels; i++) {
-            spi_transaction_t t = {
-                .length = 16,
-                .tx_buffer = &color_be,
-            };
-            spi_device_polling_transmit(spi_device, &t);
-        }
-    } else {
-        static uint16_t line_buffer[240];
-        for (int i = 0; i < (w > 240 ? 240 : w); i++) {
-            line_buffer[i] = color_be;
-        }
-        
-        for (int row = 0; row < h; row++) {
-            spi_transaction_t t = {
-                .length = w * 16,
-                .tx_buffer = line_buffer,
-            };
-            spi_device_polling_transmit(spi_device, &t);
-        }
-    }
+    fb_op_t op = {
+        .kind = FB_OP_FILL,
+        .size = sizeof(fb_op_t),
+        .x0 = x, .y0 = y, .x1 = x + w, .y1 = y + h,
+        .fg = (color >> 8) | (color << 8)
+    };
+
+    if (!lcd_lock()) return;
+    fb_draw(&op);
+    lcd_unlock();
 }
 
 void display_draw_pixel(int16_t x, int16_t y, uint16_t color) {
@@ -266,6 +779,120 @@ void display_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colo
     display_fill_rect(x + w - 1, y, 1, h, color);
 }
 
+// Bitmaps are not kept in the list; they go straight to the panel
+void display_draw_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) {
+    if (pixels == NULL || w <= 0 || h <= 0) return;
+
+    // Clip to the screen, remembering the source offset
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + w > DISPLAY_WIDTH ? DISPLAY_WIDTH : x + w;
+    int y1 = y + h > DISPLAY_HEIGHT ? DISPLAY_HEIGHT : y + h;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    int vis_w = x1 - x0;
+    int band_rows = LCD_BUF_PIXELS / vis_w;
+
+    if (!lcd_lock()) return;
+    fb_draw_seq++;
+    if (fb_active) fb_forget(x0, y0, x1, y1);
+    lcd_window(x0, y0, vis_w, y1 - y0);
+
+    for (int band_y = y0; band_y < y1; band_y += band_rows) {
+        int rows = (y1 - band_y < band_rows) ? y1 - band_y : band_rows;
+        int idx = lcd_acquire_buffer();
+        uint16_t* dst = lcd_bufs[idx];
+
+        for (int r = 0; r < rows; r++) {
+            const uint16_t* src = pixels + (band_y + r - y) * w + (x0 - x);
+            for (int i = 0; i < vis_w; i++) {
+                *dst++ = (src[i] >> 8) | (src[i] << 8);
+            }
+        }
+        lcd_queue_pixels(idx, lcd_bufs[idx], rows * vis_w);
+    }
+    lcd_unlock();
+}
+
+// Hardware vertical scrolling. The panel shows the scroll region starting
+// from a movable line of frame memory (VSCRSADD), so scrolling by N rows is
+// one register write and only the N rows uncovered need drawing. Drawing
+// calls address frame memory, so callers draw new rows at the y returned
+// here rather than at fixed screen positions. The compositor mirrors frame
+// memory, so it stays valid while scrolled. Every scroll moves by the step
+// fixed at define time and the height is a whole number of steps, so the
+// offset stays step-aligned and the uncovered rows never wrap past the end
+// of the region.
+static int16_t scroll_top = 0;
+static int16_t scroll_height = DISPLAY_HEIGHT;
+static int16_t scroll_step = 1;
+static int16_t scroll_offset = 0;
+
+static void lcd_scroll_start(void) {
+    uint16_t vsp = scroll_top + scroll_offset;
+    uint8_t arg[2] = { vsp >> 8, vsp & 0xFF };
+    lcd_queue_cmd(ILI9341_VSCRSADD, arg, sizeof(arg));
+}
+
+esp_err_t display_scroll_define(int16_t top, int16_t height, int16_t step) {
+    if (top < 0 || height <= 0 || top + height > DISPLAY_HEIGHT) return ESP_ERR_INVALID_ARG;
+    if (step <= 0 || height % step != 0) {
+        ESP_LOGE(TAG, "Scroll height %d is not a multiple of step %d", height, step);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (spi_device == NULL || !lcd_lock()) return ESP_ERR_INVALID_STATE;
+
+    // Anything pending in the shadow belongs to the unscrolled layout
+    if (fb_active) fb_flush_locked();
+
+    int16_t bottom = DISPLAY_HEIGHT - top - height;
+    uint8_t arg[6] = { top >> 8, top & 0xFF, height >> 8, height & 0xFF, bottom >> 8, bottom & 0xFF };
+    lcd_queue_cmd(ILI9341_VSCRDEF, arg, sizeof(arg));
+
+    scroll_top = top;
+    scroll_height = height;
+    scroll_step = step;
+    scroll_offset = 0;
+    lcd_scroll_start();
+
+    lcd_unlock();
+    return ESP_OK;
+}
+
+static int16_t display_scroll_by(bool down) {
+    int16_t rows = scroll_step;
+    if (spi_device == NULL || !lcd_lock()) return -1;
+
+    if (fb_active) fb_flush_locked();
+
+    int16_t line;
+    if (down) {
+        // Rows scrolled off the bottom reappear at the top of the region
+        scroll_offset = (scroll_offset - rows + scroll_height) % scroll_height;
+        line = scroll_top + scroll_offset;
+    } else {
+        // Rows scrolled off the top reappear at the bottom of the region
+        line = scroll_top + scroll_offset;
+        scroll_offset = (scroll_offset + rows) % scroll_height;
+    }
+    lcd_scroll_start();
+
+    lcd_unlock();
+    return line;
+}
+
+int16_t display_scroll_down(void) {
+    return display_scroll_by(true);
+}
+
+int16_t display_scroll_up(void) {
+    return display_scroll_by(false);
+}
+
+void display_scroll_reset(void) {
+    display_scroll_define(0, DISPLAY_HEIGHT, 1);
+}
+
 // Complete font system
 static const uint8_t font_5x7_letters[][5] = {
     {0x7C, 0x12, 0x11, 0x12, 0x7C}, // A
@@ -330,90 +957,158 @@ static const uint8_t font_5x7_symbols[][5] = {
     {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
 };
 
-void display_draw_text(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color) {
-    if (text == NULL) return;
-    
-    int len = strlen(text);
-    if (len == 0) return;
-    
-    if (x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT || x < -30 || y < -7) return;
-    
-    for (int i = 0; i < len; i++) {
-        char c = text[i];
-        const uint8_t* bitmap = NULL;
-        
-        if (c >= 'A' && c <= 'Z') {
-            bitmap = font_5x7_letters[c - 'A'];
-        } else if (c >= 'a' && c <= 'z') {
-            bitmap = font_5x7_letters[c - 'a'];
-        } else if (c >= '0' && c <= '9') {
-            bitmap = font_5x7_numbers[c - '0'];
-        } else {
-            switch (c) {
-                case ' ': bitmap = font_5x7_symbols[0]; break;
-                case '!': bitmap = font_5x7_symbols[1]; break;
-                case '"': bitmap = font_5x7_symbols[2]; break;
-                case '#': bitmap = font_5x7_symbols[3]; break;
-                case '$': bitmap = font_5x7_symbols[4]; break;
-                case '%': bitmap = font_5x7_symbols[5]; break;
-                case '&': bitmap = font_5x7_symbols[6]; break;
-                case '\'': bitmap = font_5x7_symbols[7]; break;
-                case '(': bitmap = font_5x7_symbols[8]; break;
-                case ')': bitmap = font_5x7_symbols[9]; break;
-                case '*': bitmap = font_5x7_symbols[10]; break;
-                case '+': bitmap = font_5x7_symbols[11]; break;
-                case ',': bitmap = font_5x7_symbols[12]; break;
-                case '-': bitmap = font_5x7_symbols[13]; break;
-                case '.': bitmap = font_5x7_symbols[14]; break;
-                case '/': bitmap = font_5x7_symbols[15]; break;
-                case ':': bitmap = font_5x7_symbols[16]; break;
-                case ';': bitmap = font_5x7_symbols[17]; break;
-                default: bitmap = font_5x7_symbols[0]; break;
-            }
-        }
-        
-        if (bitmap) {
-            for (int col = 0; col < 5; col++) {
-                for (int row = 0; row < 7; row++) {
-                    if (bitmap[col] & (1 << row)) {
-                        display_draw_pixel(x + i * 6 + col, y + row, color);
-                    } else {
-                        display_draw_pixel(x + i * 6 + col, y + row, bg_color);
-                    }
-                }
+static const uint8_t* font_5x7_glyph(char c) {
+    if (c >= 'A' && c <= 'Z') return font_5x7_letters[c - 'A'];
+    if (c >= 'a' && c <= 'z') return font_5x7_letters[c - 'a'];
+    if (c >= '0' && c <= '9') return font_5x7_numbers[c - '0'];
+
+    switch (c) {
+        case '!': return font_5x7_symbols[1];
+        case '"': return font_5x7_symbols[2];
+        case '#': return font_5x7_symbols[3];
+        case '$': return font_5x7_symbols[4];
+        case '%': return font_5x7_symbols[5];
+        case '&': return font_5x7_symbols[6];
+        case '\'': return font_5x7_symbols[7];
+        case '(': return font_5x7_symbols[8];
+        case ')': return font_5x7_symbols[9];
+        case '*': return font_5x7_symbols[10];
+        case '+': return font_5x7_symbols[11];
+        case ',': return font_5x7_symbols[12];
+        case '-': return font_5x7_symbols[13];
+        case '.': return font_5x7_symbols[14];
+        case '/': return font_5x7_symbols[15];
+        case ':': return font_5x7_symbols[16];
+        case ';': return font_5x7_symbols[17];
+        default: return font_5x7_symbols[0];
+    }
+}
+
+// 5x7 glyphs are column-major (bit n = row n), returned as a row mask
+// with bit n = column n.
+static uint8_t font_5x7_row(const uint8_t* glyph, int row) {
+    uint8_t bits = 0;
+    for (int col = 0; col < 5; col++) {
+        if (glyph[col] & (1 << row)) bits |= 1 << col;
+    }
+    return bits;
+}
+
+static const uint8_t* font_8x16_glyph(char c) {
+    return font_large_8x16[(uint8_t)c];
+}
+
+// 8x16 glyphs are row-major with the MSB as the leftmost pixel
+static uint8_t font_8x16_row(const uint8_t* glyph, int row) {
+    uint8_t b = glyph[row];
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+typedef struct {
+    uint8_t advance;    // cell width in font pixels, including spacing
+    uint8_t height;
+    uint8_t trailing;   // spacing columns left unpainted after the last glyph
+    const uint8_t* (*glyph)(char c);
+    uint8_t (*row_bits)(const uint8_t* glyph, int row);
+} text_font_t;
+
+static const text_font_t font_5x7 = { 6, 7, 1, font_5x7_glyph, font_5x7_row };
+static const text_font_t font_8x16 = { 8, 16, 0, font_8x16_glyph, font_8x16_row };
+
+enum { TEXT_FONT_5X7, TEXT_FONT_8X16 };
+static const text_font_t* const text_fonts[] = { &font_5x7, &font_8x16 };
+
+// Text is expanded into RGB565 rows a band at a time, by the compositor or
+// into the DMA line buffers, so a string costs one window setup plus one
+// burst per band instead of one window per pixel
+#define TEXT_MAX_GLYPHS     (DISPLAY_WIDTH / 6 + 2)
+
+static void fb_render_text(const fb_op_t* op, int x0, int y0, int x1, int y1,
+                           uint16_t* dst, int stride) {
+    const text_font_t* font = text_fonts[op->font];
+    int scale = op->scale;
+    int cell_w = font->advance * scale;
+
+    for (int y = y0; y < y1; y++, dst += stride) {
+        int font_row = (y - op->ty) / scale;
+        int off = x0 - op->tx;
+        int ci = off / cell_w;
+        int sub = off % cell_w;
+        uint8_t bits = font->row_bits(font->glyph(op->text[ci]), font_row);
+        uint16_t* d = dst;
+
+        for (int px = x0; px < x1; px++) {
+            *d++ = (bits >> (sub / scale)) & 1 ? op->fg : op->bg;
+            if (++sub == cell_w && px + 1 < x1) {
+                sub = 0;
+                ci++;
+                bits = font->row_bits(font->glyph(op->text[ci]), font_row);
             }
         }
     }
 }
 
-
-void display_draw_text_2x(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color) {
+static void display_draw_glyph_run(uint8_t font_id, int x, int y, const char* text,
+                                   int scale, uint16_t color, uint16_t bg_color) {
     if (text == NULL) return;
-    
+
     int len = strlen(text);
     if (len == 0) return;
-    
-    for (int i = 0; i < len; i++) {
-        char c = text[i];
-        const uint8_t* bitmap = NULL;
-        
-        if (c >= 'A' && c <= 'Z') {
-            bitmap = font_5x7_letters[c - 'A'];
-        } else if (c >= 'a' && c <= 'z') {
-            bitmap = font_5x7_letters[c - 'a'];
-        } else if (c >= '0' && c <= '9') {
-            bitmap = font_5x7_numbers[c - '0'];
-        } else if (c == ' ') {
-            bitmap = font_5x7_symbols[0];
-        }
-        
-        if (bitmap) {
-            for (int col = 0; col < 5; col++) {
-                for (int row = 0; row < 7; row++) {
-                    uint16_t pixel_color = (bitmap[col] & (1 << row)) ? color : bg_color;
-                    display_fill_rect(x + i * 12 + col * 2, y + row * 2, 2, 2, pixel_color);
-                }
-            }
-        }
-    }
+
+    const text_font_t* font = text_fonts[font_id];
+    int cell_w = font->advance * scale;
+    int run_w = len * cell_w - font->trailing * scale;
+    int run_h = font->height * scale;
+
+    // Clip the run to the screen
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + run_w > DISPLAY_WIDTH ? DISPLAY_WIDTH : x + run_w;
+    int y1 = y + run_h > DISPLAY_HEIGHT ? DISPLAY_HEIGHT : y + run_h;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // Only the characters on screen are kept
+    int first = (x0 - x) / cell_w;
+    int last = (x1 - 1 - x) / cell_w;
+    union {
+        fb_op_t op;
+        uint8_t bytes[sizeof(fb_op_t) + TEXT_MAX_GLYPHS + 1];
+    } rec;
+    fb_op_t* op = &rec.op;
+    *op = (fb_op_t){
+        .kind = FB_OP_TEXT,
+        .font = font_id,
+        .scale = scale,
+        .len = last - first + 1,
+        .size = (sizeof(fb_op_t) + last - first + 2) & ~1,
+        .x0 = x0, .y0 = y0, .x1 = x1, .y1 = y1,
+        .tx = x + first * cell_w, .ty = y,
+        .fg = (color >> 8) | (color << 8),
+        .bg = (bg_color >> 8) | (bg_color << 8)
+    };
+    memcpy(op->text, text + first, op->len);
+
+    if (!lcd_lock()) return;
+    fb_draw(op);
+    lcd_unlock();
+}
+
+void display_draw_text(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color) {
+    display_draw_glyph_run(TEXT_FONT_5X7, x, y, text, 1, color, bg_color);
+}
+
+void display_draw_text_2x(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color) {
+    display_draw_glyph_run(TEXT_FONT_5X7, x, y, text, 2, color, bg_color);
+}
+
+void display_draw_text_large(int x, int y, const char* text, uint16_t color, uint16_t bg_color) {
+    display_draw_glyph_run(TEXT_FONT_8X16, x, y, text, 1, color, bg_color);
+}
+
+void display_draw_char_large(int x, int y, char c, uint16_t color, uint16_t bg_color) {
+    char text[2] = { c, '\0' };
+    display_draw_glyph_run(TEXT_FONT_8X16, x, y, text, 1, color, bg_color);
 }
@@ -19,6 +19,15 @@
 #define COLOR_DARKBLUE  0x3166
 #define COLOR_PURPLE    0x780F
 
+// Bus cost counters, accumulated since the last display_reset_stats()
+typedef struct {
+    uint32_t transactions;      // SPI transactions queued
+    uint32_t bytes;             // bytes on the bus
+    uint32_t windows;           // address window setups
+    uint32_t ranges_skipped;    // CASET/PASET elided by the window cache
+    uint32_t flush_rects;       // compositor rectangles flushed
+} display_stats_t;
+
 // Display functions
 esp_err_t display_init(void);
 void display_fill_screen(uint16_t color);
@@ -29,8 +38,26 @@ void display_draw_line(int x0, int y0, int x1, int y1, uint16_t color);
 void display_draw_circle(int cx, int cy, int radius, uint16_t color);
 void display_draw_text(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color);
 void display_draw_text_2x(int16_t x, int16_t y, const char* text, uint16_t color, uint16_t bg_color);
+void display_draw_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels);
 void display_set_rotation(uint8_t rotation);
 void set_addr_window(int16_t x, int16_t y, int16_t w, int16_t h);
+void display_wait_idle(void);
+void display_get_stats(display_stats_t* stats);
+void display_reset_stats(void);
+
+// Banded compositor: changed tiles are sent once drawing pauses,
+// display_flush() sends them immediately
+void display_flush(void);
+bool display_compositor_active(void);
+
+// Hardware vertical scrolling of rows [top, top + height), step rows at a
+// time; height must be a multiple of step so new rows never wrap. Scrolling
+// returns the frame-memory y of the step rows that were uncovered, or -1;
+// draw the new content there.
+esp_err_t display_scroll_define(int16_t top, int16_t height, int16_t step);
+int16_t display_scroll_down(void);
+int16_t display_scroll_up(void);
+void display_scroll_reset(void);
 
 // LCD low-level functions
 esp_err_t lcd_cmd(uint8_t cmd);
@@ -0,0 +1,123 @@
+#include "display_bench.h"
+#include "display.h"
+#include "menu.h"
+#include "utils.h"
+#include "signal_visualizer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* TAG = "DISPLAY_BENCH";
+
+#define BENCH_AP_COUNT  20
+
+typedef struct {
+    const char* name;
+    void (*draw)(void);
+} bench_scene_t;
+
+typedef struct {
+    display_stats_t stats;
+    uint32_t time_us;
+} bench_result_t;
+
+static wifi_ap_record_t bench_aps[BENCH_AP_COUNT];
+static int8_t bench_rssi[8];
+
+static void scene_menu(void) {
+    menu_draw();
+}
+
+static void scene_status_bar(void) {
+    draw_status_bar(read_battery_voltage());
+}
+
+static void scene_wifi_heatmap(void) {
+    display_fill_screen(COLOR_BLACK);
+    draw_wifi_heatmap(bench_aps, BENCH_AP_COUNT);
+}
+
+static void scene_ble_bars(void) {
+    display_fill_screen(COLOR_BLACK);
+    draw_ble_rssi_bars(bench_rssi, 8, 40);
+}
+
+static const bench_scene_t scenes[] = {
+    {"menu_draw", scene_menu},
+    {"status_bar", scene_status_bar},
+    {"wifi_heatmap", scene_wifi_heatmap},
+    {"ble_rssi_bars", scene_ble_bars},
+};
+
+#define SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+// Measures one frame, including the compositor flush and the time for the
+// queued bursts to leave the bus
+static void bench_frame(const bench_scene_t* scene, bench_result_t* result) {
+    display_wait_idle();
+    display_reset_stats();
+    int64_t start = esp_timer_get_time();
+    
+    scene->draw();
+    display_flush();
+    display_wait_idle();
+    
+    result->time_us = esp_timer_get_time() - start;
+    display_get_stats(&result->stats);
+}
+
+void display_bench_run(void) {
+    // Deterministic fake scan so runs are comparable
+    for (int i = 0; i < BENCH_AP_COUNT; i++) {
+        memset(&bench_aps[i], 0, sizeof(bench_aps[i]));
+        snprintf((char*)bench_aps[i].ssid, sizeof(bench_aps[i].ssid), "BENCH_AP_%02d", i);
+        bench_aps[i].primary = 1 + (i * 5) % 13;
+        bench_aps[i].rssi = -35 - (i * 3);
+    }
+    for (int i = 0; i < 8; i++) {
+        bench_rssi[i] = -40 - i * 7;
+    }
+    
+    // Each scene is drawn twice: the repeat shows the cost of redrawing
+    // unchanged content, which is what most UI loops do
+    bench_result_t first[SCENE_COUNT];
+    bench_result_t repeat[SCENE_COUNT];
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        display_fill_screen(COLOR_BLACK);
+        bench_frame(&scenes[i], &first[i]);
+        bench_frame(&scenes[i], &repeat[i]);
+        
+        ESP_LOGI(TAG, "%-14s first: %lu tx %lu B %lu win %lu us | repeat: %lu tx %lu B %lu win %lu us",
+                 scenes[i].name,
+                 (unsigned long)first[i].stats.transactions, (unsigned long)first[i].stats.bytes,
+                 (unsigned long)first[i].stats.windows, (unsigned long)first[i].time_us,
+                 (unsigned long)repeat[i].stats.transactions, (unsigned long)repeat[i].stats.bytes,
+                 (unsigned long)repeat[i].stats.windows, (unsigned long)repeat[i].time_us);
+    }
+    
+    display_fill_screen(COLOR_BLACK);
+    display_draw_text(10, 10, "DISPLAY BENCH", COLOR_WHITE, COLOR_BLACK);
+    display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_ORANGE);
+    display_draw_text(10, 35, "Compositor:", COLOR_GRAY, COLOR_BLACK);
+    display_draw_text(90, 35, display_compositor_active() ? "ON" : "OFF",
+                      display_compositor_active() ? COLOR_GREEN : COLOR_ORANGE, COLOR_BLACK);
+    
+    int y = 55;
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        char line[48];
+        display_draw_text(10, y, scenes[i].name, COLOR_BLUE, COLOR_BLACK);
+        snprintf(line, sizeof(line), "1st %lu tx %luKB %lums",
+                 (unsigned long)first[i].stats.transactions, (unsigned long)first[i].stats.bytes / 1024,
+                 (unsigned long)first[i].time_us / 1000);
+        display_draw_text(20, y + 12, line, COLOR_WHITE, COLOR_BLACK);
+        snprintf(line, sizeof(line), "rpt %lu tx %luKB %lums",
+                 (unsigned long)repeat[i].stats.transactions, (unsigned long)repeat[i].stats.bytes / 1024,
+                 (unsigned long)repeat[i].time_us / 1000);
+        display_draw_text(20, y + 24, line, COLOR_WHITE, COLOR_BLACK);
+        y += 42;
+    }
+    
+    display_draw_text(10, 280, "Touch to return", COLOR_GRAY, COLOR_BLACK);
+    wait_for_touch_with_timeout(30);
+}
@@ -0,0 +1,8 @@
+#ifndef DISPLAY_BENCH_H
+#define DISPLAY_BENCH_H
+
+// Replays real screens and reports SPI cost per frame (transactions, bytes,
+// window setups, time) on screen and in the log
+void display_bench_run(void);
+
+#endif // DISPLAY_BENCH_H
@@ -0,0 +1,205 @@
+#include "eapol_tracker.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+// The index is a power of two at least twice the pool, keeping probes short
+#define INDEX_SLOTS     512
+#define INDEX_MASK      (INDEX_SLOTS - 1)
+#define NONE            0xFFFF
+
+// EAPOL-Key key-info bits
+#define KEY_INFO_PAIRWISE   0x0008
+#define KEY_INFO_ACK        0x0080
+#define KEY_INFO_MIC        0x0100
+#define KEY_INFO_SECURE     0x0200
+
+// Offsets after the LLC/SNAP header: 802.1X header, then the key descriptor
+#define EAPOL_TYPE_OFF      1
+#define KEY_INFO_OFF        5
+#define KEY_REPLAY_OFF      9
+#define KEY_DATA_LEN_OFF    97
+#define EAPOL_KEY_MIN_LEN   99
+
+static eapol_pair_t pairs[EAPOL_TRACKER_MAX_PAIRS];
+static uint16_t index_table[INDEX_SLOTS];
+
+// Doubly linked LRU over pool slots; oldest at lru_head
+static uint16_t lru_prev[EAPOL_TRACKER_MAX_PAIRS];
+static uint16_t lru_next[EAPOL_TRACKER_MAX_PAIRS];
+static uint16_t lru_head = NONE;
+static uint16_t lru_tail = NONE;
+static uint16_t pool_used;
+
+static eapol_tracker_stats_t stats;
+static portMUX_TYPE tracker_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t pair_hash(const uint8_t* bssid, const uint8_t* station) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ bssid[i]) * 16777619u;
+    for (int i = 0; i < 6; i++) h = (h ^ station[i]) * 16777619u;
+    return h & INDEX_MASK;
+}
+
+static void lru_unlink(uint16_t e) {
+    if (lru_prev[e] != NONE) lru_next[lru_prev[e]] = lru_next[e];
+    else lru_head = lru_next[e];
+    if (lru_next[e] != NONE) lru_prev[lru_next[e]] = lru_prev[e];
+    else lru_tail = lru_prev[e];
+}
+
+static void lru_push(uint16_t e) {
+    lru_prev[e] = lru_tail;
+    lru_next[e] = NONE;
+    if (lru_tail != NONE) lru_next[lru_tail] = e;
+    else lru_head = e;
+    lru_tail = e;
+}
+
+// Linear-probing delete with backward shift, so lookups never need tombstones
+static void index_remove(uint16_t e) {
+    uint32_t i = pair_hash(pairs[e].bssid, pairs[e].station);
+    while (index_table[i] != e) i = (i + 1) & INDEX_MASK;
+
+    index_table[i] = NONE;
+    for (uint32_t j = (i + 1) & INDEX_MASK; index_table[j] != NONE; j = (j + 1) & INDEX_MASK) {
+        const eapol_pair_t* p = &pairs[index_table[j]];
+        uint32_t home = pair_hash(p->bssid, p->station);
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        bool stays = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            index_table[i] = index_table[j];
+            index_table[j] = NONE;
+            i = j;
+        }
+    }
+}
+
+static eapol_pair_t* pair_lookup(const uint8_t* bssid, const uint8_t* station) {
+    uint32_t i = pair_hash(bssid, station);
+
+    for (; index_table[i] != NONE; i = (i + 1) & INDEX_MASK) {
+        eapol_pair_t* p = &pairs[index_table[i]];
+        if (memcmp(p->bssid, bssid, 6) == 0 && memcmp(p->station, station, 6) == 0) {
+            lru_unlink(index_table[i]);
+            lru_push(index_table[i]);
+            return p;
+        }
+    }
+
+    // New pair: take a free slot or recycle the least recently active one
+    uint16_t e;
+    if (pool_used < EAPOL_TRACKER_MAX_PAIRS) {
+        e = pool_used++;
+    } else {
+        e = lru_head;
+        lru_unlink(e);
+        index_remove(e);
+        stats.evictions++;
+        // The hole may have moved our probe chain; find the insert slot again
+        for (i = pair_hash(bssid, station); index_table[i] != NONE; i = (i + 1) & INDEX_MASK) {}
+    }
+
+    eapol_pair_t* p = &pairs[e];
+    memset(p, 0, sizeof(*p));
+    memcpy(p->bssid, bssid, 6);
+    memcpy(p->station, station, 6);
+    index_table[i] = e;
+    lru_push(e);
+    return p;
+}
+
+static uint64_t read_be(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+void eapol_tracker_reset(void) {
+    portENTER_CRITICAL(&tracker_lock);
+    memset(index_table, 0xFF, sizeof(index_table));
+    lru_head = lru_tail = NONE;
+    pool_used = 0;
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&tracker_lock);
+}
+
+bool eapol_tracker_feed(const wifi_frame_t* frame, uint32_t now_ms) {
+    if (!wifi_frame_is_eapol(frame)) {
+        return false;
+    }
+
+    const uint8_t* eapol = frame->body + 8;
+    if (frame->body_len - 8 < EAPOL_KEY_MIN_LEN || eapol[EAPOL_TYPE_OFF] != 3) {
+        return false;
+    }
+
+    uint16_t info = read_be(eapol + KEY_INFO_OFF, 2);
+    uint64_t replay = read_be(eapol + KEY_REPLAY_OFF, 8);
+    uint16_t data_len = read_be(eapol + KEY_DATA_LEN_OFF, 2);
+
+    // Group key updates are not part of the 4-way handshake
+    const uint8_t* bssid = wifi_frame_bssid(frame);
+    if (!(info & KEY_INFO_PAIRWISE) || bssid == NULL) {
+        return true;
+    }
+    const uint8_t* station = bssid == frame->addr1 ? frame->addr2 : frame->addr1;
+
+    uint8_t msg;
+    if (info & KEY_INFO_ACK) {
+        msg = (info & KEY_INFO_MIC) ? EAPOL_MSG_M3 : EAPOL_MSG_M1;
+    } else if (info & KEY_INFO_MIC) {
+        // M4 is secure (WPA2) or carries no key data (WPA)
+        msg = (info & KEY_INFO_SECURE) || data_len == 0 ? EAPOL_MSG_M4 : EAPOL_MSG_M2;
+    } else {
+        return true;
+    }
+
+    portENTER_CRITICAL(&tracker_lock);
+    stats.frames++;
+    eapol_pair_t* p = pair_lookup(bssid, station);
+    p->last_seen_ms = now_ms;
+
+    // M1/M2 share a replay counter r; M3/M4 use r + 1
+    uint64_t base = (msg == EAPOL_MSG_M3 || msg == EAPOL_MSG_M4) ? replay - 1 : replay;
+    if (p->msgs == 0 || base != p->replay || (msg == EAPOL_MSG_M1 && (p->msgs & ~EAPOL_MSG_M1))) {
+        // A new exchange; keep the flags earned by earlier ones
+        p->msgs = 0;
+        p->replay = base;
+    }
+    p->msgs |= msg;
+
+    if (!p->crackable && ((p->msgs & (EAPOL_MSG_M1 | EAPOL_MSG_M2)) == (EAPOL_MSG_M1 | EAPOL_MSG_M2) ||
+                          (p->msgs & (EAPOL_MSG_M2 | EAPOL_MSG_M3)) == (EAPOL_MSG_M2 | EAPOL_MSG_M3))) {
+        p->crackable = true;
+        stats.crackable++;
+    }
+    if (!p->complete && p->msgs == (EAPOL_MSG_M1 | EAPOL_MSG_M2 | EAPOL_MSG_M3 | EAPOL_MSG_M4)) {
+        p->complete = true;
+        stats.complete++;
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+    return true;
+}
+
+void eapol_tracker_get_stats(eapol_tracker_stats_t* out) {
+    portENTER_CRITICAL(&tracker_lock);
+    *out = stats;
+    out->pairs = pool_used;
+    portEXIT_CRITICAL(&tracker_lock);
+}
+
+void eapol_tracker_foreach(eapol_pair_cb_t cb, void* ctx) {
+    // Copy out under the lock so callbacks can take their time
+    for (uint16_t e = lru_head, n = 0; n < EAPOL_TRACKER_MAX_PAIRS; n++) {
+        eapol_pair_t copy;
+        portENTER_CRITICAL(&tracker_lock);
+        if (e == NONE) {
+            portEXIT_CRITICAL(&tracker_lock);
+            break;
+        }
+        copy = pairs[e];
+        e = lru_next[e];
+        portEXIT_CRITICAL(&tracker_lock);
+        cb(&copy, ctx);
+    }
+}
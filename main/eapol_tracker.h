@@ -0,0 +1,50 @@
+#ifndef EAPOL_TRACKER_H
+#define EAPOL_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "wifi_frame.h"
+
+// Passive WPA 4-way handshake tracker. EAPOL-Key frames are classified as
+// M1..M4 from their key-info bits and matched by replay counter per
+// (BSSID, station) pair. Pairs live in a fixed pool indexed by an
+// open-addressing hash, so each frame costs O(1); when the pool is full the
+// least recently active pair is evicted.
+#define EAPOL_TRACKER_MAX_PAIRS     256
+
+#define EAPOL_MSG_M1    0x01
+#define EAPOL_MSG_M2    0x02
+#define EAPOL_MSG_M3    0x04
+#define EAPOL_MSG_M4    0x08
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t station[6];
+    uint8_t msgs;           // EAPOL_MSG_* seen in the current exchange
+    bool crackable;         // M1/M2 (or M2/M3) with matching replay counters
+    bool complete;          // M1..M4 with consistent replay counters
+    uint64_t replay;        // replay counter of the current exchange's M1
+    uint32_t last_seen_ms;
+} eapol_pair_t;
+
+typedef struct {
+    uint32_t frames;        // EAPOL-Key frames seen
+    uint32_t pairs;         // pairs currently tracked
+    uint32_t crackable;
+    uint32_t complete;
+    uint32_t evictions;
+} eapol_tracker_stats_t;
+
+// Clears all state; call once before the first feed
+void eapol_tracker_reset(void);
+
+// Feed any parsed frame; returns true if it was an EAPOL-Key message
+bool eapol_tracker_feed(const wifi_frame_t* frame, uint32_t now_ms);
+
+void eapol_tracker_get_stats(eapol_tracker_stats_t* stats);
+
+// Visits every tracked pair, oldest activity first
+typedef void (*eapol_pair_cb_t)(const eapol_pair_t* pair, void* ctx);
+void eapol_tracker_foreach(eapol_pair_cb_t cb, void* ctx);
+
+#endif // EAPOL_TRACKER_H
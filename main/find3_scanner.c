@@ -1,4 +1,7 @@
 #include "find3_scanner.h"
+#include "wifi_scanner.h"
+#include "device_table.h"
+#include "board_config.h"
 #include "esp_wifi.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
@@ -35,59 +38,70 @@ static esp_err_t http_post_data(const char *url, const char *json_data) {
     return err;
 }
 
-static void scan_task(void *pvParameters) {
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = true,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-    };
+// Median of the AP's recent sweeps: a single faded or reflected reading
+// does not move the fingerprint the way it moves rssi_last
+static int8_t report_rssi(uint16_t id, const device_info_t *ap) {
+    int8_t samples[FIND3_RSSI_SAMPLES];
+    size_t n = device_table_rssi_history(id, samples, FIND3_RSSI_SAMPLES);
+    if (n == 0) return ap->rssi_last;
     
+    for (size_t i = 1; i < n; i++) {
+        int8_t v = samples[i];
+        size_t j = i;
+        for (; j > 0 && samples[j - 1] > v; j--) samples[j] = samples[j - 1];
+        samples[j] = v;
+    }
+    return samples[n / 2];
+}
+
+static void scan_task(void *pvParameters) {
     while (is_scanning) {
-        esp_wifi_scan_start(&scan_config, true);
+        // A sweep another feature ran within the interval is as good as ours
+        uint32_t max_age_ms = g_config.scan_interval_ms;
+        esp_err_t ret = wifi_scanner_refresh(max_age_ms, WIFI_SCAN_WAIT_MS);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Scan failed: %s", esp_err_to_name(ret));
+        }
         
-        uint16_t ap_count = 0;
-        esp_wifi_scan_get_ap_num(&ap_count);
+        uint16_t capacity = device_table_capacity();
+        uint16_t *ap_ids = capacity ? malloc(capacity * sizeof(uint16_t)) : NULL;
+        size_t ap_count = ap_ids ? device_table_query(DEVICE_KIND_WIFI_AP, 0, device_table_now_ms() - max_age_ms,
+                                                      DEVICE_ORDER_RSSI, ap_ids, capacity) : 0;
         
         if (ap_count > 0) {
-            wifi_ap_record_t *ap_list = malloc(sizeof(wifi_ap_record_t) * ap_count);
-            if (ap_list) {
-                esp_wifi_scan_get_ap_records(&ap_count, ap_list);
-                
-                cJSON *root = cJSON_CreateObject();
-                cJSON_AddStringToObject(root, "d", g_config.device_name);
-                cJSON_AddStringToObject(root, "f", g_config.family_name);
-                cJSON_AddNumberToObject(root, "t", esp_timer_get_time() / 1000);
-                
-                if (g_config.learning_mode) {
-                    cJSON_AddStringToObject(root, "l", g_config.location);
-                }
-                
-                cJSON *wifi_obj = cJSON_CreateObject();
-                for (int i = 0; i < ap_count; i++) {
-                    char mac_str[18];
-                    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-                             ap_list[i].bssid[0], ap_list[i].bssid[1], ap_list[i].bssid[2],
-                             ap_list[i].bssid[3], ap_list[i].bssid[4], ap_list[i].bssid[5]);
-                    cJSON_AddNumberToObject(wifi_obj, mac_str, ap_list[i].rssi);
-                }
-                cJSON_AddItemToObject(root, "s", cJSON_CreateObject());
-                cJSON_AddItemToObject(cJSON_GetObjectItem(root, "s"), "wifi", wifi_obj);
-                
-                char *json_str = cJSON_PrintUnformatted(root);
-                if (json_str) {
-                    char url[256];
-                    snprintf(url, sizeof(url), "%s/%s", g_config.server_url, 
-                             g_config.learning_mode ? "learn" : "track");
-                    http_post_data(url, json_str);
-                    free(json_str);
-                }
-                
-                cJSON_Delete(root);
-                free(ap_list);
+            cJSON *root = cJSON_CreateObject();
+            cJSON_AddStringToObject(root, "d", g_config.device_name);
+            cJSON_AddStringToObject(root, "f", g_config.family_name);
+            cJSON_AddNumberToObject(root, "t", esp_timer_get_time() / 1000);
+            
+            if (g_config.learning_mode) {
+                cJSON_AddStringToObject(root, "l", g_config.location);
+            }
+            
+            cJSON *wifi_obj = cJSON_CreateObject();
+            device_info_t ap;
+            for (int i = 0; i < ap_count; i++) {
+                if (!device_table_get(ap_ids[i], &ap)) continue;
+                char mac_str[18];
+                snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                         ap.mac[0], ap.mac[1], ap.mac[2], ap.mac[3], ap.mac[4], ap.mac[5]);
+                cJSON_AddNumberToObject(wifi_obj, mac_str, report_rssi(ap_ids[i], &ap));
+            }
+            cJSON_AddItemToObject(root, "s", cJSON_CreateObject());
+            cJSON_AddItemToObject(cJSON_GetObjectItem(root, "s"), "wifi", wifi_obj);
+            
+            char *json_str = cJSON_PrintUnformatted(root);
+            if (json_str) {
+                char url[256];
+                snprintf(url, sizeof(url), "%s/%s", g_config.server_url, 
+                         g_config.learning_mode ? "learn" : "track");
+                http_post_data(url, json_str);
+                free(json_str);
             }
+            
+            cJSON_Delete(root);
         }
+        free(ap_ids);
         
         vTaskDelay(pdMS_TO_TICKS(g_config.scan_interval_ms));
     }
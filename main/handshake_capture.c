@@ -4,6 +4,12 @@
 #include "display.h"
 #include "touchscreen.h"
 #include "packet_logger.h"
+#include "channel_hopper.h"
+#include "promisc_mux.h"
+#include "wifi_frame.h"
+#include "eapol_tracker.h"
+#include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char* TAG = "HANDSHAKE";
@@ -12,60 +18,56 @@ void handshake_log_info(const char* msg) {
     ESP_LOGI(TAG, "%s", msg);
 }
 
+// Beaconing networks, only used to put names on tracked handshakes
+#define MAX_NETWORKS 32
+
 typedef struct {
     uint8_t bssid[6];
-    uint8_t client[6];
-    char ssid[32];
-    bool has_beacon;
-    bool has_auth;
-    bool has_assoc_req;
-    bool has_assoc_resp;
-    int eapol_count;
-} handshake_info_t;
+    char ssid[33];
+} network_info_t;
 
-static handshake_info_t handshakes[5];
-static int handshake_count = 0;
+static network_info_t networks[MAX_NETWORKS];
+static int network_count = 0;
 
-static void handshake_promiscuous_cb(void* buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT) return;
-    
-    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t*)buf;
-    uint8_t *frame = pkt->payload;
-    
-    // Check frame type
-    uint8_t frame_type = frame[0] & 0xFC;
-    
-    if (frame_type == 0x80) { // Beacon
-        if (handshake_count < 5) {
-            memcpy(handshakes[handshake_count].bssid, &frame[10], 6);
-            
-            // Extract SSID from beacon
-            uint8_t *ssid_ptr = &frame[36]; // Skip fixed parameters
-            if (ssid_ptr[0] == 0x00 && ssid_ptr[1] <= 32) { // SSID element
-                memcpy(handshakes[handshake_count].ssid, &ssid_ptr[2], ssid_ptr[1]);
-                handshakes[handshake_count].ssid[ssid_ptr[1]] = '\0';
-                handshakes[handshake_count].has_beacon = true;
-                handshake_count++;
-            }
-        }
+static void handshake_promiscuous_cb(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    wifi_frame_t frame;
+    if (!wifi_frame_from_pkt(&frame, pkt)) return;
+    
+    if (type == WIFI_PKT_DATA) {
+        eapol_tracker_feed(&frame, esp_timer_get_time() / 1000);
+        return;
     }
-    else if (frame_type == 0xB0) { // Authentication
-        for (int i = 0; i < handshake_count; i++) {
-            if (memcmp(handshakes[i].bssid, &frame[4], 6) == 0) {
-                memcpy(handshakes[i].client, &frame[10], 6);
-                handshakes[i].has_auth = true;
-                break;
-            }
-        }
+    
+    if (type != WIFI_PKT_MGMT || frame.subtype != WIFI_MGMT_BEACON || network_count >= MAX_NETWORKS) return;
+    
+    for (int i = 0; i < network_count; i++) {
+        if (memcmp(networks[i].bssid, frame.addr3, 6) == 0) return;
     }
-    else if (frame_type == 0x00) { // Association Request
-        for (int i = 0; i < handshake_count; i++) {
-            if (memcmp(handshakes[i].bssid, &frame[4], 6) == 0) {
-                handshakes[i].has_assoc_req = true;
-                break;
-            }
+    
+    // SSID element, wherever it sits after the fixed parameters
+    if (wifi_frame_ssid(&frame, networks[network_count].ssid) >= 0) {
+        memcpy(networks[network_count].bssid, frame.addr3, 6);
+        network_count++;
+    }
+}
+
+static const char* network_name(const uint8_t* bssid) {
+    for (int i = 0; i < network_count; i++) {
+        if (memcmp(networks[i].bssid, bssid, 6) == 0) {
+            return networks[i].ssid;
         }
     }
+    return "?";
+}
+
+static void log_complete_pair(const eapol_pair_t* pair, void* ctx) {
+    if (!pair->complete) return;
+    
+    char client[18];
+    snprintf(client, sizeof(client), "%02X:%02X:%02X:%02X:%02X:%02X",
+             pair->station[0], pair->station[1], pair->station[2],
+             pair->station[3], pair->station[4], pair->station[5]);
+    packet_log_handshake_capture(network_name(pair->bssid), client);
 }
 
 void handshake_capture_start(void) {
@@ -75,13 +77,19 @@ void handshake_capture_start(void) {
     display_draw_text(10, 40, "Monitoring for handshakes...", COLOR_BLUE, COLOR_BLACK);
     
     // Reset data
-    memset(handshakes, 0, sizeof(handshakes));
-    handshake_count = 0;
+    memset(networks, 0, sizeof(networks));
+    network_count = 0;
+    eapol_tracker_reset();
     
     // Set promiscuous mode
     esp_wifi_set_mode(WIFI_MODE_NULL);
-    esp_wifi_set_promiscuous_rx_cb(handshake_promiscuous_cb);
-    esp_wifi_set_promiscuous(true);
+    // EAPOL rides in data frames; beacons name the networks
+    promisc_filter_t rx_filter = {
+        .types = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_DATA,
+        .mgmt_subtypes = PROMISC_SUBTYPE(WIFI_MGMT_BEACON)
+    };
+    promisc_subscribe(handshake_promiscuous_cb, &rx_filter, NULL);
+    channel_hopper_start(NULL);
     
     // Cancel button
     display_fill_rect(160, 280, 70, 30, COLOR_RED);
@@ -106,31 +114,26 @@ void handshake_capture_start(void) {
         display_fill_rect(10, 60, 200, 15, COLOR_BLACK);
         display_draw_text(10, 60, time_info, COLOR_BLUE, COLOR_BLACK);
         
-        // Count complete handshakes
-        captured = 0;
-        for (int i = 0; i < handshake_count; i++) {
-            if (handshakes[i].has_beacon && handshakes[i].has_auth && 
-                handshakes[i].has_assoc_req && handshakes[i].eapol_count >= 2) {
-                captured++;
-            }
-        }
+        // Complete M1-M4 exchanges so far
+        eapol_tracker_stats_t hs;
+        eapol_tracker_get_stats(&hs);
+        captured = hs.complete;
         
         char capture_info[64];
-        snprintf(capture_info, sizeof(capture_info), "Net: %d Cap: %d", handshake_count, captured);
+        snprintf(capture_info, sizeof(capture_info), "Net: %d Pairs: %lu Cap: %d",
+                 network_count, (unsigned long)hs.pairs, captured);
         display_fill_rect(10, 80, 220, 15, COLOR_BLACK);
         display_draw_text(10, 80, capture_info, COLOR_GREEN, COLOR_BLACK);
         
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
-    esp_wifi_set_promiscuous(false);
+    channel_hopper_stop();
+    promisc_unsubscribe(handshake_promiscuous_cb);
     esp_wifi_set_mode(WIFI_MODE_STA);
     
     // Save captured handshakes
-    for (int i = 0; i < captured; i++) {
-        packet_log_handshake_capture(handshakes[i].ssid, 
-                                    "XX:XX:XX:XX:XX:XX"); // Simplified MAC
-    }
+    eapol_tracker_foreach(log_complete_pair, NULL);
     
     // Results screen
     display_fill_screen(COLOR_BLACK);
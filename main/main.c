@@ -23,6 +23,8 @@
 #include "led_alerts.h"
 #include "antenna_indicator.h"
 #include "oui_spy.h"
+#include "device_table.h"
+#include "oui_db.h"
 
 static const char* TAG = "MAIN";
 
@@ -91,6 +93,11 @@ void app_main(void) {
     vTaskDelay(pdMS_TO_TICKS(500));
     
     display_loading(50, COLOR_ORANGE);
+    ret = device_table_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Device table init failed: %s", esp_err_to_name(ret));
+    }
+    oui_db_init();
     ret = wifi_init();
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "WiFi init failed: %s", esp_err_to_name(ret));
@@ -28,6 +28,7 @@
 #include "stats_tracker.h"
 #include "attack_timer.h"
 #include "oui_spy.h"
+#include "display_bench.h"
 #include <string.h>
 
 static const char* TAG = "MENU";
@@ -108,6 +109,7 @@ static const char* tools_menu_items[] = {
     "Target Manager",
     "Packet Logger",
     "Signal Analyzer",
+    "Display Bench",
     "Back"
 };
 
@@ -218,7 +220,7 @@ void menu_draw(void) {
                 break;
             case MENU_TOOLS:
                 submenu_items = tools_menu_items;
-                submenu_count = 6;
+                submenu_count = 5;
                 break;
             case MENU_SETTING:
                 submenu_items = settings_menu_items;
@@ -243,7 +245,7 @@ void menu_draw(void) {
         // Page indicator and scroll buttons
         int total_pages = (submenu_count + items_per_page - 1) / items_per_page;
         if (total_pages > 1) {
-            char page_str[20];
+            char page_str[32];
             snprintf(page_str, sizeof(page_str), "Page %d/%d", scroll_offset + 1, total_pages);
             display_draw_text(80, 260, page_str, COLOR_BLUE, COLOR_BLACK);
             
@@ -492,11 +494,12 @@ void execute_tools_function(int index) {
         case 0: target_manager_ui(); break;
         case 1: //packet_logger_ui(); break;
         case 2: //signal_analyzer_ui(); break;
-        case 3:
+        case 4:
             menu_state.in_submenu = false;
             scroll_offset = 0;
             menu_draw();
             return;
+        case 3: display_bench_run(); break;
     }
     
     if (ret != ESP_OK) {
@@ -593,7 +596,7 @@ void menu_handle_input(void) {
                     else if (menu_state.current_index == MENU_SUBGHZ) submenu_count = 6;
                     else if (menu_state.current_index == MENU_IR_REMOTE) submenu_count = 4;
                     else if (menu_state.current_index == MENU_NFC_RFID) submenu_count = 4;
-                    else if (menu_state.current_index == MENU_TOOLS) submenu_count = 4;
+                    else if (menu_state.current_index == MENU_TOOLS) submenu_count = 5;
                     else if (menu_state.current_index == MENU_SETTING) submenu_count = 7;
                     else submenu_count = 0;
                     
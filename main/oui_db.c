@@ -0,0 +1,94 @@
+#include "oui_db.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include <string.h>
+
+static const char* TAG = "OUI_DB";
+
+#define OUI_DB_PARTITION_LABEL      "oui"
+#define OUI_DB_PARTITION_SUBTYPE    0x40
+
+static const uint8_t* entries = NULL;
+static const char* names = NULL;
+static uint32_t entry_count = 0;
+static esp_partition_mmap_handle_t map_handle;
+
+static uint32_t read_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+esp_err_t oui_db_init(void) {
+    if (entries) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           OUI_DB_PARTITION_SUBTYPE,
+                                                           OUI_DB_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No OUI partition");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void* base;
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                       &base, &map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // An erased or foreign partition fails these checks, not the lookups
+    const uint8_t* hdr = base;
+    uint32_t count = read_le32(hdr + 4);
+    uint32_t names_off = read_le32(hdr + 8);
+    uint32_t size = read_le32(hdr + 12);
+    if (memcmp(hdr, OUI_DB_MAGIC, 4) != 0 || size > part->size ||
+        names_off != OUI_DB_HEADER_SIZE + count * OUI_DB_ENTRY_SIZE || names_off >= size) {
+        ESP_LOGW(TAG, "OUI partition holds no valid image");
+        esp_partition_munmap(map_handle);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    entries = hdr + OUI_DB_HEADER_SIZE;
+    names = (const char*)hdr + names_off;
+    entry_count = count;
+    ESP_LOGI(TAG, "Mapped %lu OUIs", (unsigned long)count);
+    return ESP_OK;
+}
+
+const char* oui_db_lookup(const uint8_t* mac) {
+    uint32_t key = oui_key(mac);
+    uint32_t lo = 0, hi = entry_count;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const uint8_t* e = entries + mid * OUI_DB_ENTRY_SIZE;
+        uint32_t k = oui_key(e);
+        if (k == key) {
+            return names + (e[3] | (e[4] << 8) | (e[5] << 16));
+        }
+        if (k < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+size_t oui_db_count(void) {
+    return entry_count;
+}
+
+const char* oui_table_lookup(const oui_name_t* table, size_t count, const uint8_t* mac) {
+    uint32_t key = oui_key(mac);
+    size_t lo = 0, hi = count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (table[mid].oui == key) {
+            return table[mid].name;
+        }
+        if (table[mid].oui < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
@@ -0,0 +1,42 @@
+#ifndef OUI_DB_H
+#define OUI_DB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// IEEE OUI registry compiled by tools/gen_oui_db.py into the "oui" data
+// partition and memory-mapped at boot, so vendor lookups cost no RAM.
+//
+// Image layout (integers little-endian):
+//   0   magic "OUI1"
+//   4   uint32 entry count
+//   8   uint32 offset of the name blob
+//   12  uint32 total image size
+//   16  entries, sorted by OUI: 3-byte OUI (big-endian) + 3-byte name offset
+//   ..  NUL-terminated vendor names, deduplicated
+#define OUI_DB_MAGIC            "OUI1"
+#define OUI_DB_HEADER_SIZE      16
+#define OUI_DB_ENTRY_SIZE       6
+
+// 24-bit key of a MAC's first three octets
+static inline uint32_t oui_key(const uint8_t* mac) {
+    return ((uint32_t)mac[0] << 16) | ((uint32_t)mac[1] << 8) | mac[2];
+}
+
+// Maps the partition; without it lookups simply return NULL
+esp_err_t oui_db_init(void);
+
+// Vendor name for mac's OUI, or NULL. The string lives in flash.
+const char* oui_db_lookup(const uint8_t* mac);
+size_t oui_db_count(void);
+
+// Small curated tables compiled into the firmware, sorted by oui
+typedef struct {
+    uint32_t oui;
+    const char* name;
+} oui_name_t;
+
+const char* oui_table_lookup(const oui_name_t* table, size_t count, const uint8_t* mac);
+
+#endif // OUI_DB_H
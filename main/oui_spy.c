@@ -2,11 +2,17 @@
 #include "display.h"
 #include "touchscreen.h"
 #include "utils.h"
+#include "ui_effects.h"
 #include "settings.h"
+#include "channel_hopper.h"
+#include "promisc_mux.h"
+#include "wifi_frame.h"
+#include "device_table.h"
+#include "oui_db.h"
+#include "watchlist.h"
+#include "board_config.h"
 #include "esp_log.h"
-#include "esp_bt.h"
-#include "esp_gap_ble_api.h"
-#include "esp_bt_main.h"
+#include "ble_radio.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
@@ -15,182 +21,123 @@
 
 static const char* TAG = "OUI_SPY";
 
-// Built-in OUI database - Surveillance/Security devices
-typedef struct {
-    const char* oui;
-    const char* vendor;
-} oui_entry_t;
-
-static const oui_entry_t oui_database[] = {
-    // Ring (Doorbell/Security)
-    {"18:7f:88", "Ring"},
-    {"24:2b:d6", "Ring"},
-    {"34:3e:a4", "Ring"},
-    {"54:e0:19", "Ring"},
-    {"5c:47:5e", "Ring"},
-    {"64:9a:63", "Ring"},
-    {"90:48:6c", "Ring"},
-    {"9c:76:13", "Ring"},
-    {"ac:9f:c3", "Ring"},
-    {"c4:db:ad", "Ring"},
-    {"cc:3b:fb", "Ring"},
-    // Law Enforcement
-    {"00:25:df", "Axon Body Cam"},
-    // Surveillance
-    {"b4:1e:52", "Flock Safety"},
-    // Drones - DJI
-    {"0c:9a:e6", "DJI"},
-    {"8c:58:23", "DJI"},
-    {"04:a8:5a", "DJI"},
-    {"58:b8:58", "DJI"},
-    {"e4:7a:2c", "DJI"},
-    {"60:60:1f", "DJI"},
-    {"48:1c:b9", "DJI"},
-    {"34:d2:62", "DJI"},
-    // Drones - Parrot
-    {"00:12:1c", "Parrot"},
-    {"00:26:7e", "Parrot"},
-    {"90:03:b7", "Parrot"},
-    {"90:3a:e6", "Parrot"},
-    {"a0:14:3d", "Parrot"},
-    // Drones - Skydio
-    {"38:1d:14", "Skydio"},
-    // Common devices
-    {"00:13:37", "Hak5"},
-    {"00:c0:ca", "Alfa Networks"},
-    {"00:1c:b3", "Apple"},
-    {"00:1e:c2", "Apple"},
-    {"00:1f:5b", "Apple"},
-    {"28:cf:e9", "Apple"},
-    {"3c:15:c2", "Apple"},
-    {"f0:db:e2", "Apple"},
+// Built-in OUI database - Surveillance/Security devices, drones and common
+// hardware. Sorted by OUI for oui_table_lookup().
+static const oui_name_t oui_database[] = {
+    {0x00121C, "Parrot"},
+    {0x001337, "Hak5"},
+    {0x001CB3, "Apple"},
+    {0x001EC2, "Apple"},
+    {0x001F5B, "Apple"},
+    {0x0025DF, "Axon Body Cam"},
+    {0x00267E, "Parrot"},
+    {0x00C0CA, "Alfa Networks"},
+    {0x04A85A, "DJI"},
+    {0x0C9AE6, "DJI"},
+    {0x187F88, "Ring"},
+    {0x242BD6, "Ring"},
+    {0x28CFE9, "Apple"},
+    {0x343EA4, "Ring"},
+    {0x34D262, "DJI"},
+    {0x381D14, "Skydio"},
+    {0x3C15C2, "Apple"},
+    {0x481CB9, "DJI"},
+    {0x54E019, "Ring"},
+    {0x58B858, "DJI"},
+    {0x5C475E, "Ring"},
+    {0x60601F, "DJI"},
+    {0x649A63, "Ring"},
+    {0x8C5823, "DJI"},
+    {0x9003B7, "Parrot"},
+    {0x903AE6, "Parrot"},
+    {0x90486C, "Ring"},
+    {0x9C7613, "Ring"},
+    {0xA0143D, "Parrot"},
+    {0xAC9FC3, "Ring"},
+    {0xB41E52, "Flock Safety"},
+    {0xC4DBAD, "Ring"},
+    {0xCC3BFB, "Ring"},
+    {0xE47A2C, "DJI"},
+    {0xF0DBE2, "Apple"},
 };
 
-#define OUI_DB_SIZE (sizeof(oui_database) / sizeof(oui_entry_t))
-
-typedef struct {
-    char identifier[18];
-    char description[32];
-    bool is_full_mac;
-} oui_filter_t;
+#define OUI_DB_SIZE (sizeof(oui_database) / sizeof(oui_database[0]))
 
-typedef struct {
-    char mac[18];
-    int8_t rssi;
-    uint32_t last_seen;
-    uint32_t cooldown_until;
-} device_info_t;
-
-static oui_filter_t filters[10];
-static int filter_count = 0;
-static device_info_t devices[50];
+static bool watchlist_loaded = false;
 static int device_count = 0;
-static bool scanning = false;
 
-static void normalize_mac(char* mac) {
-    for (int i = 0; mac[i]; i++) {
-        if (mac[i] >= 'A' && mac[i] <= 'F') mac[i] += 32;
-    }
-}
+// Device table ids of new detections, consumed by the scan screen's log
+#define NEW_DETECT_LOG  16
+static uint16_t new_detects[NEW_DETECT_LOG];
+static volatile uint32_t new_detect_head = 0;
+static bool scanning = false;
 
-static bool matches_filter(const char* mac, char* matched_desc) {
-    char normalized[18];
-    strncpy(normalized, mac, sizeof(normalized));
-    normalize_mac(normalized);
-    
-    // Check user filters first
-    for (int i = 0; i < filter_count; i++) {
-        char filter_id[18];
-        strncpy(filter_id, filters[i].identifier, sizeof(filter_id));
-        normalize_mac(filter_id);
-        
-        if (filters[i].is_full_mac) {
-            if (strcmp(normalized, filter_id) == 0) {
-                strcpy(matched_desc, filters[i].description);
-                return true;
-            }
-        } else {
-            if (strncmp(normalized, filter_id, 8) == 0) {
-                strcpy(matched_desc, filters[i].description);
-                return true;
-            }
-        }
+static bool matches_filter(const uint8_t* bda, char* matched_desc) {
+    // User watchlist first, longest prefix wins
+    if (watchlist_match(bda, matched_desc, 32)) {
+        return true;
     }
     
     // Check built-in OUI database
-    for (int i = 0; i < OUI_DB_SIZE; i++) {
-        if (strncmp(normalized, oui_database[i].oui, 8) == 0) {
-            strcpy(matched_desc, oui_database[i].vendor);
-            return true;
-        }
+    const char* vendor = oui_table_lookup(oui_database, OUI_DB_SIZE, bda);
+    if (vendor) {
+        strcpy(matched_desc, vendor);
+        return true;
     }
     
     return false;
 }
 
-static void gap_callback(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
-    if (event == ESP_GAP_BLE_SCAN_RESULT_EVT && param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+static void scan_callback(esp_ble_gap_cb_param_t *param, void* ctx) {
+    char matched_desc[32];
+    if (matches_filter(param->scan_rst.bda, matched_desc)) {
+        device_info_t prev;
+        int id = device_table_find(DEVICE_KIND_BLE, param->scan_rst.bda);
+        bool known = id >= 0 && device_table_get(id, &prev) && (prev.flags & DEVICE_FLAG_WATCHED);
+        
+        device_sighting_t sighting = {
+            .kind = DEVICE_KIND_BLE,
+            .mac = param->scan_rst.bda,
+            .rssi = param->scan_rst.rssi,
+            .flags = DEVICE_FLAG_WATCHED
+        };
+        id = device_table_update(&sighting, NULL);
+        if (id < 0) return;
+        
         char mac[18];
         snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
                  param->scan_rst.bda[0], param->scan_rst.bda[1], param->scan_rst.bda[2],
                  param->scan_rst.bda[3], param->scan_rst.bda[4], param->scan_rst.bda[5]);
         
-        char matched_desc[32];
-        if (matches_filter(mac, matched_desc)) {
-            uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            
-            bool found = false;
-            for (int i = 0; i < device_count; i++) {
-                if (strcmp(devices[i].mac, mac) == 0) {
-                    found = true;
-                    if (now >= devices[i].cooldown_until) {
-                        devices[i].rssi = param->scan_rst.rssi;
-                        devices[i].last_seen = now;
-                        devices[i].cooldown_until = now + 3000;
-                        ESP_LOGI(TAG, "Re-detected: %s (%s) RSSI: %d", mac, matched_desc, param->scan_rst.rssi);
-                    }
-                    break;
-                }
-            }
-            
-            if (!found && device_count < 50) {
-                strncpy(devices[device_count].mac, mac, sizeof(devices[device_count].mac));
-                devices[device_count].rssi = param->scan_rst.rssi;
-                devices[device_count].last_seen = now;
-                devices[device_count].cooldown_until = now + 3000;
-                device_count++;
-                ESP_LOGI(TAG, "NEW: %s (%s) RSSI: %d", mac, matched_desc, param->scan_rst.rssi);
-            }
+        if (!known) {
+            new_detects[new_detect_head % NEW_DETECT_LOG] = id;
+            new_detect_head++;
+            device_count++;
+            ESP_LOGI(TAG, "NEW: %s (%s) RSSI: %d", mac, matched_desc, param->scan_rst.rssi);
+        } else if (device_table_now_ms() - prev.last_seen_ms >= 3000) {
+            ESP_LOGI(TAG, "Re-detected: %s (%s) RSSI: %d", mac, matched_desc, param->scan_rst.rssi);
         }
     }
 }
 
 esp_err_t oui_spy_init(void) {
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-    esp_bt_controller_init(&bt_cfg);
-    esp_bt_controller_enable(ESP_BT_MODE_BLE);
-    esp_bluedroid_init();
-    esp_bluedroid_enable();
-    esp_ble_gap_register_callback(gap_callback);
+    esp_err_t ret = ble_radio_init();
+    if (ret != ESP_OK) return ret;
     
     ESP_LOGI(TAG, "OUI-Spy initialized");
     return ESP_OK;
 }
 
 void oui_spy_add_filter(const char* mac_or_oui, const char* description) {
-    if (filter_count >= 10) return;
-    
-    strncpy(filters[filter_count].identifier, mac_or_oui, sizeof(filters[filter_count].identifier) - 1);
-    strncpy(filters[filter_count].description, description, sizeof(filters[filter_count].description) - 1);
-    filters[filter_count].is_full_mac = (strlen(mac_or_oui) == 17);
-    filter_count++;
+    if (watchlist_add_str(mac_or_oui, description) != ESP_OK) return;
     
     ESP_LOGI(TAG, "Added filter: %s (%s)", mac_or_oui, description);
 }
 
 void oui_spy_clear_filters(void) {
-    filter_count = 0;
+    watchlist_clear();
     device_count = 0;
+    device_table_clear_flags(DEVICE_KIND_BLE, DEVICE_FLAG_WATCHED);
 }
 
 int oui_spy_get_device_count(void) {
@@ -202,8 +149,14 @@ void oui_spy_scan(void) {
     display_draw_text(10, 10, "OUI-Spy Scanner", COLOR_WHITE, COLOR_BLACK);
     display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_ORANGE);
     
+    // The SD card is mounted on demand, so the watchlist file is read on
+    // first use rather than at boot
+    if (!watchlist_loaded) {
+        watchlist_loaded = watchlist_load(OUI_SPY_WATCHLIST_PATH) >= 0;
+    }
+    
     char info[64];
-    snprintf(info, sizeof(info), "DB: %d OUIs | Filters: %d", OUI_DB_SIZE, filter_count);
+    snprintf(info, sizeof(info), "DB: %d OUIs | Filters: %d", OUI_DB_SIZE, (int)watchlist_count());
     display_draw_text(10, 40, info, COLOR_BLUE, COLOR_BLACK);
     display_draw_text(10, 60, "Scanning...", COLOR_GREEN, COLOR_BLACK);
     
@@ -216,24 +169,30 @@ void oui_spy_scan(void) {
         .scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE
     };
     
-    esp_ble_gap_set_scan_params(&scan_params);
-    esp_ble_gap_start_scanning(30);
+    ble_radio_subscribe(scan_callback, NULL, NULL);
+    ble_radio_scan_start(&scan_params, 30);
     scanning = true;
     
     uint32_t start = xTaskGetTickCount();
-    int y = 80;
+    uint32_t logged = new_detect_head;
+    
+    // New detections scroll through a log below the counter
+    ui_log_begin(100, 16);
     
     while ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(30000)) {
         snprintf(info, sizeof(info), "Detected: %d devices", device_count);
         display_fill_rect(10, 80, 220, 20, COLOR_BLACK);
         display_draw_text(10, 80, info, COLOR_GREEN, COLOR_BLACK);
         
-        y = 100;
-        for (int i = 0; i < device_count && y < 260; i++) {
+        // Skip anything the log ring already overwrote
+        if (new_detect_head - logged > NEW_DETECT_LOG) logged = new_detect_head - NEW_DETECT_LOG;
+        for (; logged != new_detect_head; logged++) {
+            device_info_t dev;
+            if (!device_table_get(new_detects[logged % NEW_DETECT_LOG], &dev)) continue;
             char dev_info[48];
-            snprintf(dev_info, sizeof(dev_info), "%.17s %d", devices[i].mac, devices[i].rssi);
-            display_draw_text(10, y, dev_info, COLOR_WHITE, COLOR_BLACK);
-            y += 15;
+            snprintf(dev_info, sizeof(dev_info), "%02x:%02x:%02x:%02x:%02x:%02x %d",
+                     dev.mac[0], dev.mac[1], dev.mac[2], dev.mac[3], dev.mac[4], dev.mac[5], dev.rssi);
+            ui_log_line(dev_info, COLOR_WHITE);
         }
         
         touch_point_t p = touchscreen_get_point();
@@ -242,11 +201,13 @@ void oui_spy_scan(void) {
         vTaskDelay(pdMS_TO_TICKS(500));
     }
     
-    esp_ble_gap_stop_scanning();
+    ble_radio_scan_stop();
+    ble_radio_unsubscribe(scan_callback);
     scanning = false;
     
     display_draw_text(10, 280, "Scan complete", COLOR_GREEN, COLOR_BLACK);
     vTaskDelay(pdMS_TO_TICKS(2000));
+    ui_log_end();
 }
 
 
@@ -254,30 +215,15 @@ void oui_spy_scan(void) {
 static int flock_wifi_count = 0;
 static int flock_ble_count = 0;
 
-static void wifi_sniffer_callback(void* buf, wifi_promiscuous_pkt_type_t type) {
-    if (type != WIFI_PKT_MGMT) return;
+static void wifi_sniffer_callback(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    wifi_frame_t frame;
+    if (!wifi_frame_from_pkt(&frame, pkt)) return;
     
-    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t*)buf;
-    if (pkt->rx_ctrl.sig_len < 24) return; // Ensure minimum frame size
-    
-    uint8_t *payload = pkt->payload;
-    
-    // Check for Flock Safety MAC (B4:1E:52) in all MAC address fields
-    // Destination MAC (offset 4-9), Source MAC (offset 10-15), BSSID (offset 16-21)
-    bool is_flock = false;
-    
-    // Check destination address
-    if (payload[4] == 0xb4 && payload[5] == 0x1e && payload[6] == 0x52) {
-        is_flock = true;
-    }
-    // Check source address
-    else if (payload[10] == 0xb4 && payload[11] == 0x1e && payload[12] == 0x52) {
-        is_flock = true;
-    }
-    // Check BSSID
-    else if (payload[16] == 0xb4 && payload[17] == 0x1e && payload[18] == 0x52) {
-        is_flock = true;
-    }
+    // Check for Flock Safety MAC (B4:1E:52) in destination, source and BSSID
+    static const uint8_t flock_oui[3] = {0xb4, 0x1e, 0x52};
+    bool is_flock = memcmp(frame.addr1, flock_oui, 3) == 0 ||
+                    memcmp(frame.addr2, flock_oui, 3) == 0 ||
+                    memcmp(frame.addr3, flock_oui, 3) == 0;
     
     if (is_flock) {
         flock_wifi_count++;
@@ -285,16 +231,10 @@ static void wifi_sniffer_callback(void* buf, wifi_promiscuous_pkt_type_t type) {
     }
 }
 
-static void flock_ble_callback(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
-    if (event == ESP_GAP_BLE_SCAN_RESULT_EVT && param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
-        // Check for Flock Safety BLE MAC (B4:1E:52)
-        if (param->scan_rst.bda[0] == 0xb4 && 
-            param->scan_rst.bda[1] == 0x1e && 
-            param->scan_rst.bda[2] == 0x52) {
-            flock_ble_count++;
-            ESP_LOGI(TAG, "Flock BLE detected!");
-        }
-    }
+// Only sees Flock Safety addresses (B4:1E:52), see the subscription filter
+static void flock_ble_callback(esp_ble_gap_cb_param_t *param, void* ctx) {
+    flock_ble_count++;
+    ESP_LOGI(TAG, "Flock BLE detected!");
 }
 
 void oui_spy_flock_detector(void) {
@@ -311,12 +251,17 @@ void oui_spy_flock_detector(void) {
     esp_wifi_start();
     vTaskDelay(pdMS_TO_TICKS(100));
     
-    // Start WiFi promiscuous mode
-    esp_wifi_set_promiscuous_rx_cb(wifi_sniffer_callback);
-    esp_wifi_set_promiscuous(true);
+    // Start WiFi promiscuous mode, management frames only
+    promisc_filter_t rx_filter = { .types = WIFI_PROMIS_FILTER_MASK_MGMT };
+    promisc_subscribe(wifi_sniffer_callback, &rx_filter, NULL);
+    channel_hopper_start(NULL);
     
-    // Register BLE callback for Flock detection
-    esp_ble_gap_register_callback(flock_ble_callback);
+    // Subscribe to BLE results from Flock's OUI only
+    ble_scan_filter_t flock_filter = {
+        .prefix = {0xb4, 0x1e, 0x52},
+        .prefix_len = 3
+    };
+    ble_radio_subscribe(flock_ble_callback, &flock_filter, NULL);
     
     // Start BLE scan
     esp_ble_scan_params_t scan_params = {
@@ -327,8 +272,7 @@ void oui_spy_flock_detector(void) {
         .scan_window = 0x30,
         .scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE
     };
-    esp_ble_gap_set_scan_params(&scan_params);
-    esp_ble_gap_start_scanning(30);
+    ble_radio_scan_start(&scan_params, 30);
     
     uint32_t start = xTaskGetTickCount();
     
@@ -354,10 +298,10 @@ void oui_spy_flock_detector(void) {
     }
     
     // Cleanup
-    esp_wifi_set_promiscuous(false);
-    esp_wifi_set_promiscuous_rx_cb(NULL);
-    esp_ble_gap_stop_scanning();
-    esp_ble_gap_register_callback(gap_callback); // Restore original callback
+    channel_hopper_stop();
+    promisc_unsubscribe(wifi_sniffer_callback);
+    ble_radio_scan_stop();
+    ble_radio_unsubscribe(flock_ble_callback);
     
     display_draw_text(10, 280, "Scan complete", COLOR_GREEN, COLOR_BLACK);
     vTaskDelay(pdMS_TO_TICKS(2000));
@@ -3,12 +3,240 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_spiffs.h"
+#include "spsc_ring.h"
+#include "pcapng.h"
+#include "capture_filter.h"
+#include "promisc_mux.h"
+#include "board_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 static const char* TAG = "PKT_CAP";
 static packet_capture_t capture = {0};
 
+// The promiscuous callback runs in the Wi-Fi driver task, so it only copies
+// the finished pcap record into the ring and returns. A writer task on the
+// other core drains the ring into the file in large contiguous writes.
+#define CAPTURE_RING_SIZE       (32 * 1024)
+#define CAPTURE_WRITER_CORE     1
+#define CAPTURE_WRITER_POLL_MS  20
+#define CAPTURE_REOPEN_RETRY_MS 1000    // back-off after a rotation fails to open
+
+// Radiotap header stored in front of every frame. The field order keeps each
+// field naturally aligned, so one layout serves both legacy and HT frames:
+// HT frames clear the Rate bit (its byte becomes padding before Channel) and
+// legacy frames clear the MCS bit (the last three bytes become trailing pad).
+typedef struct {
+    uint8_t  version;
+    uint8_t  pad;
+    uint16_t len;
+    uint32_t present;
+    uint64_t tsft;
+    uint8_t  flags;
+    uint8_t  rate;          // 500 kbps units
+    uint16_t chan_freq;
+    uint16_t chan_flags;
+    int8_t   antsignal;
+    int8_t   antnoise;
+    uint8_t  antenna;
+    uint8_t  mcs_known;
+    uint8_t  mcs_flags;
+    uint8_t  mcs_index;
+} __attribute__((packed)) radiotap_hdr_t;
+
+#define RT_PRESENT_COMMON   ((1 << 0) | (1 << 1) | (1 << 3) | (1 << 5) | (1 << 6) | (1 << 11))
+#define RT_PRESENT_RATE     (1 << 2)
+#define RT_PRESENT_MCS      (1 << 19)
+#define RT_FLAG_SHORTPRE    0x02
+#define RT_FLAG_FCS         0x10    // ESP32 payloads end with the FCS
+#define RT_CHAN_CCK         0x0020
+#define RT_CHAN_OFDM        0x0040
+#define RT_CHAN_2GHZ        0x0080
+#define RT_MCS_KNOWN        0x37    // bandwidth, index, GI, FEC, STBC
+
+static const radiotap_hdr_t rt_legacy = {
+    .len = sizeof(radiotap_hdr_t),
+    .present = RT_PRESENT_COMMON | RT_PRESENT_RATE,
+    .flags = RT_FLAG_FCS,
+    .chan_flags = RT_CHAN_2GHZ
+};
+
+static const radiotap_hdr_t rt_ht = {
+    .len = sizeof(radiotap_hdr_t),
+    .present = RT_PRESENT_COMMON | RT_PRESENT_MCS,
+    .flags = RT_FLAG_FCS,
+    .chan_flags = RT_CHAN_2GHZ | RT_CHAN_OFDM,
+    .mcs_known = RT_MCS_KNOWN
+};
+
+// rx_ctrl.rate (wifi_phy_rate_t) to radiotap units; codes 5-7 are short preamble
+static const uint8_t rt_rate_units[16] = {
+    2, 4, 11, 22, 0, 4, 11, 22, 96, 48, 24, 12, 108, 72, 36, 18
+};
+
+static const uint16_t rt_chan_freq[16] = {
+    0, 2412, 2417, 2422, 2427, 2432, 2437, 2442,
+    2447, 2452, 2457, 2462, 2467, 2472, 2484, 0
+};
+
+static spsc_ring_t capture_ring;
+static capture_filter_t capture_rx_filter;
+static capture_writer_t capture_file;
+static capture_writer_stats_t closed_stats;    // totals of files already rotated out
+
+// Rotation policy, applied by the writer task between records
+static uint32_t rotate_bytes = CAPTURE_ROTATE_BYTES;
+static uint32_t rotate_seconds = CAPTURE_ROTATE_SECONDS;
+static uint8_t keep_files = CAPTURE_KEEP_FILES;
+static char file_base[48];
+static uint32_t file_index;
+static int64_t file_opened_us;
+static int64_t reopen_at_us;            // earliest retry while no file is open
+static bool writes_failing;             // logged once per outage, see capture_lost()
+static TaskHandle_t writer_task = NULL;
+static SemaphoreHandle_t writer_done = NULL;
+static volatile bool writer_stop = false;
+
+static void capture_file_path(char* out, size_t len, uint32_t index) {
+    if (rotate_bytes == 0 && rotate_seconds == 0) {
+        snprintf(out, len, "/spiffs/%s.pcapng", file_base);
+    } else {
+        snprintf(out, len, "/spiffs/%s_%04lu.pcapng", file_base, (unsigned long)index);
+    }
+}
+
+// Opens the next file in the sequence and writes the pcapng preamble
+static esp_err_t capture_open_file(void) {
+    char filepath[80];
+    capture_file_path(filepath, sizeof(filepath), file_index);
+    
+    capture_writer_config_t file_config = {
+        .block_size = CAPTURE_BLOCK_SIZE,
+        .prealloc_bytes = CAPTURE_PREALLOC_BYTES,
+        .sync_bytes = CAPTURE_SYNC_BYTES,
+        .sync_ms = CAPTURE_SYNC_MS
+    };
+    if (capture_writer_open(&capture_file, filepath, &file_config) != ESP_OK) {
+        if (!writes_failing) {
+            ESP_LOGE(TAG, "Failed to open file: %s", filepath);
+        }
+        return ESP_FAIL;
+    }
+    
+    // Write pcapng section and interface headers
+    uint8_t preamble[PCAPNG_PREAMBLE_LEN];
+    pcapng_write_preamble(preamble, LINKTYPE_IEEE802_11_RADIOTAP, 65535);
+    capture_writer_append(&capture_file, preamble, sizeof(preamble));
+    
+    strncpy(capture.filename, filepath + strlen("/spiffs/"), sizeof(capture.filename) - 1);
+    file_opened_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+static void capture_close_file(void) {
+    capture_writer_close(&capture_file);
+    
+    const capture_writer_stats_t* st = &capture_file.stats;
+    closed_stats.bytes_written += st->bytes_written;
+    closed_stats.writes += st->writes;
+    closed_stats.syncs += st->syncs;
+    closed_stats.busy_us += st->busy_us;
+    closed_stats.elapsed_us += st->elapsed_us;
+    if (st->worst_write_us > closed_stats.worst_write_us) {
+        closed_stats.worst_write_us = st->worst_write_us;
+    }
+}
+
+// A failed write or a missing file drops records until the writer recovers;
+// each outage is logged once when it starts and once when it ends, and the
+// bytes lost in between are counted in capture.lost_bytes
+static void capture_lost(size_t len) {
+    if (!writes_failing) {
+        ESP_LOGE(TAG, "Write failed, dropping records until the file is writable");
+        writes_failing = true;
+    }
+    capture.lost_bytes += len;
+}
+
+static void capture_recovered(void) {
+    if (writes_failing) {
+        ESP_LOGI(TAG, "Writing again, %lu bytes lost so far", (unsigned long)capture.lost_bytes);
+        writes_failing = false;
+    }
+}
+
+// Switches to the next file once the current one hits its size or age cap.
+// Records keep queueing in the ring meanwhile, so the capture never pauses.
+// If the next file cannot be opened, records are dropped and the open is
+// retried every CAPTURE_REOPEN_RETRY_MS; no old file is deleted until a
+// new one is open.
+static void capture_maybe_rotate(void) {
+    int64_t now = esp_timer_get_time();
+    
+    if (capture_file.fd >= 0) {
+        bool full = rotate_bytes > 0 && capture_file.file_off >= rotate_bytes;
+        bool old = rotate_seconds > 0 &&
+                   now - file_opened_us >= (int64_t)rotate_seconds * 1000000;
+        if (!full && !old) {
+            return;
+        }
+        capture_close_file();
+    } else if (now < reopen_at_us) {
+        return;
+    }
+    
+    file_index++;
+    if (capture_open_file() != ESP_OK) {
+        file_index--;
+        writes_failing = true;
+        reopen_at_us = now + (int64_t)CAPTURE_REOPEN_RETRY_MS * 1000;
+        return;
+    }
+    capture.files++;
+    capture_recovered();
+    
+    // Ring-of-files mode: drop the oldest file so only the last N remain
+    if (keep_files > 0 && file_index > keep_files) {
+        char oldest[80];
+        capture_file_path(oldest, sizeof(oldest), file_index - keep_files);
+        unlink(oldest);
+    }
+    ESP_LOGI(TAG, "Rotated to %s", capture.filename);
+}
+
+// Moves every committed run in the ring into the block writer
+static void capture_drain(void) {
+    const uint8_t* data;
+    size_t len;
+    
+    while ((len = spsc_ring_peek(&capture_ring, &data)) > 0) {
+        if (capture_file.fd < 0 || capture_writer_append(&capture_file, data, len) != ESP_OK) {
+            capture_lost(len);
+        } else {
+            capture_recovered();
+        }
+        spsc_ring_release(&capture_ring, len);
+    }
+}
+
+static void capture_writer_task(void* arg) {
+    while (!writer_stop) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAPTURE_WRITER_POLL_MS));
+        capture_drain();
+        capture_writer_poll(&capture_file);
+        capture_maybe_rotate();
+    }
+    
+    // Producer is detached by now; write whatever is left
+    capture_drain();
+    xSemaphoreGive(writer_done);
+    vTaskDelete(NULL);
+}
+
 esp_err_t packet_capture_init(void) {
     memset(&capture, 0, sizeof(packet_capture_t));
     
@@ -36,42 +264,50 @@ esp_err_t packet_capture_start(const char* filename) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Create full path in SPIFFS
-    char filepath[80];
-    snprintf(filepath, sizeof(filepath), "/spiffs/%s", filename);
+    // The extension is ours to add; with rotation on, files are numbered
+    strncpy(file_base, filename, sizeof(file_base) - 1);
+    file_base[sizeof(file_base) - 1] = '\0';
+    char* ext = strrchr(file_base, '.');
+    if (ext) {
+        *ext = '\0';
+    }
     
-    // Open file for writing
-    FILE* f = fopen(filepath, "wb");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open file: %s", filepath);
+    file_index = 1;
+    capture.files = 1;
+    capture.lost_bytes = 0;
+    writes_failing = false;
+    memset(&closed_stats, 0, sizeof(closed_stats));
+    if (capture_open_file() != ESP_OK) {
         return ESP_FAIL;
     }
     
-    // Write PCAP file header
-    pcap_file_header_t pcap_header = {
-        .magic_number = 0xa1b2c3d4,
-        .version_major = 2,
-        .version_minor = 4,
-        .thiszone = 0,
-        .sigfigs = 0,
-        .snaplen = 65535,
-        .network = 105  // IEEE 802.11
-    };
+    if (spsc_ring_init(&capture_ring, CAPTURE_RING_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate capture ring");
+        capture_writer_close(&capture_file);
+        return ESP_ERR_NO_MEM;
+    }
     
-    if (fwrite(&pcap_header, sizeof(pcap_header), 1, f) != 1) {
-        ESP_LOGE(TAG, "Failed to write PCAP header");
-        fclose(f);
-        return ESP_FAIL;
+    if (writer_done == NULL) {
+        writer_done = xSemaphoreCreateBinary();
     }
     
-    capture.file_handle = f;
-    capture.active = true;
     capture.packet_count = 0;
     capture.bytes_captured = 0;
-    strncpy(capture.filename, filename, sizeof(capture.filename) - 1);
+    
+    writer_stop = false;
+    if (writer_done == NULL ||
+        xTaskCreatePinnedToCore(capture_writer_task, "pcap_writer", 4096, NULL, 5,
+                                &writer_task, CAPTURE_WRITER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start writer task");
+        spsc_ring_deinit(&capture_ring);
+        capture_writer_close(&capture_file);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    capture.active = true;
     
     led_alert_success();
-    ESP_LOGI(TAG, "Packet capture started: %s", filepath);
+    ESP_LOGI(TAG, "Packet capture started: %s", capture.filename);
     return ESP_OK;
 }
 
@@ -80,19 +316,30 @@ esp_err_t packet_capture_stop(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (capture.file_handle) {
-        fclose((FILE*)capture.file_handle);
-        capture.file_handle = NULL;
-    }
+    // Detach the producer first: once unsubscribe returns the handler is no
+    // longer running, so nothing can touch the ring or the writer handle
+    capture.active = false;
+    promisc_unsubscribe(packet_capture_handler);
+    writer_stop = true;
+    xTaskNotifyGive(writer_task);
+    xSemaphoreTake(writer_done, portMAX_DELAY);
+    writer_task = NULL;
+    
+    capture_close_file();
+    
+    capture.dropped = capture_ring.dropped;
+    capture.overflows = capture_ring.overflows;
+    spsc_ring_deinit(&capture_ring);
     
-    ESP_LOGI(TAG, "Capture stopped: %lu packets, %lu bytes", 
-             (unsigned long)capture.packet_count, (unsigned long)capture.bytes_captured);
+    ESP_LOGI(TAG, "Capture stopped: %lu packets, %lu bytes in %lu files, %lu dropped, %lu bytes lost, %.2f MB/s, worst write %lu us", 
+             (unsigned long)capture.packet_count, (unsigned long)capture.bytes_captured,
+             (unsigned long)capture.files, (unsigned long)capture.dropped, (unsigned long)capture.lost_bytes,
+             capture_writer_mbps(&closed_stats), (unsigned long)closed_stats.worst_write_us);
     
     if (capture.packet_count > 0) {
         led_alert_capture();
     }
     
-    capture.active = false;
     return ESP_OK;
 }
 
@@ -104,37 +351,104 @@ uint32_t packet_capture_get_count(void) {
     return capture.packet_count;
 }
 
-void packet_capture_handler(void* buf, wifi_promiscuous_pkt_type_t type) {
-    if (!capture.active || !capture.file_handle) {
+uint32_t packet_capture_get_dropped(void) {
+    return capture.active ? capture_ring.dropped : capture.dropped;
+}
+
+uint32_t packet_capture_get_lost_bytes(void) {
+    return capture.lost_bytes;
+}
+
+uint32_t packet_capture_get_overflows(void) {
+    return capture.active ? capture_ring.overflows : capture.overflows;
+}
+
+esp_err_t packet_capture_set_rotation(uint32_t max_bytes, uint32_t max_seconds, uint8_t keep_last) {
+    if (capture.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    rotate_bytes = max_bytes;
+    rotate_seconds = max_seconds;
+    keep_files = keep_last;
+    return ESP_OK;
+}
+
+esp_err_t packet_capture_set_filter(const char* expr) {
+    if (capture.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return capture_filter_compile(&capture_rx_filter, expr);
+}
+
+void packet_capture_get_writer_stats(capture_writer_stats_t* stats) {
+    *stats = closed_stats;
+    if (!capture.active) {
+        return;
+    }
+    
+    capture_writer_stats_t current;
+    capture_writer_get_stats(&capture_file, &current);
+    stats->bytes_written += current.bytes_written;
+    stats->writes += current.writes;
+    stats->syncs += current.syncs;
+    stats->busy_us += current.busy_us;
+    stats->elapsed_us += current.elapsed_us;
+    if (current.worst_write_us > stats->worst_write_us) {
+        stats->worst_write_us = current.worst_write_us;
+    }
+}
+
+void packet_capture_handler(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    if (!capture.active) {
         return;
     }
     
-    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
+    if (!capture_filter_match(&capture_rx_filter, pkt)) {
+        return;
+    }
     
-    // Get timestamp
-    int64_t now = esp_timer_get_time();
-    uint32_t ts_sec = now / 1000000;
-    uint32_t ts_usec = now % 1000000;
-    
-    // Write packet header
-    pcap_packet_header_t pkt_header = {
-        .ts_sec = ts_sec,
-        .ts_usec = ts_usec,
-        .incl_len = pkt->rx_ctrl.sig_len,
-        .orig_len = pkt->rx_ctrl.sig_len
-    };
+    const wifi_pkt_rx_ctrl_t* rx = &pkt->rx_ctrl;
+    uint32_t len = rx->sig_len;
+    uint32_t caplen = sizeof(radiotap_hdr_t) + len;
     
-    FILE* f = (FILE*)capture.file_handle;
-    
-    if (fwrite(&pkt_header, sizeof(pkt_header), 1, f) == 1) {
-        if (fwrite(pkt->payload, pkt->rx_ctrl.sig_len, 1, f) == 1) {
-            capture.packet_count++;
-            capture.bytes_captured += pkt->rx_ctrl.sig_len;
-            
-            // Flush every 10 packets
-            if (capture.packet_count % 10 == 0) {
-                fflush(f);
-            }
+    uint8_t* slot = spsc_ring_reserve(&capture_ring, pcapng_epb_len(caplen));
+    if (slot == NULL) {
+        return;
+    }
+    
+    radiotap_hdr_t* rt = (radiotap_hdr_t*)pcapng_epb_begin(slot, esp_timer_get_time(), caplen, caplen);
+    
+    // Start from the template, then patch in the per-frame fields
+    if (rx->sig_mode == 0) {
+        memcpy(rt, &rt_legacy, sizeof(*rt));
+        rt->rate = rt_rate_units[rx->rate & 0x0F];
+        if (rx->rate < 8) {
+            rt->chan_flags |= RT_CHAN_CCK;
+            if (rx->rate >= 5) rt->flags |= RT_FLAG_SHORTPRE;
+        } else {
+            rt->chan_flags |= RT_CHAN_OFDM;
         }
+    } else {
+        memcpy(rt, &rt_ht, sizeof(*rt));
+        rt->mcs_index = rx->mcs;
+        rt->mcs_flags = rx->cwb | (rx->sgi << 2) | (rx->fec_coding << 4) | (rx->stbc << 5);
+    }
+    rt->tsft = rx->timestamp;
+    rt->chan_freq = rt_chan_freq[rx->channel];
+    rt->antsignal = rx->rssi;
+    rt->antnoise = rx->noise_floor;
+    rt->antenna = rx->ant;
+    
+    memcpy(rt + 1, pkt->payload, len);
+    pcapng_epb_finish(slot, caplen);
+    spsc_ring_commit(&capture_ring, pcapng_epb_len(caplen));
+    
+    capture.packet_count++;
+    capture.bytes_captured += len;
+    
+    // Wake the writer early under bursts instead of waiting for its poll
+    if (spsc_ring_used(&capture_ring) > CAPTURE_RING_SIZE / 2) {
+        xTaskNotifyGive(writer_task);
     }
 }
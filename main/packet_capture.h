@@ -5,47 +5,49 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "esp_wifi_types.h"
-
-// PCAP file format structures
-typedef struct {
-    uint32_t magic_number;
-    uint16_t version_major;
-    uint16_t version_minor;
-    int32_t  thiszone;
-    uint32_t sigfigs;
-    uint32_t snaplen;
-    uint32_t network;
-} pcap_file_header_t;
-
-typedef struct {
-    uint32_t ts_sec;
-    uint32_t ts_usec;
-    uint32_t incl_len;
-    uint32_t orig_len;
-} pcap_packet_header_t;
+#include "capture_writer.h"
 
 typedef struct {
     bool active;
     uint32_t packet_count;
     uint32_t bytes_captured;
-    char filename[64];
-    void* file_handle;
+    uint32_t dropped;       // frames lost because the ring was full
+    uint32_t overflows;     // times the ring filled up
+    uint32_t lost_bytes;    // record bytes dropped while no file was writable
+    uint32_t files;         // files opened so far, including the current one
+    char filename[64];      // file currently being written
 } packet_capture_t;
 
 // Initialize packet capture system
 esp_err_t packet_capture_init(void);
 
-// Start capturing packets to file
+// Start capturing packets to file. Any extension is replaced by .pcapng;
+// with rotation on, files are named <name>_0001.pcapng, <name>_0002.pcapng...
 esp_err_t packet_capture_start(const char* filename);
 
-// Stop capturing and close file
+// Rotate to a new file after max_bytes or max_seconds (0 disables either
+// limit) and, if keep_last is nonzero, delete all but the newest keep_last
+// files. Only allowed while no capture is running.
+esp_err_t packet_capture_set_rotation(uint32_t max_bytes, uint32_t max_seconds, uint8_t keep_last);
+
+// Only frames matching expr (see capture_filter.h) reach the ring; NULL
+// captures everything. Only allowed while no capture is running.
+esp_err_t packet_capture_set_filter(const char* expr);
+
+// Stop capturing and close file; also unsubscribes packet_capture_handler
 esp_err_t packet_capture_stop(void);
 
 // Get capture status
 bool packet_capture_is_active(void);
 uint32_t packet_capture_get_count(void);
+uint32_t packet_capture_get_dropped(void);
+uint32_t packet_capture_get_overflows(void);
+uint32_t packet_capture_get_lost_bytes(void);
+
+// Throughput and worst-case write latency of the current (or last) file
+void packet_capture_get_writer_stats(capture_writer_stats_t* stats);
 
-// Packet handler callback
-void packet_capture_handler(void* buf, wifi_promiscuous_pkt_type_t type);
+// Promiscuous consumer, see promisc_subscribe()
+void packet_capture_handler(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx);
 
 #endif // PACKET_CAPTURE_H
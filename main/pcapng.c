@@ -0,0 +1,49 @@
+#include "pcapng.h"
+#include <string.h>
+
+size_t pcapng_write_preamble(uint8_t* out, uint16_t linktype, uint32_t snaplen) {
+    pcapng_shb_t shb = {
+        .block_type = PCAPNG_BLOCK_SHB,
+        .block_len = sizeof(pcapng_shb_t),
+        .byte_order = PCAPNG_BYTE_ORDER,
+        .version_major = 1,
+        .version_minor = 0,
+        .section_len = -1,  // unknown, the file is streamed
+        .block_len_trailer = sizeof(pcapng_shb_t)
+    };
+    pcapng_idb_t idb = {
+        .block_type = PCAPNG_BLOCK_IDB,
+        .block_len = sizeof(pcapng_idb_t),
+        .linktype = linktype,
+        .reserved = 0,
+        .snaplen = snaplen,
+        .block_len_trailer = sizeof(pcapng_idb_t)
+    };
+
+    memcpy(out, &shb, sizeof(shb));
+    memcpy(out + sizeof(shb), &idb, sizeof(idb));
+    return PCAPNG_PREAMBLE_LEN;
+}
+
+uint8_t* pcapng_epb_begin(uint8_t* out, int64_t ts_us, uint32_t caplen, uint32_t origlen) {
+    pcapng_epb_t epb = {
+        .block_type = PCAPNG_BLOCK_EPB,
+        .block_len = pcapng_epb_len(caplen),
+        .interface_id = 0,
+        .ts_high = (uint32_t)((uint64_t)ts_us >> 32),
+        .ts_low = (uint32_t)ts_us,
+        .captured_len = caplen,
+        .original_len = origlen
+    };
+
+    memcpy(out, &epb, sizeof(epb));
+    return out + sizeof(epb);
+}
+
+void pcapng_epb_finish(uint8_t* out, uint32_t caplen) {
+    uint32_t block_len = pcapng_epb_len(caplen);
+    uint8_t* pad = out + sizeof(pcapng_epb_t) + caplen;
+
+    memset(pad, 0, (4 - (caplen & 3)) & 3);
+    memcpy(out + block_len - sizeof(uint32_t), &block_len, sizeof(block_len));
+}
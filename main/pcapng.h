@@ -0,0 +1,64 @@
+#ifndef PCAPNG_H
+#define PCAPNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Minimal pcapng writer: one section header, one interface per file and
+// enhanced packet blocks with microsecond timestamps. Blocks are laid out
+// in caller-provided memory so a record can be built directly in a ring slot.
+#define PCAPNG_BLOCK_SHB    0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB    0x00000001
+#define PCAPNG_BLOCK_EPB    0x00000006
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4D
+
+#define LINKTYPE_IEEE802_11             105
+#define LINKTYPE_IEEE802_11_RADIOTAP    127
+#define LINKTYPE_BLUETOOTH_LE_LL_WITH_PHDR  256
+
+typedef struct {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint32_t byte_order;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int64_t  section_len;
+    uint32_t block_len_trailer;
+} __attribute__((packed)) pcapng_shb_t;
+
+typedef struct {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint16_t linktype;
+    uint16_t reserved;
+    uint32_t snaplen;
+    uint32_t block_len_trailer;
+} __attribute__((packed)) pcapng_idb_t;
+
+typedef struct {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint32_t interface_id;
+    uint32_t ts_high;
+    uint32_t ts_low;
+    uint32_t captured_len;
+    uint32_t original_len;
+} __attribute__((packed)) pcapng_epb_t;
+
+// Size of the file preamble (SHB + IDB)
+#define PCAPNG_PREAMBLE_LEN (sizeof(pcapng_shb_t) + sizeof(pcapng_idb_t))
+
+// Writes the section header and a single interface description into out
+size_t pcapng_write_preamble(uint8_t* out, uint16_t linktype, uint32_t snaplen);
+
+// Total block size for an EPB carrying caplen bytes
+static inline size_t pcapng_epb_len(size_t caplen) {
+    return sizeof(pcapng_epb_t) + ((caplen + 3) & ~(size_t)3) + sizeof(uint32_t);
+}
+
+// Fills the EPB header and returns where the packet bytes go; once they are
+// in place, pcapng_epb_finish pads the block and writes the trailing length
+uint8_t* pcapng_epb_begin(uint8_t* out, int64_t ts_us, uint32_t caplen, uint32_t origlen);
+void pcapng_epb_finish(uint8_t* out, uint32_t caplen);
+
+#endif // PCAPNG_H
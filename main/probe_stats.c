@@ -0,0 +1,342 @@
+#include "probe_stats.h"
+#include "spsc_ring.h"
+#include "wifi_frame.h"
+#include "board_config.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char* TAG = "PROBE_STATS";
+
+#define WORKER_POLL_MS      50
+#define HLL_REGISTERS       (1 << PROBE_STATS_HLL_BITS)
+
+// Ring record: fixed header followed by ssid_len SSID bytes
+typedef struct __attribute__((packed)) {
+    uint8_t mac[6];
+    int8_t rssi;
+    uint8_t ssid_len;
+} probe_record_t;
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;
+    uint32_t count;
+    uint32_t error;
+    uint32_t first_ms;
+    uint32_t last_ms;
+} device_slot_t;
+
+static spsc_ring_t probe_ring;
+static probe_ssid_count_t ssids[PROBE_STATS_TOP_SSIDS];
+static device_slot_t devices[PROBE_STATS_TOP_DEVICES];
+static uint8_t hll[HLL_REGISTERS];
+static int ssid_used;
+static int device_used;
+static probe_stats_t stats;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t probe_task = NULL;
+static SemaphoreHandle_t probe_done = NULL;
+static volatile bool probe_stop = false;
+static volatile bool probe_running = false;
+
+// Set while the RX callback is writing into the ring; stop waits for it to
+// clear before freeing the ring, whatever the caller did with the mux
+static volatile bool producer_busy = false;
+static portMUX_TYPE producer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// FNV-1a followed by a 64-bit finalizer so every output bit is usable
+static uint64_t mac_hash(const uint8_t* mac) {
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 1099511628211ull;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static void hll_add(const uint8_t* mac) {
+    uint64_t h = mac_hash(mac);
+    uint32_t reg = h >> (64 - PROBE_STATS_HLL_BITS);
+    uint64_t rest = h << PROBE_STATS_HLL_BITS;
+    uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - PROBE_STATS_HLL_BITS + 1;
+    if (rank > hll[reg]) hll[reg] = rank;
+}
+
+static uint32_t hll_estimate(void) {
+    double sum = 0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -hll[i]);
+        if (hll[i] == 0) zeros++;
+    }
+
+    double m = HLL_REGISTERS;
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    // Linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return (uint32_t)(estimate + 0.5);
+}
+
+// Space-saving: a miss with the table full replaces the smallest counter,
+// inheriting its count as the new entry's error bound
+static void count_ssid(const char* ssid, uint8_t len) {
+    int min = 0;
+    for (int i = 0; i < ssid_used; i++) {
+        if (strncmp(ssids[i].ssid, ssid, len) == 0 && ssids[i].ssid[len] == '\0') {
+            ssids[i].count++;
+            return;
+        }
+        if (ssids[i].count < ssids[min].count) min = i;
+    }
+
+    probe_ssid_count_t* slot;
+    if (ssid_used < PROBE_STATS_TOP_SSIDS) {
+        slot = &ssids[ssid_used++];
+        slot->count = 0;
+        slot->error = 0;
+    } else {
+        slot = &ssids[min];
+        slot->error = slot->count;
+    }
+    memcpy(slot->ssid, ssid, len);
+    slot->ssid[len] = '\0';
+    slot->count++;
+}
+
+static void count_device(const uint8_t* mac, int8_t rssi, uint32_t now) {
+    int min = 0;
+    for (int i = 0; i < device_used; i++) {
+        if (memcmp(devices[i].mac, mac, 6) == 0) {
+            devices[i].count++;
+            devices[i].rssi = rssi;
+            devices[i].last_ms = now;
+            return;
+        }
+        if (devices[i].count < devices[min].count) min = i;
+    }
+
+    device_slot_t* slot;
+    if (device_used < PROBE_STATS_TOP_DEVICES) {
+        slot = &devices[device_used++];
+        slot->count = 0;
+        slot->error = 0;
+    } else {
+        slot = &devices[min];
+        slot->error = slot->count;
+    }
+    memcpy(slot->mac, mac, 6);
+    slot->rssi = rssi;
+    slot->count++;
+    slot->first_ms = now;
+    slot->last_ms = now;
+}
+
+static void probe_drain(void) {
+    const uint8_t* data;
+    size_t len;
+    uint32_t now = esp_timer_get_time() / 1000;
+
+    while ((len = spsc_ring_peek(&probe_ring, &data)) > 0) {
+        for (size_t off = 0; off + sizeof(probe_record_t) <= len;) {
+            const probe_record_t* rec = (const probe_record_t*)(data + off);
+            const char* ssid = (const char*)(rec + 1);
+
+            portENTER_CRITICAL(&stats_lock);
+            stats.probes++;
+            hll_add(rec->mac);
+            count_device(rec->mac, rec->rssi, now);
+            if (rec->ssid_len == 0) {
+                stats.wildcard++;
+            } else {
+                count_ssid(ssid, rec->ssid_len);
+            }
+            portEXIT_CRITICAL(&stats_lock);
+            off += sizeof(probe_record_t) + rec->ssid_len;
+        }
+        spsc_ring_release(&probe_ring, len);
+    }
+}
+
+static void probe_task_fn(void* arg) {
+    while (!probe_stop) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WORKER_POLL_MS));
+        probe_drain();
+    }
+
+    probe_drain();
+    xSemaphoreGive(probe_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t probe_stats_start(void) {
+    if (probe_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (probe_done == NULL) {
+        probe_done = xSemaphoreCreateBinary();
+        if (probe_done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (spsc_ring_init(&probe_ring, PROBE_STATS_RING_SIZE) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(hll, 0, sizeof(hll));
+    memset(&stats, 0, sizeof(stats));
+    ssid_used = 0;
+    device_used = 0;
+
+    probe_stop = false;
+    if (xTaskCreate(probe_task_fn, "probe_stats", 3072, NULL, 5, &probe_task) != pdPASS) {
+        probe_task = NULL;
+        spsc_ring_deinit(&probe_ring);
+        return ESP_ERR_NO_MEM;
+    }
+    probe_running = true;
+
+    ESP_LOGI(TAG, "Started (%d SSIDs, %d devices, %d HLL registers)",
+             PROBE_STATS_TOP_SSIDS, PROBE_STATS_TOP_DEVICES, HLL_REGISTERS);
+    return ESP_OK;
+}
+
+void probe_stats_stop(void) {
+    if (probe_task == NULL) {
+        return;
+    }
+
+    // Detach the producer before the worker drains and exits
+    portENTER_CRITICAL(&producer_lock);
+    probe_running = false;
+    portEXIT_CRITICAL(&producer_lock);
+    while (producer_busy) {
+        vTaskDelay(1);
+    }
+    probe_stop = true;
+    xTaskNotifyGive(probe_task);
+    xSemaphoreTake(probe_done, portMAX_DELAY);
+    probe_task = NULL;
+
+    stats.dropped = probe_ring.dropped;
+    spsc_ring_deinit(&probe_ring);
+
+    ESP_LOGI(TAG, "Stopped: %lu probes, ~%lu devices, %lu dropped",
+             (unsigned long)stats.probes, (unsigned long)hll_estimate(),
+             (unsigned long)stats.dropped);
+}
+
+static void IRAM_ATTR note_frame(const wifi_promiscuous_pkt_t* pkt) {
+    wifi_frame_t f;
+    wifi_ie_t ie;
+
+    if (!wifi_frame_from_pkt(&f, pkt) ||
+        !wifi_frame_is_mgmt(&f, WIFI_MGMT_PROBE_REQ)) {
+        return;
+    }
+
+    uint8_t ssid_len = 0;
+    if (wifi_frame_find_ie(&f, WIFI_IE_SSID, &ie) && ie.len <= 32) {
+        ssid_len = ie.len;
+    }
+
+    probe_record_t* rec = (probe_record_t*)spsc_ring_reserve(&probe_ring,
+                                                             sizeof(*rec) + ssid_len);
+    if (rec == NULL) {
+        return;
+    }
+    memcpy(rec->mac, f.addr2, 6);
+    rec->rssi = pkt->rx_ctrl.rssi;
+    rec->ssid_len = ssid_len;
+    if (ssid_len) memcpy(rec + 1, ie.data, ssid_len);
+    spsc_ring_commit(&probe_ring, sizeof(*rec) + ssid_len);
+
+    if (spsc_ring_used(&probe_ring) > PROBE_STATS_RING_SIZE / 2) {
+        xTaskNotifyGive(probe_task);
+    }
+}
+
+void IRAM_ATTR probe_stats_note_frame(const wifi_promiscuous_pkt_t* pkt) {
+    portENTER_CRITICAL(&producer_lock);
+    bool running = probe_running;
+    producer_busy = running;
+    portEXIT_CRITICAL(&producer_lock);
+
+    if (running) {
+        note_frame(pkt);
+        producer_busy = false;
+    }
+}
+
+static int compare_ssid_counts(const void* a, const void* b) {
+    const probe_ssid_count_t* x = a;
+    const probe_ssid_count_t* y = b;
+    return (y->count > x->count) - (y->count < x->count);
+}
+
+static int compare_device_counts(const void* a, const void* b) {
+    const probe_device_count_t* x = a;
+    const probe_device_count_t* y = b;
+    return (y->count > x->count) - (y->count < x->count);
+}
+
+size_t probe_stats_top_ssids(probe_ssid_count_t* out, size_t max) {
+    probe_ssid_count_t snapshot[PROBE_STATS_TOP_SSIDS];
+
+    portENTER_CRITICAL(&stats_lock);
+    int n = ssid_used;
+    memcpy(snapshot, ssids, n * sizeof(snapshot[0]));
+    portEXIT_CRITICAL(&stats_lock);
+
+    qsort(snapshot, n, sizeof(snapshot[0]), compare_ssid_counts);
+    if ((size_t)n > max) n = max;
+    memcpy(out, snapshot, n * sizeof(snapshot[0]));
+    return n;
+}
+
+size_t probe_stats_top_devices(probe_device_count_t* out, size_t max) {
+    probe_device_count_t snapshot[PROBE_STATS_TOP_DEVICES];
+
+    portENTER_CRITICAL(&stats_lock);
+    int n = device_used;
+    for (int i = 0; i < n; i++) {
+        const device_slot_t* d = &devices[i];
+        uint32_t span = d->last_ms - d->first_ms;
+        memcpy(snapshot[i].mac, d->mac, 6);
+        snapshot[i].rssi = d->rssi;
+        snapshot[i].count = d->count;
+        snapshot[i].error = d->error;
+        // Under a second of history is too short to extrapolate from
+        snapshot[i].per_minute = span >= 1000 ? (uint64_t)(d->count - d->error) * 60000 / span
+                                              : d->count - d->error;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    qsort(snapshot, n, sizeof(snapshot[0]), compare_device_counts);
+    if ((size_t)n > max) n = max;
+    memcpy(out, snapshot, n * sizeof(snapshot[0]));
+    return n;
+}
+
+void probe_stats_get(probe_stats_t* out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (probe_running) {
+        out->dropped = probe_ring.dropped;
+    }
+    out->distinct = hll_estimate();
+}
@@ -0,0 +1,49 @@
+#ifndef PROBE_STATS_H
+#define PROBE_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Probe-request analytics. The RX callback only copies the source MAC and
+// requested SSID into a lock-free ring; a worker task folds them into
+// fixed-size summaries: space-saving top-K counters for SSIDs and for
+// source MACs, and a HyperLogLog sketch counting distinct (possibly
+// randomized) devices. Memory use does not grow with crowd size.
+
+typedef struct {
+    char ssid[33];
+    uint32_t count;         // estimated probes; overestimates by at most error
+    uint32_t error;
+} probe_ssid_count_t;
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;            // most recent
+    uint32_t count;
+    uint32_t error;
+    uint32_t per_minute;    // probe rate over the time this MAC was tracked
+} probe_device_count_t;
+
+typedef struct {
+    uint32_t probes;        // probe requests aggregated
+    uint32_t wildcard;      // of which carried an empty (broadcast) SSID
+    uint32_t dropped;       // lost because the worker fell behind
+    uint32_t distinct;      // HyperLogLog estimate of distinct source MACs
+} probe_stats_t;
+
+// Resets all summaries and starts the worker
+esp_err_t probe_stats_start(void);
+void probe_stats_stop(void);
+
+// Call from the promiscuous RX callback; ignores anything but probe requests
+void probe_stats_note_frame(const wifi_promiscuous_pkt_t* pkt);
+
+// Heaviest hitters first; return how many entries were written
+size_t probe_stats_top_ssids(probe_ssid_count_t* out, size_t max);
+size_t probe_stats_top_devices(probe_device_count_t* out, size_t max);
+
+void probe_stats_get(probe_stats_t* stats);
+
+#endif // PROBE_STATS_H
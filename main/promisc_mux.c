@@ -0,0 +1,187 @@
+#include "promisc_mux.h"
+#include "channel_hopper.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char* TAG = "PROMISC";
+
+#define DATA_TYPES  (WIFI_PROMIS_FILTER_MASK_DATA | WIFI_PROMIS_FILTER_MASK_DATA_MPDU | \
+                     WIFI_PROMIS_FILTER_MASK_DATA_AMPDU)
+
+typedef struct {
+    promisc_cb_t cb;
+    void* ctx;
+    promisc_filter_t filter;
+} consumer_t;
+
+static consumer_t consumers[PROMISC_MUX_MAX_CONSUMERS];
+static uint32_t active_types = 0;
+static bool promisc_on = false;
+static int holds = 0;
+static portMUX_TYPE mux_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// The driver calls the RX callback from its one task, so dispatches are
+// numbered in order; unsubscribe waits until every dispatch that could
+// have copied the leaving consumer has finished
+static volatile uint32_t dispatch_started = 0;
+static volatile uint32_t dispatch_finished = 0;
+static TaskHandle_t dispatch_task = NULL;
+
+// Serializes consumer changes and driver reprogramming
+static SemaphoreHandle_t config_mutex = NULL;
+static StaticSemaphore_t config_mutex_buf;
+
+static uint32_t IRAM_ATTR type_mask(wifi_promiscuous_pkt_type_t type) {
+    switch (type) {
+        case WIFI_PKT_MGMT: return WIFI_PROMIS_FILTER_MASK_MGMT;
+        case WIFI_PKT_CTRL: return WIFI_PROMIS_FILTER_MASK_CTRL;
+        case WIFI_PKT_DATA: return DATA_TYPES;
+        default:            return WIFI_PROMIS_FILTER_MASK_MISC;
+    }
+}
+
+static void IRAM_ATTR promisc_rx(void* buf, wifi_promiscuous_pkt_type_t type) {
+    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
+    channel_hopper_note_frame(pkt);
+
+    // Snapshot so consumers run without the lock and may unsubscribe
+    consumer_t active[PROMISC_MUX_MAX_CONSUMERS];
+    portENTER_CRITICAL(&mux_lock);
+    memcpy(active, consumers, sizeof(active));
+    uint32_t seq = ++dispatch_started;
+    dispatch_task = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&mux_lock);
+
+    uint32_t mask = type_mask(type);
+    uint16_t subtype = 0;
+    if (type == WIFI_PKT_MGMT && pkt->rx_ctrl.sig_len > 0) {
+        subtype = PROMISC_SUBTYPE((pkt->payload[0] >> 4) & 0x0F);
+    }
+
+    for (int i = 0; i < PROMISC_MUX_MAX_CONSUMERS; i++) {
+        if (active[i].cb == NULL || !(active[i].filter.types & mask)) continue;
+        if (subtype && active[i].filter.mgmt_subtypes && !(active[i].filter.mgmt_subtypes & subtype)) continue;
+        active[i].cb(pkt, type, active[i].ctx);
+    }
+    dispatch_finished = seq;
+}
+
+static void config_lock(void) {
+    portENTER_CRITICAL(&mux_lock);
+    if (config_mutex == NULL) {
+        config_mutex = xSemaphoreCreateMutexStatic(&config_mutex_buf);
+    }
+    portEXIT_CRITICAL(&mux_lock);
+    xSemaphoreTake(config_mutex, portMAX_DELAY);
+}
+
+static void config_unlock(void) {
+    xSemaphoreGive(config_mutex);
+}
+
+// Reprograms the driver after the consumer set or the holds changed; called
+// with the config mutex held
+static void apply_filter(void) {
+    uint32_t types = 0;
+    portENTER_CRITICAL(&mux_lock);
+    for (int i = 0; i < PROMISC_MUX_MAX_CONSUMERS; i++) {
+        if (consumers[i].cb) types |= consumers[i].filter.types;
+    }
+    bool want_on = types != 0 || holds > 0;
+    portEXIT_CRITICAL(&mux_lock);
+
+    if (types == active_types && want_on == promisc_on) return;
+
+    if (!want_on) {
+        esp_wifi_set_promiscuous(false);
+        esp_wifi_set_promiscuous_rx_cb(NULL);
+    } else {
+        // A hold with no consumers keeps the cheapest filter the driver takes
+        wifi_promiscuous_filter_t filter = { .filter_mask = types ? types : WIFI_PROMIS_FILTER_MASK_MGMT };
+        esp_wifi_set_promiscuous_filter(&filter);
+        if (!promisc_on) {
+            esp_wifi_set_promiscuous_rx_cb(promisc_rx);
+            esp_wifi_set_promiscuous(true);
+        }
+    }
+    ESP_LOGD(TAG, "Hardware filter 0x%08lx, %d holds", (unsigned long)types, holds);
+    active_types = types;
+    promisc_on = want_on;
+}
+
+esp_err_t promisc_subscribe(promisc_cb_t cb, const promisc_filter_t* filter, void* ctx) {
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    config_lock();
+    portENTER_CRITICAL(&mux_lock);
+    for (int i = 0; i < PROMISC_MUX_MAX_CONSUMERS; i++) {
+        if (consumers[i].cb == NULL) {
+            if (filter) {
+                consumers[i].filter = *filter;
+            } else {
+                consumers[i].filter.types = WIFI_PROMIS_FILTER_MASK_ALL;
+                consumers[i].filter.mgmt_subtypes = 0;
+            }
+            consumers[i].ctx = ctx;
+            consumers[i].cb = cb;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&mux_lock);
+
+    if (ret == ESP_OK) {
+        apply_filter();
+    } else {
+        ESP_LOGE(TAG, "No free consumer slot");
+    }
+    config_unlock();
+    return ret;
+}
+
+void promisc_unsubscribe(promisc_cb_t cb) {
+    config_lock();
+    portENTER_CRITICAL(&mux_lock);
+    for (int i = 0; i < PROMISC_MUX_MAX_CONSUMERS; i++) {
+        if (consumers[i].cb == cb) {
+            consumers[i].cb = NULL;
+        }
+    }
+    uint32_t last_seq = dispatch_started;
+    portEXIT_CRITICAL(&mux_lock);
+    apply_filter();
+    config_unlock();
+
+    // A consumer leaving from inside its own callback is the dispatch itself
+    if (xTaskGetCurrentTaskHandle() == dispatch_task) return;
+    while ((int32_t)(dispatch_finished - last_seq) < 0) {
+        vTaskDelay(1);
+    }
+}
+
+void promisc_hold(void) {
+    config_lock();
+    portENTER_CRITICAL(&mux_lock);
+    holds++;
+    portEXIT_CRITICAL(&mux_lock);
+    apply_filter();
+    config_unlock();
+}
+
+void promisc_release(void) {
+    config_lock();
+    portENTER_CRITICAL(&mux_lock);
+    if (holds > 0) holds--;
+    portEXIT_CRITICAL(&mux_lock);
+    apply_filter();
+    config_unlock();
+}
+
+uint32_t promisc_active_types(void) {
+    return active_types;
+}
@@ -0,0 +1,43 @@
+#ifndef PROMISC_MUX_H
+#define PROMISC_MUX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Single owner of the promiscuous RX callback. Consumers subscribe with the
+// frame types they want; the union of those types is programmed into the
+// driver's hardware filter so unwanted frames never reach the callback, and
+// each frame is dispatched only to the consumers that asked for it.
+// Promiscuous mode is enabled by the first subscription and disabled when
+// the last consumer leaves.
+#define PROMISC_MUX_MAX_CONSUMERS 6
+
+// Bit per management subtype, e.g. PROMISC_SUBTYPE(WIFI_MGMT_BEACON)
+#define PROMISC_SUBTYPE(s)  (1u << (s))
+
+typedef struct {
+    uint32_t types;             // WIFI_PROMIS_FILTER_MASK_* bits
+    uint16_t mgmt_subtypes;     // PROMISC_SUBTYPE bits; 0 = all management frames
+} promisc_filter_t;
+
+// Called from the Wi-Fi task for each frame matching the consumer's filter
+typedef void (*promisc_cb_t)(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx);
+
+// filter NULL receives every frame type. Once unsubscribe returns the
+// callback is no longer running and will not be called again, so its state
+// can be freed.
+esp_err_t promisc_subscribe(promisc_cb_t cb, const promisc_filter_t* filter, void* ctx);
+void promisc_unsubscribe(promisc_cb_t cb);
+
+// Keeps promiscuous mode on without receiving anything, for features that
+// only inject frames. Holds nest and must be paired; the driver is left to
+// the mux so releasing never cuts off other consumers.
+void promisc_hold(void);
+void promisc_release(void);
+
+// Union currently programmed into the hardware filter, 0 when idle
+uint32_t promisc_active_types(void);
+
+#endif // PROMISC_MUX_H
@@ -1,5 +1,6 @@
 #include "rf_functions.h"
 #include "cc1101_driver.h"
+#include "wifi_functions.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
@@ -7,7 +8,6 @@
 #include "touchscreen.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "esp_random.h"
 
 static const char* TAG = "RF";
 
@@ -82,31 +82,8 @@ void rf_jammer_24ghz(void) {
 }
 
 void rf_scanner_24ghz(void) {
-    display_fill_screen(COLOR_BLACK);
-    display_draw_text(10, 10, "2.4GHz Scanner", COLOR_WHITE, COLOR_BLACK);
-    display_draw_text(10, 30, "Scanning channels", COLOR_GREEN, COLOR_BLACK);
-    
-    // Simulate scanning 2.4GHz channels
-    for (int channel = 1; channel <= 14; channel++) {
-        char ch_info[30];
-        snprintf(ch_info, sizeof(ch_info), "Channel %d: %d MHz", 
-                channel, 2412 + (channel - 1) * 5);
-        
-        display_fill_rect(10, 50, 200, 15, COLOR_BLACK);
-        display_draw_text(10, 50, ch_info, COLOR_WHITE, COLOR_BLACK);
-        
-        // Simulate signal strength
-        int signal = esp_random() % 100;
-        char signal_info[30];
-        snprintf(signal_info, sizeof(signal_info), "Signal: %d dBm", signal - 100);
-        display_fill_rect(10, 70, 200, 15, COLOR_BLACK);
-        display_draw_text(10, 70, signal_info, COLOR_GREEN, COLOR_BLACK);
-        
-        vTaskDelay(pdMS_TO_TICKS(500));
-        if (touchscreen_is_touched()) break;
-    }
-    
-    display_draw_text(10, 280, "Scan complete", COLOR_GREEN, COLOR_BLACK);
+    // The Wi-Fi radio is the 2.4GHz receiver; measure real channel airtime
+    wifi_channel_analyzer();
 }
 
 void rf_replay_attack(void) {
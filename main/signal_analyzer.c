@@ -82,34 +82,39 @@ void signal_analyzer_waterfall(void) {
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "WATERFALL DISPLAY", COLOR_WHITE, COLOR_BLACK);
     
-    // Simplified waterfall with direct drawing
-    for (int scroll = 0; scroll < 100; scroll++) {
-        // Clear previous frame
-        display_fill_rect(0, 30, DISPLAY_WIDTH, 80, COLOR_BLACK);
-        
-        // Draw waterfall lines
-        for (int y = 0; y < 40; y++) {
-            for (int x = 0; x < DISPLAY_WIDTH; x += 4) {
-                uint8_t intensity = (esp_random() + scroll + y + x) % 256;
-                uint16_t color = COLOR_BLACK;
-                
-                if (intensity > 200) color = COLOR_RED;
-                else if (intensity > 150) color = COLOR_ORANGE;
-                else if (intensity > 100) color = COLOR_WHITE;
-                else if (intensity > 50) color = COLOR_GREEN;
-                else if (intensity > 20) color = COLOR_BLUE;
-                
-                if (color != COLOR_BLACK) {
-                    display_draw_pixel(x, 30 + y, color);
-                }
+    // Hardware-scrolled band: each step scrolls by one line and draws only
+    // the new line at the top
+    const int line_height = 2;
+    display_scroll_define(30, 80, line_height);
+    
+    static uint16_t line[DISPLAY_WIDTH * 2];
+    for (int scroll = 0; scroll < 200; scroll++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x += 4) {
+            uint8_t intensity = (esp_random() + scroll + x) % 256;
+            uint16_t color = COLOR_BLACK;
+            
+            if (intensity > 200) color = COLOR_RED;
+            else if (intensity > 150) color = COLOR_ORANGE;
+            else if (intensity > 100) color = COLOR_WHITE;
+            else if (intensity > 50) color = COLOR_GREEN;
+            else if (intensity > 20) color = COLOR_BLUE;
+            
+            for (int i = 0; i < 4; i++) {
+                line[x + i] = color;
+                line[DISPLAY_WIDTH + x + i] = color;
             }
         }
         
-        vTaskDelay(pdMS_TO_TICKS(100));
+        int16_t y = display_scroll_down();
+        if (y < 0) break;
+        display_draw_bitmap(0, y, DISPLAY_WIDTH, line_height, line);
+        
+        vTaskDelay(pdMS_TO_TICKS(50));
         
         if (touchscreen_is_touched()) break;
     }
     
+    display_scroll_reset();
     display_draw_text(10, 280, "Touch to return", COLOR_GRAY, COLOR_BLACK);
     wait_for_touch_with_timeout(5);
 }
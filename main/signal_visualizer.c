@@ -41,7 +41,10 @@ void draw_wifi_heatmap(wifi_ap_record_t* ap_records, uint16_t ap_count) {
         }
     }
     
-    // Draw heatmap
+    draw_wifi_channel_heatmap(channel_count, channel_rssi);
+}
+
+void draw_wifi_channel_heatmap(const int* channel_count, const int* channel_rssi) {
     int bar_width = 220 / 14;
     int max_height = 150;
     
@@ -73,6 +76,46 @@ void draw_wifi_heatmap(wifi_ap_record_t* ap_records, uint16_t ap_count) {
     display_draw_text(10, 35, "WiFi Channel Heatmap", COLOR_WHITE, COLOR_BLACK);
 }
 
+static uint16_t busy_to_color(int busy_permille) {
+    if (busy_permille < 200) return COLOR_GREEN;     // Quiet
+    if (busy_permille < 500) return COLOR_ORANGE;    // Busy
+    return COLOR_RED;                                // Congested
+}
+
+void draw_wifi_channel_utilization(const int* busy_permille, const int* channel_count) {
+    int bar_width = 220 / 14;
+    int max_height = 150;
+    
+    for (int i = 0; i < 14; i++) {
+        int x = 10 + i * bar_width;
+        
+        // Height based on busy time, at least a sliver once anything was heard
+        int height = (busy_permille[i] * max_height) / 1000;
+        if (height == 0 && busy_permille[i] > 0) height = 1;
+        if (height > 0) {
+            display_fill_rect(x, 200 - height, bar_width - 2, height, busy_to_color(busy_permille[i]));
+        }
+        
+        if (channel_count[i] > 0) {
+            char count_str[12];
+            snprintf(count_str, sizeof(count_str), "%d", channel_count[i] > 99 ? 99 : channel_count[i]);
+            int y = 200 - height - 10;
+            display_draw_text(x, y < 52 ? 52 : y, count_str, COLOR_WHITE, COLOR_BLACK);
+        }
+        
+        // Draw channel number
+        if (i % 2 == 0) {
+            char ch_str[4];
+            snprintf(ch_str, sizeof(ch_str), "%d", i + 1);
+            display_draw_text(x, 205, ch_str, COLOR_WHITE, COLOR_BLACK);
+        }
+    }
+    
+    // Draw axis
+    display_draw_rect(10, 50, 220, 150, COLOR_WHITE);
+    display_draw_text(10, 35, "Channel Utilization", COLOR_WHITE, COLOR_BLACK);
+}
+
 void draw_ble_rssi_bars(int8_t* rssi_values, uint16_t device_count, int start_y) {
     for (int i = 0; i < device_count && i < 8; i++) {
         int y = start_y + i * 20;
@@ -7,6 +7,13 @@
 // Draw WiFi channel heatmap
 void draw_wifi_heatmap(wifi_ap_record_t* ap_records, uint16_t ap_count);
 
+// Draw the heatmap from per-channel AP counts and strongest RSSI (14 entries each)
+void draw_wifi_channel_heatmap(const int* channel_count, const int* channel_rssi);
+
+// Same frame with bars for channel busy time (per-mille) and each channel's AP
+// count printed above its bar (14 entries each)
+void draw_wifi_channel_utilization(const int* busy_permille, const int* channel_count);
+
 // Draw BLE RSSI bars for devices
 void draw_ble_rssi_bars(int8_t* rssi_values, uint16_t device_count, int start_y);
 
@@ -0,0 +1,125 @@
+#include "spsc_ring.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include <string.h>
+
+// head is only written by the producer and tail only by the consumer. Each
+// side publishes its index with release ordering after touching the data and
+// reads the other side's index with acquire ordering, which on the ESP32 also
+// inserts the barrier needed between cores.
+#define LOAD_ACQ(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+esp_err_t spsc_ring_init(spsc_ring_t* ring, size_t size) {
+    memset(ring, 0, sizeof(*ring));
+    ring->buf = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (ring->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ring->size = size;
+    ring->wrap = size;
+    return ESP_OK;
+}
+
+void spsc_ring_deinit(spsc_ring_t* ring) {
+    heap_caps_free(ring->buf);
+    memset(ring, 0, sizeof(*ring));
+}
+
+static size_t ring_used(const spsc_ring_t* ring, size_t head, size_t tail) {
+    if (head >= tail) return head - tail;
+    return (LOAD_ACQ(&ring->wrap) - tail) + head;
+}
+
+size_t spsc_ring_used(const spsc_ring_t* ring) {
+    return ring_used(ring, LOAD_ACQ(&ring->head), LOAD_ACQ(&ring->tail));
+}
+
+uint8_t* IRAM_ATTR spsc_ring_reserve(spsc_ring_t* ring, size_t len) {
+    size_t head = ring->head;
+    size_t tail = LOAD_ACQ(&ring->tail);
+
+    // One byte always stays free so head == tail means empty
+    if (head >= tail) {
+        if (ring->size - head > len || (ring->size - head == len && tail > 0)) {
+            ring->reserved_at = head;
+            ring->reserved_wrap = 0;
+            goto reserved;
+        }
+        if (tail > len) {
+            // Skip the unusable tail end of the buffer and start over at 0
+            ring->reserved_at = 0;
+            ring->reserved_wrap = head;
+            goto reserved;
+        }
+    } else if (tail - head > len) {
+        ring->reserved_at = head;
+        ring->reserved_wrap = 0;
+        goto reserved;
+    }
+
+    ring->dropped++;
+    if (!ring->overflowing) {
+        ring->overflowing = true;
+        ring->overflows++;
+    }
+    return NULL;
+
+reserved:
+    ring->overflowing = false;
+    return ring->buf + ring->reserved_at;
+}
+
+void IRAM_ATTR spsc_ring_commit(spsc_ring_t* ring, size_t len) {
+    size_t tail = LOAD_ACQ(&ring->tail);
+    size_t head = ring->reserved_at + len;
+
+    if (ring->reserved_wrap) {
+        ring->wrap = ring->reserved_wrap;
+    } else if (head == ring->size) {
+        ring->wrap = ring->size;
+        head = 0;
+    }
+
+    size_t used = ring_used(ring, head, tail);
+    if (used > ring->high_water) ring->high_water = used;
+
+    STORE_REL(&ring->head, head);
+}
+
+bool IRAM_ATTR spsc_ring_push(spsc_ring_t* ring, const void* data, size_t len) {
+    uint8_t* slot = spsc_ring_reserve(ring, len);
+    if (slot == NULL) return false;
+    memcpy(slot, data, len);
+    spsc_ring_commit(ring, len);
+    return true;
+}
+
+size_t spsc_ring_peek(spsc_ring_t* ring, const uint8_t** data) {
+    size_t head = LOAD_ACQ(&ring->head);
+    size_t tail = ring->tail;
+
+    if (tail == head) return 0;
+
+    if (tail > head) {
+        // The producer wrapped; everything up to the wrap point comes first
+        size_t end = ring->wrap;
+        if (tail == end) {
+            tail = 0;
+            STORE_REL(&ring->tail, 0);
+            if (head == 0) return 0;
+        } else {
+            *data = ring->buf + tail;
+            return end - tail;
+        }
+    }
+
+    *data = ring->buf + tail;
+    return head - tail;
+}
+
+// Reaching the wrap point is resolved by the next peek, which is the only
+// place that can tell a wrapped producer from a stale wrap value
+void spsc_ring_release(spsc_ring_t* ring, size_t len) {
+    STORE_REL(&ring->tail, ring->tail + len);
+}
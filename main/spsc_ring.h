@@ -0,0 +1,45 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Lock-free single-producer/single-consumer byte ring for variable-length
+// records. The producer (typically a radio callback) reserves a contiguous
+// slot, fills it in place and commits it; the consumer (a writer task) peeks
+// contiguous runs of committed records and releases them. Records never
+// straddle the end of the buffer, so a peeked run can be written out as-is.
+typedef struct {
+    uint8_t* buf;
+    size_t size;
+    size_t head;            // next write offset, published by the producer
+    size_t tail;            // next read offset, published by the consumer
+    size_t wrap;            // end of valid data when the producer wrapped
+    size_t reserved_at;     // producer-private: offset of the open reservation
+    size_t reserved_wrap;   // producer-private: wrap point for that reservation
+    uint32_t dropped;       // records rejected because the ring was full
+    uint32_t overflows;     // distinct full episodes
+    size_t high_water;      // most bytes ever queued
+    bool overflowing;
+} spsc_ring_t;
+
+// Allocates the ring storage once, up front
+esp_err_t spsc_ring_init(spsc_ring_t* ring, size_t size);
+void spsc_ring_deinit(spsc_ring_t* ring);
+
+// Producer side. reserve returns NULL (and counts a drop) if len bytes do
+// not fit; otherwise the slot must be committed before the next reserve.
+uint8_t* spsc_ring_reserve(spsc_ring_t* ring, size_t len);
+void spsc_ring_commit(spsc_ring_t* ring, size_t len);
+bool spsc_ring_push(spsc_ring_t* ring, const void* data, size_t len);
+
+// Consumer side: peek the next contiguous run of committed bytes (0 if
+// empty), then release however much of it was consumed
+size_t spsc_ring_peek(spsc_ring_t* ring, const uint8_t** data);
+void spsc_ring_release(spsc_ring_t* ring, size_t len);
+
+size_t spsc_ring_used(const spsc_ring_t* ring);
+
+#endif // SPSC_RING_H
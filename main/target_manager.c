@@ -4,6 +4,7 @@
 #include "display.h"
 #include "touchscreen.h"
 #include "esp_log.h"
+#include "device_table.h"
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
@@ -123,6 +124,15 @@ void target_manager_quick_save_ble(const uint8_t* mac, const char* name, int8_t
     target_manager_save(TARGET_BLE, name, mac, rssi, 0);
 }
 
+void target_manager_quick_save_device(uint16_t device_id) {
+    device_info_t info;
+    if (!device_table_get(device_id, &info)) {
+        return;
+    }
+    target_manager_save(info.kind == DEVICE_KIND_BLE ? TARGET_BLE : TARGET_WIFI,
+                        info.name, info.mac, info.rssi, info.channel);
+}
+
 void target_manager_ui(void) {
     int scroll_offset = 0;
     bool running = true;
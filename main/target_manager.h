@@ -54,4 +54,7 @@ void target_manager_ui(void);
 void target_manager_quick_save_wifi(wifi_ap_record_t* ap);
 void target_manager_quick_save_ble(const uint8_t* mac, const char* name, int8_t rssi);
 
+// Quick save a device table entry (AP, station or BLE device)
+void target_manager_quick_save_device(uint16_t device_id);
+
 #endif // TARGET_MANAGER_H
@@ -88,6 +88,27 @@ void ui_terminal_text(int x, int y, const char* text, uint16_t color, uint16_t d
     }
 }
 
+// Scrolling log region: new lines enter at the bottom and the region is
+// moved up with hardware scrolling, so only the new line is drawn
+#define UI_LOG_LINE_HEIGHT 10
+
+void ui_log_begin(int y, int lines) {
+    display_fill_rect(0, y, DISPLAY_WIDTH, lines * UI_LOG_LINE_HEIGHT, COLOR_BLACK);
+    display_scroll_define(y, lines * UI_LOG_LINE_HEIGHT, UI_LOG_LINE_HEIGHT);
+}
+
+void ui_log_line(const char* text, uint16_t color) {
+    int16_t y = display_scroll_up();
+    if (y < 0) return;
+    
+    display_fill_rect(0, y, DISPLAY_WIDTH, UI_LOG_LINE_HEIGHT, COLOR_BLACK);
+    display_draw_text(10, y + 1, text, color, COLOR_BLACK);
+}
+
+void ui_log_end(void) {
+    display_scroll_reset();
+}
+
 void ui_hex_stream(int x, int y, int width, int height) {
     display_draw_text(x, y, "HEX STREAM", COLOR_GREEN, COLOR_BLACK);
 }
\ No newline at end of file
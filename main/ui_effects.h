@@ -22,6 +22,11 @@ void ui_scan_lines(void);
 // Terminal-style text with typing effect
 void ui_terminal_text(int x, int y, const char* text, uint16_t color, uint16_t delay_ms);
 
+// Scrolling log view of `lines` text rows starting at y
+void ui_log_begin(int y, int lines);
+void ui_log_line(const char* text, uint16_t color);
+void ui_log_end(void);
+
 // Hexadecimal data stream
 void ui_hex_stream(int x, int y, int width, int height);
 
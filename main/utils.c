@@ -63,7 +63,7 @@ void log_system_stats(void) {
     size_t free_heap = esp_get_free_heap_size();
     size_t min_free_heap = esp_get_minimum_free_heap_size();
     
-    ESP_LOGI(TAG, "Free heap: %d bytes, Min free: %d bytes", free_heap, min_free_heap);
+    ESP_LOGI(TAG, "Free heap: %u bytes, Min free: %u bytes", (unsigned)free_heap, (unsigned)min_free_heap);
 }
 
 void enter_safe_mode(void) {
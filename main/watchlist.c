@@ -0,0 +1,321 @@
+#include "watchlist.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static const char* TAG = "WATCHLIST";
+
+#define NONE            0xFFFF
+#define ADDR_MASK       0xFFFFFFFFFFFFull
+#define MAX_LENGTHS     8
+
+// Entries and the index are only ever replaced wholesale, so a single writer
+// can build a grown copy outside the lock and readers just see the swap
+static uint64_t* keys = NULL;          // prefix in bits 0..47, length in 48..55
+static uint16_t* desc_ids = NULL;
+static uint16_t* index_slots = NULL;
+static uint32_t entry_capacity = 0;
+static uint32_t slot_mask = 0;
+static uint32_t entry_count = 0;
+
+static char (*descs)[WATCHLIST_DESC_LEN] = NULL;
+static uint32_t desc_capacity = 0;
+static uint32_t desc_count = 0;
+
+// Distinct prefix lengths in use, longest first
+static uint8_t lengths[MAX_LENGTHS];
+static int length_count = 0;
+
+static portMUX_TYPE watch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void* alloc_table(size_t bytes) {
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (p == NULL) {
+        p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return p;
+}
+
+static uint32_t key_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static uint64_t make_key(uint64_t addr, uint8_t bits) {
+    uint64_t mask = ADDR_MASK & ~((1ull << (48 - bits)) - 1);
+    return (addr & mask) | ((uint64_t)bits << 48);
+}
+
+static uint32_t find_slot(const uint16_t* slots, uint32_t mask, uint64_t key) {
+    uint32_t i = key_hash(key) & mask;
+    while (slots[i] != NONE && keys[slots[i]] != key) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static esp_err_t grow_entries(void) {
+    if (entry_capacity >= WATCHLIST_MAX_ENTRIES) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t capacity = entry_capacity ? entry_capacity * 2 : 64;
+    if (capacity > WATCHLIST_MAX_ENTRIES) capacity = WATCHLIST_MAX_ENTRIES;
+    uint32_t slots = 1;
+    while (slots < capacity * 2) slots <<= 1;
+
+    uint64_t* new_keys = alloc_table(capacity * sizeof(uint64_t));
+    uint16_t* new_descs = alloc_table(capacity * sizeof(uint16_t));
+    uint16_t* new_index = alloc_table(slots * sizeof(uint16_t));
+    if (!new_keys || !new_descs || !new_index) {
+        heap_caps_free(new_keys);
+        heap_caps_free(new_descs);
+        heap_caps_free(new_index);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (entry_count) {
+        memcpy(new_keys, keys, entry_count * sizeof(uint64_t));
+        memcpy(new_descs, desc_ids, entry_count * sizeof(uint16_t));
+    }
+    memset(new_index, 0xFF, slots * sizeof(uint16_t));
+    for (uint32_t e = 0; e < entry_count; e++) {
+        uint32_t i = key_hash(new_keys[e]) & (slots - 1);
+        while (new_index[i] != NONE) i = (i + 1) & (slots - 1);
+        new_index[i] = e;
+    }
+
+    uint64_t* old_keys = keys;
+    uint16_t* old_descs = desc_ids;
+    uint16_t* old_index = index_slots;
+    portENTER_CRITICAL(&watch_lock);
+    keys = new_keys;
+    desc_ids = new_descs;
+    index_slots = new_index;
+    slot_mask = slots - 1;
+    entry_capacity = capacity;
+    portEXIT_CRITICAL(&watch_lock);
+
+    heap_caps_free(old_keys);
+    heap_caps_free(old_descs);
+    heap_caps_free(old_index);
+    return ESP_OK;
+}
+
+// Consecutive entries usually share a description, so only the newest
+// one is checked for reuse
+static int intern_desc(const char* desc) {
+    if (desc_count > 0 && strncmp(descs[desc_count - 1], desc, WATCHLIST_DESC_LEN - 1) == 0) {
+        return desc_count - 1;
+    }
+
+    if (desc_count == desc_capacity) {
+        uint32_t capacity = desc_capacity ? desc_capacity * 2 : 16;
+        if (capacity > WATCHLIST_MAX_ENTRIES) capacity = WATCHLIST_MAX_ENTRIES;
+        if (capacity == desc_capacity) {
+            return -1;
+        }
+        char (*grown)[WATCHLIST_DESC_LEN] = alloc_table(capacity * WATCHLIST_DESC_LEN);
+        if (grown == NULL) {
+            return -1;
+        }
+        if (desc_count) memcpy(grown, descs, desc_count * WATCHLIST_DESC_LEN);
+
+        void* old = descs;
+        portENTER_CRITICAL(&watch_lock);
+        descs = grown;
+        desc_capacity = capacity;
+        portEXIT_CRITICAL(&watch_lock);
+        heap_caps_free(old);
+    }
+
+    // Not yet referenced by any entry, so no lock is needed to fill it
+    strncpy(descs[desc_count], desc, WATCHLIST_DESC_LEN - 1);
+    descs[desc_count][WATCHLIST_DESC_LEN - 1] = '\0';
+    return desc_count++;
+}
+
+static esp_err_t add_key(uint64_t addr, uint8_t bits, const char* desc) {
+    if (bits < 8 || bits > 48) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Each distinct length costs one probe per match, so their number is capped
+    int pos = 0;
+    while (pos < length_count && lengths[pos] > bits) pos++;
+    bool new_length = pos == length_count || lengths[pos] != bits;
+    if (new_length && length_count == MAX_LENGTHS) {
+        ESP_LOGE(TAG, "Too many prefix lengths for /%d", bits);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (entry_count == entry_capacity && grow_entries() != ESP_OK) {
+        ESP_LOGE(TAG, "Watchlist full at %lu entries", (unsigned long)entry_count);
+        return ESP_ERR_NO_MEM;
+    }
+    int desc_id = intern_desc(desc);
+    if (desc_id < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint64_t key = make_key(addr, bits);
+    portENTER_CRITICAL(&watch_lock);
+    uint32_t slot = find_slot(index_slots, slot_mask, key);
+    if (index_slots[slot] != NONE) {
+        desc_ids[index_slots[slot]] = desc_id;
+    } else {
+        keys[entry_count] = key;
+        desc_ids[entry_count] = desc_id;
+        index_slots[slot] = entry_count++;
+    }
+    if (new_length) {
+        memmove(&lengths[pos + 1], &lengths[pos], length_count - pos);
+        lengths[pos] = bits;
+        length_count++;
+    }
+    portEXIT_CRITICAL(&watch_lock);
+    return ESP_OK;
+}
+
+esp_err_t watchlist_add(const uint8_t* addr, uint8_t bits, const char* desc) {
+    uint64_t a = 0;
+    for (int i = 0; i < 6; i++) {
+        a = (a << 8) | (i * 8 < bits ? addr[i] : 0);
+    }
+    return add_key(a, bits, desc);
+}
+
+static bool parse_spec(const char* spec, uint64_t* addr, uint8_t* bits) {
+    uint64_t value = 0;
+    int nibbles = 0;
+    const char* p = spec;
+
+    for (; *p && *p != '/' && !isspace((unsigned char)*p); p++) {
+        if (*p == ':' || *p == '-' || *p == '.') continue;
+        if (!isxdigit((unsigned char)*p) || nibbles == 12) return false;
+        value = (value << 4) | (isdigit((unsigned char)*p) ? *p - '0' : (tolower((unsigned char)*p) - 'a' + 10));
+        nibbles++;
+    }
+    if (nibbles < 2) {
+        return false;
+    }
+
+    *bits = nibbles * 4;
+    if (*p == '/') {
+        char* end;
+        long n = strtol(p + 1, &end, 10);
+        if (end == p + 1 || n < 8 || n > nibbles * 4) return false;
+        *bits = n;
+    }
+    *addr = value << (48 - nibbles * 4);
+    return true;
+}
+
+esp_err_t watchlist_add_str(const char* spec, const char* desc) {
+    uint64_t addr;
+    uint8_t bits;
+    if (!parse_spec(spec, &addr, &bits)) {
+        ESP_LOGW(TAG, "Bad address '%s'", spec);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_key(addr, bits, desc);
+}
+
+int watchlist_load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char line[128];
+    int added = 0, bad = 0;
+    bool full = false;
+    while (fgets(line, sizeof(line), f)) {
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        char* spec = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        if (*p) *p++ = '\0';
+        while (isspace((unsigned char)*p)) p++;
+        char* end = p + strlen(p);
+        while (end > p && isspace((unsigned char)end[-1])) *--end = '\0';
+
+        uint64_t addr;
+        uint8_t bits;
+        if (!parse_spec(spec, &addr, &bits)) {
+            bad++;
+            continue;
+        }
+        // Only running out of memory ends the load; a line the table
+        // rejects (such as one prefix length too many) is just a bad line
+        esp_err_t ret = add_key(addr, bits, *p ? p : spec);
+        if (ret == ESP_ERR_NO_MEM) {
+            full = true;
+            break;
+        }
+        if (ret != ESP_OK) {
+            bad++;
+            continue;
+        }
+        added++;
+    }
+    fclose(f);
+
+    ESP_LOGI(TAG, "Loaded %d entries from %s (%d bad lines%s)", added, path, bad,
+             full ? ", stopped: out of memory" : "");
+    return added;
+}
+
+bool watchlist_match(const uint8_t* mac, char* desc, size_t desc_len) {
+    uint64_t addr = 0;
+    for (int i = 0; i < 6; i++) addr = (addr << 8) | mac[i];
+
+    bool found = false;
+    portENTER_CRITICAL(&watch_lock);
+    for (int l = 0; l < length_count && !found; l++) {
+        uint32_t slot = find_slot(index_slots, slot_mask, make_key(addr, lengths[l]));
+        if (index_slots[slot] != NONE) {
+            found = true;
+            if (desc && desc_len) {
+                strncpy(desc, descs[desc_ids[index_slots[slot]]], desc_len - 1);
+                desc[desc_len - 1] = '\0';
+            }
+        }
+    }
+    portEXIT_CRITICAL(&watch_lock);
+    return found;
+}
+
+size_t watchlist_count(void) {
+    return entry_count;
+}
+
+void watchlist_clear(void) {
+    portENTER_CRITICAL(&watch_lock);
+    uint64_t* old_keys = keys;
+    uint16_t* old_descs = desc_ids;
+    uint16_t* old_index = index_slots;
+    void* old_text = descs;
+    keys = NULL;
+    desc_ids = NULL;
+    index_slots = NULL;
+    descs = NULL;
+    entry_capacity = desc_capacity = 0;
+    entry_count = desc_count = 0;
+    slot_mask = 0;
+    length_count = 0;
+    portEXIT_CRITICAL(&watch_lock);
+
+    heap_caps_free(old_keys);
+    heap_caps_free(old_descs);
+    heap_caps_free(old_index);
+    heap_caps_free(old_text);
+}
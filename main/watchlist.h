@@ -0,0 +1,34 @@
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// MAC watchlist with prefix entries: OUI (/24), MA-M (/28), MA-S (/36),
+// full addresses (/48) or any other length from 8 to 48 bits. Entries are
+// 48-bit binary keys in an open-addressing hash keyed by (prefix, length);
+// a match probes once per distinct prefix length in use, longest first,
+// so its cost does not grow with the number of entries.
+#define WATCHLIST_DESC_LEN      32
+#define WATCHLIST_MAX_ENTRIES   65534
+
+// Adds or replaces an entry; bits is the prefix length
+esp_err_t watchlist_add(const uint8_t* addr, uint8_t bits, const char* desc);
+
+// Parses "aa:bb:cc", "aabbccd" (28 bits), "aa-bb-cc-dd-ee-ff" or an explicit
+// "aa:bb:cc:dd/30"; separators ':', '-' and '.' are optional
+esp_err_t watchlist_add_str(const char* spec, const char* desc);
+
+// Loads "<address> <description>" lines; '#' starts a comment. Returns the
+// number of entries added, or -1 if the file cannot be read.
+int watchlist_load(const char* path);
+
+// Longest matching entry; desc (optional) receives its description
+bool watchlist_match(const uint8_t* mac, char* desc, size_t desc_len);
+
+size_t watchlist_count(void);
+void watchlist_clear(void);
+
+#endif // WATCHLIST_H
@@ -1,5 +1,8 @@
 #include "wifi_attacks_enhanced.h"
 #include "wifi_functions.h"
+#include "wifi_scanner.h"
+#include "device_table.h"
+#include "promisc_mux.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -163,7 +166,7 @@ void wifi_beacon_spam_enhanced(void) {
     };
     
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_NULL));
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
+    promisc_hold();
     
     // Beacon frame template
     uint8_t beacon_frame[] = {
@@ -222,7 +225,7 @@ void wifi_beacon_spam_enhanced(void) {
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    esp_wifi_set_promiscuous(false);
+    promisc_release();
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     
     display_draw_text(10, 120, "Enhanced spam complete!", COLOR_GREEN, COLOR_BLACK);
@@ -245,63 +248,59 @@ void wifi_pineapple_detector(void) {
         {0x02, 0x00, 0x00}  // Locally administered
     };
     
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = true
-    };
-    
-    ESP_ERROR_CHECK(esp_wifi_scan_start(&scan_config, true));
-    
-    uint16_t ap_count = 0;
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
+    // Reuse a recent sweep from any feature rather than scanning again
+    esp_err_t ret = wifi_scanner_refresh(WIFI_SCAN_REUSE_MS, WIFI_SCAN_WAIT_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No fresh scan: %s", esp_err_to_name(ret));
+    }
     
-    if (ap_count > 0) {
-        wifi_ap_record_t *ap_records = malloc(sizeof(wifi_ap_record_t) * ap_count);
-        if (ap_records) {
-            ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&ap_count, ap_records));
+    uint16_t capacity = device_table_capacity();
+    uint16_t* ap_ids = capacity ? malloc(capacity * sizeof(uint16_t)) : NULL;
+    if (ap_ids) {
+        size_t ap_count = device_table_query(DEVICE_KIND_WIFI_AP, 0, device_table_now_ms() - WIFI_SCAN_REUSE_MS,
+                                             DEVICE_ORDER_RSSI, ap_ids, capacity);
+        
+        int suspicious_count = 0;
+        int y_pos = 60;
+        device_info_t ap;
+        
+        for (int i = 0; i < ap_count && y_pos < 250; i++) {
+            if (!device_table_get(ap_ids[i], &ap)) continue;
+            bool is_suspicious = false;
             
-            int suspicious_count = 0;
-            int y_pos = 60;
+            // Check for suspicious OUIs
+            for (int j = 0; j < 3; j++) {
+                if (memcmp(ap.mac, suspicious_ouis[j], 3) == 0) {
+                    is_suspicious = true;
+                    break;
+                }
+            }
             
-            for (int i = 0; i < ap_count && y_pos < 250; i++) {
-                bool is_suspicious = false;
-                
-                // Check for suspicious OUIs
-                for (int j = 0; j < 3; j++) {
-                    if (memcmp(ap_records[i].bssid, suspicious_ouis[j], 3) == 0) {
+            // Check for suspicious SSIDs
+            if (!is_suspicious) {
+                const char* suspicious_ssids[] = {"Pineapple", "Free WiFi", "attwifi", "xfinitywifi"};
+                for (int j = 0; j < 4; j++) {
+                    if (strstr(ap.name, suspicious_ssids[j]) != NULL) {
                         is_suspicious = true;
                         break;
                     }
                 }
-                
-                // Check for suspicious SSIDs
-                if (!is_suspicious) {
-                    const char* suspicious_ssids[] = {"Pineapple", "Free WiFi", "attwifi", "xfinitywifi"};
-                    for (int j = 0; j < 4; j++) {
-                        if (strstr((char*)ap_records[i].ssid, suspicious_ssids[j]) != NULL) {
-                            is_suspicious = true;
-                            break;
-                        }
-                    }
-                }
-                
-                if (is_suspicious) {
-                    suspicious_count++;
-                    char ap_info[64];
-                    snprintf(ap_info, sizeof(ap_info), "SUSP: %.20s", (char*)ap_records[i].ssid);
-                    display_draw_text(10, y_pos, ap_info, COLOR_RED, COLOR_BLACK);
-                    y_pos += 15;
-                }
             }
             
-            char result[48];
-            snprintf(result, sizeof(result), "Found %d suspicious APs", suspicious_count);
-            display_draw_text(10, 220, result, suspicious_count > 0 ? COLOR_RED : COLOR_GREEN, COLOR_BLACK);
-            
-            free(ap_records);
+            if (is_suspicious) {
+                suspicious_count++;
+                char ap_info[64];
+                snprintf(ap_info, sizeof(ap_info), "SUSP: %.20s", ap.name);
+                display_draw_text(10, y_pos, ap_info, COLOR_RED, COLOR_BLACK);
+                y_pos += 15;
+            }
         }
+        
+        char result[48];
+        snprintf(result, sizeof(result), "Found %d suspicious APs", suspicious_count);
+        display_draw_text(10, 220, result, suspicious_count > 0 ? COLOR_RED : COLOR_GREEN, COLOR_BLACK);
+        
+        free(ap_ids);
     }
     
     wait_for_back_button();
@@ -328,7 +327,7 @@ void wifi_rickroll_attack(void) {
     };
     
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_NULL));
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
+    promisc_hold();
     
     uint8_t beacon_frame[] = {
         0x80, 0x00, 0x00, 0x00,
@@ -375,7 +374,7 @@ void wifi_rickroll_attack(void) {
         }
     }
     
-    esp_wifi_set_promiscuous(false);
+    promisc_release();
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     
     display_draw_text(10, 120, "You've been rickrolled!", COLOR_GREEN, COLOR_BLACK);
@@ -0,0 +1,226 @@
+#ifndef WIFI_FRAME_H
+#define WIFI_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_wifi_types.h"
+
+// Zero-copy 802.11 frame parser. wifi_frame_parse decodes the frame control
+// and header in place and records pointers into the caller's buffer; nothing
+// is copied and every access is bounds-checked against the received length,
+// so a truncated or corrupt frame fails the parse instead of being read past.
+// Everything is inline so RX callbacks pay only for the fields they use.
+
+#define WIFI_FRAME_TYPE_MGMT    0
+#define WIFI_FRAME_TYPE_CTRL    1
+#define WIFI_FRAME_TYPE_DATA    2
+
+// Management subtypes
+#define WIFI_MGMT_ASSOC_REQ     0x0
+#define WIFI_MGMT_ASSOC_RESP    0x1
+#define WIFI_MGMT_REASSOC_REQ   0x2
+#define WIFI_MGMT_REASSOC_RESP  0x3
+#define WIFI_MGMT_PROBE_REQ     0x4
+#define WIFI_MGMT_PROBE_RESP    0x5
+#define WIFI_MGMT_BEACON        0x8
+#define WIFI_MGMT_DISASSOC      0xA
+#define WIFI_MGMT_AUTH          0xB
+#define WIFI_MGMT_DEAUTH        0xC
+#define WIFI_MGMT_ACTION        0xD
+
+// Frame control flags (second byte)
+#define WIFI_FC_TO_DS           0x01
+#define WIFI_FC_FROM_DS         0x02
+#define WIFI_FC_PROTECTED       0x40
+#define WIFI_FC_ORDER           0x80
+
+// Information element IDs
+#define WIFI_IE_SSID            0
+#define WIFI_IE_DS_PARAMS       3
+#define WIFI_IE_HT_CAP          45
+#define WIFI_IE_RSN             48
+#define WIFI_IE_VHT_CAP         191
+#define WIFI_IE_VENDOR          221
+
+typedef struct {
+    const uint8_t* data;        // start of the MAC header
+    uint16_t len;               // frame length without FCS
+    uint8_t type;
+    uint8_t subtype;
+    uint8_t flags;              // frame control byte 1
+    uint16_t hdr_len;
+    const uint8_t* addr1;       // NULL when the frame type has no such field
+    const uint8_t* addr2;
+    const uint8_t* addr3;
+    const uint8_t* addr4;
+    const uint8_t* qos;         // QoS control (data frames with the QoS bit)
+    const uint8_t* htc;         // HT control (QoS data / mgmt with Order set)
+    const uint8_t* body;
+    uint16_t body_len;
+} wifi_frame_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t len;
+    const uint8_t* data;
+} wifi_ie_t;
+
+typedef struct {
+    const uint8_t* pos;
+    const uint8_t* end;
+} wifi_ie_iter_t;
+
+static inline bool wifi_frame_parse(wifi_frame_t* f, const uint8_t* data, size_t len) {
+    memset(f, 0, sizeof(*f));
+    if (len < 10 || len > 0xFFFF) {
+        return false;
+    }
+
+    f->data = data;
+    f->len = len;
+    f->type = (data[0] >> 2) & 0x03;
+    f->subtype = data[0] >> 4;
+    f->flags = data[1];
+    f->addr1 = &data[4];
+
+    size_t hdr;
+    if (f->type == WIFI_FRAME_TYPE_CTRL) {
+        // ACK and CTS carry only the receiver address
+        hdr = (f->subtype == 0xC || f->subtype == 0xD) ? 10 : 16;
+        if (hdr == 16 && len >= 16) f->addr2 = &data[10];
+    } else {
+        hdr = 24;
+        if (len < hdr) return false;
+        f->addr2 = &data[10];
+        f->addr3 = &data[16];
+        if (f->type == WIFI_FRAME_TYPE_DATA) {
+            if ((f->flags & (WIFI_FC_TO_DS | WIFI_FC_FROM_DS)) == (WIFI_FC_TO_DS | WIFI_FC_FROM_DS)) {
+                f->addr4 = &data[hdr];
+                hdr += 6;
+            }
+            if (f->subtype & 0x8) {
+                f->qos = &data[hdr];
+                hdr += 2;
+                if (f->flags & WIFI_FC_ORDER) {
+                    f->htc = &data[hdr];
+                    hdr += 4;
+                }
+            }
+        } else if (f->type == WIFI_FRAME_TYPE_MGMT && (f->flags & WIFI_FC_ORDER)) {
+            f->htc = &data[hdr];
+            hdr += 4;
+        }
+    }
+    if (len < hdr) {
+        return false;
+    }
+
+    f->hdr_len = hdr;
+    f->body = data + hdr;
+    f->body_len = len - hdr;
+    return true;
+}
+
+// Parses a promiscuous-mode buffer; the ESP32 includes the 4-byte FCS
+static inline bool wifi_frame_from_pkt(wifi_frame_t* f, const wifi_promiscuous_pkt_t* pkt) {
+    size_t len = pkt->rx_ctrl.sig_len;
+    return len >= 4 && wifi_frame_parse(f, pkt->payload, len - 4);
+}
+
+static inline bool wifi_frame_is_mgmt(const wifi_frame_t* f, uint8_t subtype) {
+    return f->type == WIFI_FRAME_TYPE_MGMT && f->subtype == subtype;
+}
+
+// BSSID per the To/From DS bits; NULL for control and WDS frames
+static inline const uint8_t* wifi_frame_bssid(const wifi_frame_t* f) {
+    switch (f->type == WIFI_FRAME_TYPE_CTRL ? 0xFF : f->flags & (WIFI_FC_TO_DS | WIFI_FC_FROM_DS)) {
+    case 0:                 return f->addr3;
+    case WIFI_FC_TO_DS:     return f->addr1;
+    case WIFI_FC_FROM_DS:   return f->addr2;
+    default:                return NULL;
+    }
+}
+
+// Size of the fixed fields that precede the IEs in a management body
+static inline size_t wifi_mgmt_fixed_len(uint8_t subtype) {
+    switch (subtype) {
+    case WIFI_MGMT_BEACON:
+    case WIFI_MGMT_PROBE_RESP:      return 12;
+    case WIFI_MGMT_ASSOC_REQ:       return 4;
+    case WIFI_MGMT_REASSOC_REQ:     return 10;
+    case WIFI_MGMT_ASSOC_RESP:
+    case WIFI_MGMT_REASSOC_RESP:
+    case WIFI_MGMT_AUTH:            return 6;
+    case WIFI_MGMT_PROBE_REQ:       return 0;
+    default:                        return SIZE_MAX;    // no IEs to walk
+    }
+}
+
+// Starts an IE walk over a management frame; false if it carries none
+static inline bool wifi_frame_ies(const wifi_frame_t* f, wifi_ie_iter_t* it) {
+    size_t fixed = f->type == WIFI_FRAME_TYPE_MGMT ? wifi_mgmt_fixed_len(f->subtype) : SIZE_MAX;
+    if (fixed > f->body_len || (f->flags & WIFI_FC_PROTECTED)) {
+        it->pos = it->end = NULL;
+        return false;
+    }
+    it->pos = f->body + fixed;
+    it->end = f->body + f->body_len;
+    return true;
+}
+
+// Yields the next element; stops at the end or at an element that would
+// run past the frame
+static inline bool wifi_ie_next(wifi_ie_iter_t* it, wifi_ie_t* ie) {
+    if (it->pos == NULL || it->end - it->pos < 2 || it->end - it->pos - 2 < it->pos[1]) {
+        return false;
+    }
+    ie->id = it->pos[0];
+    ie->len = it->pos[1];
+    ie->data = it->pos + 2;
+    it->pos += 2 + ie->len;
+    return true;
+}
+
+static inline bool wifi_frame_find_ie(const wifi_frame_t* f, uint8_t id, wifi_ie_t* ie) {
+    wifi_ie_iter_t it;
+    if (!wifi_frame_ies(f, &it)) return false;
+    while (wifi_ie_next(&it, ie)) {
+        if (ie->id == id) return true;
+    }
+    return false;
+}
+
+static inline bool wifi_ie_is_vendor(const wifi_ie_t* ie, const uint8_t oui[3], uint8_t type) {
+    return ie->id == WIFI_IE_VENDOR && ie->len >= 4 &&
+           memcmp(ie->data, oui, 3) == 0 && ie->data[3] == type;
+}
+
+// Copies the SSID as a C string (out holds 33 bytes); returns its length,
+// or -1 if the frame has no valid SSID element
+static inline int wifi_frame_ssid(const wifi_frame_t* f, char* out) {
+    wifi_ie_t ie;
+    if (!wifi_frame_find_ie(f, WIFI_IE_SSID, &ie) || ie.len > 32) {
+        out[0] = '\0';
+        return -1;
+    }
+    memcpy(out, ie.data, ie.len);
+    out[ie.len] = '\0';
+    return ie.len;
+}
+
+// Channel from the DS Parameter Set, 0 if absent
+static inline uint8_t wifi_frame_ds_channel(const wifi_frame_t* f) {
+    wifi_ie_t ie;
+    return wifi_frame_find_ie(f, WIFI_IE_DS_PARAMS, &ie) && ie.len >= 1 ? ie.data[0] : 0;
+}
+
+// True for unprotected data frames whose LLC/SNAP header carries 802.1X
+static inline bool wifi_frame_is_eapol(const wifi_frame_t* f) {
+    static const uint8_t llc_eapol[8] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8E};
+    return f->type == WIFI_FRAME_TYPE_DATA && !(f->flags & WIFI_FC_PROTECTED) &&
+           f->body_len >= sizeof(llc_eapol) && memcmp(f->body, llc_eapol, sizeof(llc_eapol)) == 0;
+}
+
+#endif // WIFI_FRAME_H
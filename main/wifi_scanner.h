@@ -0,0 +1,52 @@
+#ifndef WIFI_SCANNER_H
+#define WIFI_SCANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Non-blocking AP scan. Instead of one driver sweep across every channel,
+// the scanner asks the driver for one channel at a time and chains the next
+// channel from WIFI_EVENT_SCAN_DONE. Each channel's results are merged into
+// the device table as soon as they arrive, so callers can redraw after the
+// first dwell instead of waiting for the whole sweep.
+//
+// The device table keeps APs across sweeps, so features that only need a
+// recent view of the air call wifi_scanner_refresh() with the age they can
+// tolerate and reuse the last sweep when it is young enough.
+
+typedef enum {
+    WIFI_SCAN_PROFILE_ACTIVE,   // probe requests, normal dwell
+    WIFI_SCAN_PROFILE_QUICK,    // probe requests, short dwell
+    WIFI_SCAN_PROFILE_PASSIVE,  // listen for beacons only, nothing transmitted
+    WIFI_SCAN_PROFILE_COUNT
+} wifi_scan_profile_t;
+
+typedef struct {
+    bool running;
+    bool failed;                // the last sweep stopped on a channel the driver refused
+    wifi_scan_profile_t profile;
+    uint8_t channel;            // channel being scanned, 0 when idle
+    uint8_t channels_done;      // of the current or last sweep
+    uint8_t channel_count;
+    uint32_t generation;        // bumped each time a channel's results are merged
+    uint32_t last_update_ms;    // device_table_now_ms() of that merge
+    uint32_t last_sweep_ms;     // when the last full sweep finished, 0 = never
+} wifi_scanner_progress_t;
+
+// Starts a sweep of channels 1..WIFI_SCAN_LAST_CHANNEL; a sweep already in
+// progress is restarted with the new profile. ESP_FAIL if the driver refused
+// the first channel, which also marks the sweep failed.
+esp_err_t wifi_scanner_start(wifi_scan_profile_t profile);
+void wifi_scanner_stop(void);
+bool wifi_scanner_is_running(void);
+void wifi_scanner_get_progress(wifi_scanner_progress_t* progress);
+
+// Blocks until a full sweep no older than max_age_ms has completed: returns
+// at once if the last one qualifies, joins a sweep already in progress, or
+// starts an active one. ESP_ERR_TIMEOUT if no sweep finished in timeout_ms.
+esp_err_t wifi_scanner_refresh(uint32_t max_age_ms, uint32_t timeout_ms);
+
+const char* wifi_scanner_profile_name(wifi_scan_profile_t profile);
+
+#endif // WIFI_SCANNER_H
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Convert a BLE advertisement log (.blec) written by the BLE packet
+capture into CSV. See main/ble_packet_capture.h for the layout.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = b"BLEC"
+HEADER_SIZE = 16
+EVENT_TYPES = ["ADV_IND", "ADV_DIRECT_IND", "ADV_SCAN_IND", "ADV_NONCONN_IND", "SCAN_RSP"]
+ADDR_TYPES = ["public", "random", "rpa_public", "rpa_random"]
+
+
+def read_varint(buf, pos):
+    value = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def records(data):
+    if len(data) < HEADER_SIZE or data[:4] != MAGIC:
+        sys.exit("not a BLE capture log")
+    if data[4] != 1:
+        sys.exit(f"unsupported log version {data[4]}")
+
+    (ts,) = struct.unpack_from("<Q", data, 8)
+    pos = HEADER_SIZE
+    while pos < len(data):
+        length = data[pos]
+        end = pos + 1 + length
+        if length == 0 or end > len(data):
+            print(f"truncated record at offset {pos}", file=sys.stderr)
+            break
+
+        delta, p = read_varint(data, pos + 1)
+        ts += delta
+        addr = data[p:p + 6]
+        info, rssi, adv_len, rsp_len = struct.unpack_from("<BbBB", data, p + 6)
+        p += 10
+        yield ts, addr, info & 0x0F, info >> 4, rssi, data[p:p + adv_len], data[p + adv_len:p + adv_len + rsp_len]
+        pos = end
+
+
+def name(table, value):
+    return table[value] if value < len(table) else str(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", help=".blec file from the SD card")
+    parser.add_argument("output", nargs="?", help="CSV to write (default: stdout)")
+    args = parser.parse_args()
+
+    with open(args.log, "rb") as f:
+        data = f.read()
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(["timestamp_us", "mac_address", "addr_type", "event_type", "rssi",
+                     "adv_data", "scan_rsp"])
+    count = 0
+    for ts, addr, addr_type, evt, rssi, adv, rsp in records(data):
+        writer.writerow([ts, ":".join(f"{b:02X}" for b in addr), name(ADDR_TYPES, addr_type),
+                         name(EVENT_TYPES, evt), rssi, adv.hex().upper(), rsp.hex().upper()])
+        count += 1
+    if args.output:
+        out.close()
+        print(f"{args.output}: {count} records")
+
+
+if __name__ == "__main__":
+    main()
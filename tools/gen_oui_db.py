@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Compile the IEEE MA-L registry (oui.csv) into the packed OUI image
+flashed to the "oui" partition. See main/oui_db.h for the layout.
+
+Download the registry from https://standards-oui.ieee.org/oui/oui.csv
+"""
+
+import argparse
+import csv
+import re
+import struct
+import sys
+
+HEADER_SIZE = 16
+ENTRY_SIZE = 6
+
+
+def clean_name(name, max_len):
+    name = re.sub(r"\s+", " ", name).strip()
+    return name[:max_len].rstrip(" ,.")
+
+
+def build(rows, max_len):
+    vendors = {}
+    for row in rows:
+        assignment = row.get("Assignment", "").strip()
+        if not re.fullmatch(r"[0-9A-Fa-f]{6}", assignment):
+            continue
+        name = clean_name(row.get("Organization Name", ""), max_len)
+        if name:
+            vendors[int(assignment, 16)] = name
+
+    blob = bytearray()
+    offsets = {}
+    entries = bytearray()
+    for oui in sorted(vendors):
+        name = vendors[oui]
+        if name not in offsets:
+            offsets[name] = len(blob)
+            blob += name.encode("utf-8", "replace") + b"\0"
+        entries += oui.to_bytes(3, "big") + offsets[name].to_bytes(3, "little")
+
+    names_off = HEADER_SIZE + len(entries)
+    size = names_off + len(blob)
+    header = b"OUI1" + struct.pack("<III", len(vendors), names_off, size)
+    return header + entries + blob, len(vendors), len(offsets)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("csv", help="IEEE oui.csv")
+    parser.add_argument("output", help="image to write")
+    parser.add_argument("--max-name", type=int, default=24,
+                        help="truncate vendor names to this many characters")
+    parser.add_argument("--max-size", type=lambda s: int(s, 0), default=0xE0000,
+                        help="partition size the image must fit in")
+    args = parser.parse_args()
+
+    with open(args.csv, newline="", encoding="utf-8", errors="replace") as f:
+        image, count, unique = build(csv.DictReader(f), args.max_name)
+
+    if len(image) > args.max_size:
+        sys.exit(f"OUI image is {len(image)} bytes, partition holds {args.max_size}")
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print(f"{args.output}: {count} OUIs, {unique} vendor names, {len(image)} bytes")
+
+
+if __name__ == "__main__":
+    main()